@@ -72,6 +72,7 @@ int CreateNdb(int N, char *DataFile) {
 	}
 
 	Ndb.ID = N;
+	Ndb.pIndex = NULL; //FreeMem() frees the IMAGE_28X28 lookup index
 	strcpy(Ndb.Type, "TEXT");
 	Ndb.pRN = (NdbRN *)malloc(RN_RECORDS * sizeof(NdbRN));
 	Ndb.RNcount = 0;
@@ -400,6 +401,7 @@ int CreateNdbAdditions(int N, char *MinDataFile, char *MaxDataFile, int skip, in
 	}
 
 	Ndb.ID = N;
+	Ndb.pIndex = NULL; //FreeMem() frees the IMAGE_28X28 lookup index
 	strcpy(Ndb.Type, "TEXT");
 	Ndb.pRN = (NdbRN *)malloc(RN_RECORDS * sizeof(NdbRN));
 	Ndb.RNcount = 0;
@@ -923,6 +925,7 @@ int CreateQuestionNdb(int N, char *DataFile) { // Create an Ndb of common questi
 	}
 
 	Ndb.ID = N;
+	Ndb.pIndex = NULL; //FreeMem() frees the IMAGE_28X28 lookup index
 	strcpy(Ndb.Type, "CENTRAL");
 	Ndb.pRN = (NdbRN *)malloc(RN_RECORDS * sizeof(NdbRN));
 	Ndb.RNcount = 0;
@@ -9,27 +9,51 @@ int AddImages();
 int AddImage(MNISTimage *, ImageData *, char *, long, int, int);
 int WriteImageNdb(char *, ImageData *, int);
 int mpCreateImageNdbs();
-int StoreImages(MNISTimage *, ImageData *, char *, long, int, int);
+int ExtractImageFeatures(MNISTimage *, int, ImageFeatures *);
+short *FeatureRL(ImageFeatures *, long, int);
+int StoreImages(ImageFeatures *, int, MNISTimage *, ImageData *, char *);
 void GetImageData(ImageData *, int, int *, NDBimage *, NDBimage *, NDBimage *);
+void GetImageView(ImageData *, int, int *, NDBimage *, NDBimage *, NDBimage *);
+void AddImageRNs(ImageData *, int *);
 void StoreImage(ImageData *, int, int *, char *, char);
 void addImageRNcount(ImageData *);
+void HashImageRNs(ImageData *, int);
+int ImageRNcode(ImageData *, int);
+void AddImageRNcode(ImageData *, int);
+void HashImageONs(ImageData *, long);
+unsigned int HashImageName(char *); //Also called from NdbImageViews.c
+unsigned int HashImageRL(int *);
+long FindImageName(ImageData *, char *);
+long FindImageRL(ImageData *, int *);
+void IndexImageON(ImageData *, long);
+void FreeImageHash(ImageData *);
 void GetSmallPanelImage(int , NDBimage *, NDBimage *);
 void GetLargePanelImage(int , NDBimage *, NDBimage *);
 void ImageFormatter(ImageData *, NDBimage *, int *); //Also called from NdbRecognize.c
 int RNvalue(int *, int);
-void GetImageFromRec(MNISTimage *, long, char *);
-int GetImage(char *, int, NDBimage *, NDBimage *, NDBimage *); //Also called from NdbRecognize.c
-int CheckNeighbors(char, char, int, int, NDBimage *);
+int GetImage(unsigned char *, int, NDBimage *, NDBimage *, NDBimage *); //Also called from NdbRecognize.c
+void GetImageViews(unsigned char *, int, ImageViews *); //Also called from NdbRecognize.c
+int TransformImage(unsigned int *, NDBimage *, NDBimage *, NDBimage *);
+int SpreadBits(unsigned int *, unsigned int *, int, int, int);
+void TransposeBits(unsigned int *, unsigned int *, int);
 void EliminateNoise(NDBimage *);
-int CheckForNoise(int, int, char, NDBimage *);
+unsigned int SurroundedBits(unsigned int *, int);
+void ImageBits(NDBimage *);
+void GetPanelBits(NDBimage *, int, int, NDBimage *); //Also called from NdbRecognize.c
+int BitCount(unsigned int);
+int LowBit(unsigned int);
+int HighBit(unsigned int);
+int FirstBitRow(unsigned int *, int);
+int LastBitRow(unsigned int *, int);
 void GetImageRNs(ImageData *, NDBimage *);
 int FindCavitiesFB(NDBimage *);
-int CavityCount(NDBimage *);
+int CavityCount(NDBimage *, int);
 int Pedestal(NDBimage *);
 int FindInterior(NDBimage *);
 int GetLongestRow(NDBimage *);
 void ImageShape(ImageData *, NDBimage *);
 void GetLongestLine(ImageData *, NDBimage *);
+int LongestLine(NDBimage *, int, int);
 void GetImageWeights(ImageData *, NDBimage *);
 int Curvy(NDBimage *);
 int FindNeighbor(int *, int *, int *, int *, int *, int *, char *, ImageBoundary *, NDBimage *);
@@ -88,12 +112,11 @@ int AddImages(void) {
 	char ndbfile[INQUIRY_LENGTH];
 
 	long NumberOfImages = 10000;
-	char TestImageFile[20] = "mnist_test.txt";
-	char ImageSource[10] = "test"; //part of the image name that's stored in the Ndb
+	char ImageSource[10] = "test"; //part of the image name that's stored in the Ndb, and the MNIST set
 
 	char num[10];
-	MNISTimage *pIMG;	//MNIST images are loaded from the file into this memory
-	int IMGcount;
+	MNISTimage *pIMG;	//MNIST images are loaded from the image store into this memory
+	long IMGcount;
 
 	int RECcount;
 	int *pRecNum;
@@ -104,43 +127,9 @@ int AddImages(void) {
 
 	ShowProgress = 0;
 
-	//Loading MNIST Test images from TestImageFile[];
-	fh_read = fopen(TestImageFile, "r");
-	if (fh_read == NULL) {
-		printf("\nERROR: Failed to OPEN file %s for reading.", TestImageFile);
-		printf("\n");
-		return 1;
-	}
-	pIMG = (MNISTimage *)malloc((NumberOfImages+50) * IMAGE_LENGTH); //a little extra room (+50)
-	IMGcount = 1; //=RecNum: 1, 2, ...
-	while (fgets(line, (IMAGE_LENGTH), fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < IMAGE_LENGTH; i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-
-			//In order to reduce the size of these MNIST image files, all pixels of
-			//value 0 have been removed except for any 0 at the end of a line.
-			//This code puts the 0's back in...
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= NumberOfImages) continue;
-		break;
-	}
-	fclose(fh_read);
-	if (IMGcount == 0) {
-		printf("\nERROR: Failed to find any images in %s", TestImageFile);
-		printf("\nThe line format should be 'digit,pixel,pixel,...'");
-		printf("\n");
-		free(pIMG);
-		return 1;
-	}
+	//Loading the MNIST Test images
+	pIMG = LoadMNIST(ImageSource, NumberOfImages, &IMGcount);
+	if (pIMG == NULL) return 1;
 
 	//Loading the Record Numbers of the images to be added from DataFile
 	fh_read = fopen(MNISTerrors, "r");
@@ -169,7 +158,7 @@ int AddImages(void) {
 				}
 				if (i > 0) {
 					RecNum = atol(num);
-					if (RecNum > 0) { //just in case
+					if ((RecNum > 0) && (RecNum <= IMGcount)) { //just in case
 						RECcount++;
 						if ((RECcount % 256) == 0) { // The list is full, get more memory...
 							RECblocks++;
@@ -284,6 +273,7 @@ int AddImages(void) {
 			sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, Ndb.ID);
 			printf("\n\nERROR: Failed to load Ndb #%d from the database sub-directory: %s", Ndb.ID, ndbfile);
 			for (j = 0; j < i; j++) {
+				FreeImageHash(&(mp[j].pIdata));
 				free(mp[j].pIdata.pImageRN);
 				free(mp[j].pIdata.pON);
 				free(mp[j].pIdata.pRNtoON);
@@ -326,6 +316,10 @@ int AddImages(void) {
 			mp[i].pIdata.pRNtoON[j].ONcode = Ndb.pRNtoON[j].ONcode;
 		}
 		FreeMem(&Ndb);
+
+		//Index the RNs and ONs, leaving room for the new ONs
+		HashImageRNs(&(mp[i].pIdata), IMAGE_RN_HASH);
+		HashImageONs(&(mp[i].pIdata), Ndb.ONcount + RECcount);
 	}
 
 	T = clock() - T;
@@ -379,6 +373,7 @@ int AddImages(void) {
 	}
 
 	for (i = 0; i < MPcount; i++) {
+		FreeImageHash(&(mp[i].pIdata));
 		free(mp[i].pIdata.pImageRN);
 		free(mp[i].pIdata.pON);
 		free(mp[i].pIdata.pRNtoON);
@@ -402,7 +397,6 @@ int AddImage(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long RecNum
 	NDBimage ROW;
 	NDBimage COL;
 	NDBimage DIAG;
-	char ImageString[IMAGE_LENGTH];
 	int res;
 	int i;
 	char ImageName[32];
@@ -410,9 +404,8 @@ int AddImage(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long RecNum
 	char digit;
 
 	pIdata->RecNum = RecNum;
-	pIdata->digit = pIMG[RecNum].image[0];
-	GetImageFromRec(pIMG, RecNum, ImageString);
-	res = GetImage(ImageString, contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
+	pIdata->digit = pIMG[RecNum].digit;
+	res = GetImage(pIMG[RecNum].pixel, contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
 	if (res == 1) {
 		//Bad image (there aren't any unless the file has been corrupted)
 		return 1;
@@ -421,7 +414,7 @@ int AddImage(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long RecNum
 	for (i = 0; i < 32; i++) ImageName[i] = 0;
 	sprintf(ImageName, "Image^%s^%d", ImageSource, RecNum); //i.e "Image:test:12345"
 
-	digit = pIMG[RecNum].image[0]; //The "label" assigned to this image, i.e. 0, 1, ..., 9
+	digit = pIMG[RecNum].digit; //The "label" assigned to this image, i.e. 0, 1, ..., 9
 	StoreImage(pIdata, N, ImageRN, ImageName, digit);
 
 	return 0;
@@ -544,6 +537,11 @@ int mpCreateImageNdbs(void) {
 	//	then made into each of the Ndbs by the appropriate set of RNs. Whichever digit appears
 	//	in the majority of the results is the Ndb's recognition of the image.
 	//
+	//	The Ndbs are built one contrast at a time. ExtractImageFeatures() first runs through
+	//	the training images once, converting each image at this contrast and generating the
+	//	RNs of all 57 of its views into a feature matrix. The builders, StoreImages(), then
+	//	work only from that matrix, so no image is converted more than once per contrast.
+	//
 	//----------
 
 	typedef struct {
@@ -551,22 +549,20 @@ int mpCreateImageNdbs(void) {
 		int contrast;
 	} MP; //multithreading list of databases to create
 
-	MP mp[399];
+	MP mp[IMAGE_VIEWS];
 	int MPcount;
-	FILE *fh_read;
-	char line[IMAGE_LENGTH];
 	int N;
 	int contrast;
+	int Contrast[IMAGE_CONTRASTS];
+	int ContrastCount;
 	int i, j;
 	int WriteError;
+	ImageFeatures Features;
 
 	long NumberOfImages = 60000;
-	char DataFile1[20] = "mnist_train_1.txt";
-	char DataFile2[20] = "mnist_train_2.txt";
-	char DataFile3[20] = "mnist_train_3.txt";
-	char ImageSource[10] = "train"; //part of image name that is stored in the Ndb
+	char ImageSource[10] = "train"; //part of image name that is stored in the Ndb, and the MNIST set
 
-	MNISTimage *pIMG;	//MNIST images are loaded from the 3 files into this memory
+	MNISTimage *pIMG;	//MNIST images are loaded from the image store into this memory
 	long IMGcount;
 
 	clock_t T;
@@ -577,97 +573,17 @@ int mpCreateImageNdbs(void) {
 
 	WriteError = 0;
 
-	printf("\nCreating MNIST image Ndb's #2000 through #2569 from %s, etc...", DataFile1);
+	printf("\nCreating MNIST image Ndb's #2000 through #2569 from the MNIST %s images...", ImageSource);
 
 	// Begin by reading all the images into memory...
 	T = clock();
 
-	pIMG = (MNISTimage *)malloc((NumberOfImages+50) * IMAGE_LENGTH); //a little extra room (+50)
-	IMGcount = 1; //RecNum: 1, 2, ...
-
-	fh_read = fopen(DataFile1, "r");
-	if (fh_read == NULL) {
-		printf("Error opening file %s for reading.\n", DataFile1);
-		return 1;
-	}
-	while (fgets(line, (IMAGE_LENGTH), fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < IMAGE_LENGTH; i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-
-			//In order to reduce the size of these MNIST image files, all pixels of
-			//value 0 have been removed except for any 0 at the end of a line.
-			//This code puts the 0's back in...
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= 20000) continue;
-		break;
-	}
-	fclose(fh_read);
-
-	fh_read = fopen(DataFile2, "r");
-	if (fh_read == NULL) {
-		printf("Error opening file %s for reading.\n", DataFile2);
-		return 1;
-	}
-	while (fgets(line, (IMAGE_LENGTH), fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < IMAGE_LENGTH; i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= 40000) continue;
-		break;
-	}
-	fclose(fh_read);
-
-	fh_read = fopen(DataFile3, "r");
-	if (fh_read == NULL) {
-		printf("Error opening file %s for reading.\n", DataFile3);
-		return 1;
-	}
-	while (fgets(line, (IMAGE_LENGTH), fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < IMAGE_LENGTH; i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= NumberOfImages) continue;
-		break;
-	}
-	fclose(fh_read);
-
-	if (IMGcount == 0) {
-		printf("Error: failed to find any images in %s, etc\n", DataFile1);
-		printf("The line format should be 'digit,pixel,pixel,...'\n");
-		free(pIMG);
-		return 1;
-	}
+	pIMG = LoadMNIST(ImageSource, NumberOfImages, &IMGcount);
+	if (pIMG == NULL) return 1;
 
 	T = clock() - T;
 	runtime = ((double)T) / CLOCKS_PER_SEC;
-	printf("\nCopied %d images into memory in %fsec", (IMGcount-1), runtime);
+	printf("\nCopied %ld images into memory in %fsec", IMGcount, runtime);
 
 	printf("\nLoading images into the databases...");
 
@@ -756,35 +672,64 @@ int mpCreateImageNdbs(void) {
 		MPcount++;
 	}
 
-	//Request ActualThreads from the OS. You may or may not be given this many.
-	omp_set_num_threads(ActualThreads);
-	#pragma omp parallel
-	{
-		//Each thread has its own N, etc.
-		int N;
-		int contrast;
-		double time;
-		int res;
-		int ThreadID;
-		ImageData pIdata; //Image data unique to this thread
+	//The distinct contrasts...
+	ContrastCount = 0;
+	for (i = 0; i < MPcount; i++) {
+		for (j = 0; j < ContrastCount; j++) {
+			if (Contrast[j] == mp[i].contrast) break;
+		}
+		if (j < ContrastCount) continue;
+		Contrast[ContrastCount] = mp[i].contrast;
+		ContrastCount++;
+	}
 
-		ThreadID = omp_get_thread_num(); //0, 1, 2, ...
+	for (j = 0; j < ContrastCount; j++) {
+		contrast = Contrast[j];
 
-		//OMP will split this for-loop up among the threads, each thread will have its own i
-		#pragma omp for
+		//All the views at this contrast
+		Features.Views = 0;
 		for (i = 0; i < MPcount; i++) {
-			N = mp[i].N;
-			contrast = mp[i].contrast;
+			if (mp[i].contrast != contrast) continue;
+			Features.N[Features.Views] = mp[i].N;
+			Features.Views++;
+		}
+		Features.Images = IMGcount;
+		Features.pRN = (short *)malloc(IMGcount * Features.Views * NUMBER_OF_IMAGE_RNS * sizeof(short));
+		if (Features.pRN == NULL) {
+			printf("\nERROR: not enough memory for the feature matrix of %ld images", IMGcount);
+			free(pIMG);
+			return 1;
+		}
 
-			time = omp_get_wtime(); //the start time
+		ExtractImageFeatures(pIMG, contrast, &Features);
 
-			res = StoreImages(pIMG, &pIdata, ImageSource, NumberOfImages, N, contrast);
-			if (res != 0) WriteError = 1; //WriteError is shared - just to warn of a WriteError no matter who got it
+		//Request ActualThreads from the OS. You may or may not be given this many.
+		omp_set_num_threads(ActualThreads);
+		#pragma omp parallel
+		{
+			//Each thread has its own N, etc.
+			double time;
+			int res;
+			int ThreadID;
+			ImageData pIdata; //Image data unique to this thread
 
-			time = omp_get_wtime() - time; //runtime
+			ThreadID = omp_get_thread_num(); //0, 1, 2, ...
 
-			if (ShowProgress == 1) printf("\n  mpCreateImageNdbs(): ThreadID=%d loaded Ndb #%d in %fsec.", ThreadID, N, time);
+			//OMP will split this for-loop up among the threads, each thread will have its own i
+			#pragma omp for
+			for (i = 0; i < Features.Views; i++) {
+				time = omp_get_wtime(); //the start time
+
+				res = StoreImages(&Features, i, pIMG, &pIdata, ImageSource);
+				if (res != 0) WriteError = 1; //WriteError is shared - just to warn of a WriteError no matter who got it
+
+				time = omp_get_wtime() - time; //runtime
+
+				if (ShowProgress == 1) printf("\n  mpCreateImageNdbs(): ThreadID=%d loaded Ndb #%d in %fsec.", ThreadID, Features.N[i], time);
+			}
 		}
+
+		free(Features.pRN);
 	}
 
 	T = clock() - T;
@@ -798,7 +743,75 @@ int mpCreateImageNdbs(void) {
 	return 0;
 }
 
-int StoreImages(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long NumberOfImages, int N, int contrast) {
+int ExtractImageFeatures(MNISTimage *pIMG, int contrast, ImageFeatures *pF) {
+	//
+	//	Fill in the feature matrix pF->pRN[]: the Recognition List of each of the pF->Views
+	//	views of every image, all at this 'contrast'.
+	//
+	//	Each image is converted by GetImage() only once, and each of its views is run
+	//	through ImageFormatter() only once, no matter how many passes the builders make.
+	//
+	//	The RNs are stored as shorts: ImageFormatter() never produces one over 1099.
+	//	A bad image has a Recognition List of zeros.
+	//
+	//----------
+
+	long RecNum;
+	clock_t T;
+	double runtime;
+
+	T = clock();
+
+	//Request ActualThreads from the OS. You may or may not be given this many.
+	omp_set_num_threads(ActualThreads);
+	#pragma omp parallel
+	{
+		//Each thread has its own image, etc.
+		NDBimage ROW;
+		NDBimage COL;
+		NDBimage DIAG;
+		ImageData Idata; //Scratch memory for ImageFormatter()
+		int ImageRN[NUMBER_OF_IMAGE_RNS+4]; //some extra room
+		short *pRL;
+		int res;
+		int v, k;
+
+		//OMP will split this for-loop up among the threads, each thread will have its own RecNum
+		#pragma omp for
+		for (RecNum = 1; RecNum <= pF->Images; RecNum++) {
+			res = GetImage(pIMG[RecNum].pixel, contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
+			for (v = 0; v < pF->Views; v++) {
+				pRL = FeatureRL(pF, RecNum, v);
+				if (res == 1) {
+					//Bad image (there aren't any bad MNIST images, unless the file has been corrupted)
+					for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) pRL[k] = 0;
+					continue;
+				}
+				GetImageView(&Idata, pF->N[v], ImageRN, &ROW, &COL, &DIAG); //Fills in the Recognition List: ImageRN[]
+				for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) pRL[k] = (short)ImageRN[k+1];
+			}
+		}
+	}
+
+	T = clock() - T;
+	runtime = ((double)T) / CLOCKS_PER_SEC;
+	if (ShowProgress == 1) printf("\n  ExtractImageFeatures(): %d views of %ld images at contrast %d in %fsec.", pF->Views, pF->Images, contrast, runtime);
+
+	return 0;
+}
+
+short *FeatureRL(ImageFeatures *pF, long RecNum, int view) {
+	//
+	//	The Recognition List of this view of image RecNum in the feature matrix
+	//
+	//----------
+
+	return pF->pRN + (((RecNum - 1) * pF->Views) + view) * NUMBER_OF_IMAGE_RNS;
+}
+
+int StoreImages(ImageFeatures *pF, int view, MNISTimage *pIMG, ImageData *pIdata, char *ImageSource) {
+	//
+	//	Build Ndb #N from the Recognition Lists of this 'view' in the feature matrix
 	//
 	//	ImageSource = "train", i.e. MNIST training images
 	//
@@ -808,16 +821,14 @@ int StoreImages(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long Num
 	//
 	//----------
 
-	NDBimage ROW;
-	NDBimage COL;
-	NDBimage DIAG;
 	long RecNum;
-	char ImageString[IMAGE_LENGTH];
-	int res;
+	long MaxONs;
+	int N;
 	int i, j;
 	int maxlen;
 	char ImageName[32];
 	int ImageRN[NUMBER_OF_IMAGE_RNS+4]; //some extra room
+	short *pRL;
 	char digit;
 	FILE *fh_write;
 	char ndbfile[INQUIRY_LENGTH];
@@ -828,6 +839,8 @@ int StoreImages(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long Num
 	//There will be an RNcode created for each...
 	pIdata->pImageRN = (NdbImageRN *)malloc(IMAGE_RN_RECORDS * sizeof(NdbImageRN));
 	pIdata->ImageRNblocks = 1;
+	pIdata->RNcount = 0;
+	HashImageRNs(pIdata, IMAGE_RN_HASH);
 
 	// Run through the images in pIMG[] to get counts of the various components...
 	//		1st time through get the counts of the number of records needed
@@ -837,17 +850,14 @@ int StoreImages(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long Num
 	pIdata->RNcount = 0;
 	pIdata->ONcount = 0;
 
+	N = pF->N[view];
+	for (i = 0; i <= (NUMBER_OF_IMAGE_RNS+1); i++) ImageRN[i] = 0;
 
-	for (RecNum = 1; RecNum <= NumberOfImages; RecNum++) {
-		pIdata->RecNum = RecNum;
-		pIdata->digit = pIMG[RecNum].image[0];
-		GetImageFromRec(pIMG, RecNum, ImageString);
-		res = GetImage(ImageString, contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
-		if (res == 1) {
-			//Bad image (there aren't any bad MNIST images, unless the file has been corrupted)
-			continue;
-		}
-		GetImageData(pIdata, N, ImageRN, &ROW, &COL, &DIAG); //Fills in the Recognition List: ImageRN[]
+	for (RecNum = 1; RecNum <= pF->Images; RecNum++) {
+		pRL = FeatureRL(pF, RecNum, view);
+		if (pRL[0] == 0) continue; //Bad image
+		for (i = 0; i < NUMBER_OF_IMAGE_RNS; i++) ImageRN[i+1] = pRL[i];
+		AddImageRNs(pIdata, ImageRN);
 		pIdata->ONcount++;
 	}
 
@@ -860,28 +870,29 @@ int StoreImages(MNISTimage *pIMG, ImageData *pIdata, char *ImageSource, long Num
 	maxlen = NUMBER_OF_IMAGE_RNS;
 	pIdata->pRNtoON = (NdbRNtoON *)malloc((pIdata->RNcount+1) * (maxlen+1) * (pIdata->ONcount+1) * sizeof(NdbRNtoON));
 
+	MaxONs = pIdata->ONcount;
 	pIdata->ONcount = 0;
+	HashImageONs(pIdata, MaxONs);
 	pIdata->ConnectCount = 0;
 
 	// Run through the images again, loading data into the memory-resident Ndb...
-	for (RecNum = 1; RecNum <= NumberOfImages; RecNum++) {
-		pIdata->RecNum = RecNum;
-		pIdata->digit = pIMG[RecNum].image[0];
-		GetImageFromRec(pIMG, RecNum, ImageString);
-		res = GetImage(ImageString, contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
-		if (res == 1) continue; //Bad image
-			
-		GetImageData(pIdata, N, ImageRN, &ROW, &COL, &DIAG); //Fills in the Recognition List: ImageRN[]
+	for (RecNum = 1; RecNum <= pF->Images; RecNum++) {
+		pRL = FeatureRL(pF, RecNum, view);
+		if (pRL[0] == 0) continue; //Bad image
+		for (i = 0; i < NUMBER_OF_IMAGE_RNS; i++) ImageRN[i+1] = pRL[i];
+
 		for (i = 0; i < 32; i++) ImageName[i] = 0;
 		sprintf(ImageName, "Image^%s^%d", ImageSource, RecNum); //i.e "Image:train:12345"
 
-		digit = pIMG[RecNum].image[0]; //The "label" assigned to this image: 0, 1, ..., 9
+		digit = pIMG[RecNum].digit; //The "label" assigned to this image: 0, 1, ..., 9
 
 		StoreImage(pIdata, N, ImageRN, ImageName, digit);
 	}
 
+	FreeImageHash(pIdata);
+
 	// Write the data into file 'N'.ndb
-	res = _mkdir(SubDirectoryNdbs); //create this subdirectory if it doesn't already exist
+	_mkdir(SubDirectoryNdbs); //create this subdirectory if it doesn't already exist
 	sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, N);
 
 	fh_write = fopen(ndbfile, "w");
@@ -972,12 +983,20 @@ void GetImageData(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimag
 	//
 	//----------
 
+	GetImageView(pIdata, N, ImageRN, ROW, COL, DIAG);
+	AddImageRNs(pIdata, ImageRN);
+}
+
+void GetImageView(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimage *COL, NDBimage *DIAG) {
+	//
+	//	Copy the view of the image for Ndb #N into A[r][c] and generate its
+	//	Recognition List: ImageRN[]
+	//
+	//----------
+
 	int r, c;
 	int panel;
-	int rn;
 	NDBimage A;
-	int fnd;
-	int RNcode;
 
 	A.ImageSize = 28;
 	for (r = 1; r <= 28; r++) {
@@ -992,6 +1011,7 @@ void GetImageData(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimag
 			for (r = 1; r <= 28; r++) {
 				for (c = 1; c <= 28; c++) A.image[r][c] = ROW->image[r][c];
 			}
+			GetPanelBits(ROW, 1, 1, &A);
 		} else {
 			GetSmallPanelImage(panel, ROW, &A);
 		}
@@ -1005,6 +1025,7 @@ void GetImageData(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimag
 					for (r = 1; r <= 28; r++) {
 						for (c = 1; c <= 28; c++) A.image[r][c] = COL->image[r][c];
 					}
+					GetPanelBits(COL, 1, 1, &A);
 				} else {
 					GetSmallPanelImage(panel, COL, &A);
 				}
@@ -1018,6 +1039,7 @@ void GetImageData(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimag
 							for (r = 1; r <= 28; r++) {
 								for (c = 1; c <= 28; c++) A.image[r][c] = DIAG->image[r][c];
 							}
+							GetPanelBits(DIAG, 1, 1, &A);
 						} else {
 							GetSmallPanelImage(panel, DIAG, &A);
 						}
@@ -1032,22 +1054,28 @@ void GetImageData(ImageData *pIdata, int N, int *ImageRN, NDBimage *ROW, NDBimag
 	}
 
 	ImageFormatter(pIdata, &A, ImageRN); //Get the Recognition List of RNs: ImageRN[]
+}
+
+void AddImageRNs(ImageData *pIdata, int *ImageRN) {
+	//
+	//	Add any new rn values in ImageRN[] to the Ndb's list of RNcodes
+	//
+	//----------
+
+	int r;
+	int rn;
+	int RNcode;
 
 	//Continue building the list of RNcodes for all these images...
 	for (r = 1; r <= NUMBER_OF_IMAGE_RNS; r++) {
 		rn = ImageRN[r];
 		if (rn == 0) break;
 		//Is this rn already known?
-		fnd = 0;
-		for (RNcode = 1; RNcode <= pIdata->RNcount; RNcode++) {
-			if (pIdata->pImageRN[RNcode].RN != rn) continue;
-			fnd = 1;
-			break;
-		}
-		if (fnd == 0) {
+		if (ImageRNcode(pIdata, rn) == 0) {
 			addImageRNcount(pIdata); //1, 2, ...
 			RNcode = pIdata->RNcount;
 			pIdata->pImageRN[RNcode].RN = rn;//always numeric for images
+			AddImageRNcode(pIdata, RNcode);
 		}
 	}
 }
@@ -1056,48 +1084,24 @@ void StoreImage(ImageData *pIdata, int N, int *ImageRN, char *ImageName, char di
 	//
 	//	Store the image recognition data in a memory-resident copy of the Ndb
 	//
+	//	The ONs are found by image name and by Recognition List through the hash
+	//	chains built by HashImageONs(), and the RNcodes through ImageRNcode().
+	//
 	//----------
 
-	int i, j, k;
-	int len1, len2;
-	int fnd;
-	int rn;
-	int RNcode;
+	long i;
+	int k;
+	int RL[NUMBER_OF_IMAGE_RNS+1];
 
 	// Does this image already exist in the database?
-	fnd = 0;
-	for (i = 0; i < pIdata->ONcount ;i++) {
-		if (strcmp(pIdata->pON[i].ON, ImageName) != 0) continue;
-		fnd = 1;
-		break;
-	}
-	if (fnd == 1) return;
+	if (FindImageName(pIdata, ImageName) >= 0) return;
+
+	//The Recognition List as RNcodes: 0 for an rn that isn't known (should never happen)
+	for (k = 1; k <= NUMBER_OF_IMAGE_RNS; k++) RL[k] = ImageRNcode(pIdata, ImageRN[k]);
 
 	//Does this Recognition List already exist?
-	fnd = 0; //assume NO
-	for (i = 0; i < pIdata->ONcount ;i++) {
-
-		len1 = NUMBER_OF_IMAGE_RNS;
-		len2 = 0; //count of the number of identical RNs (in a row)
-		for (k = 0; k < len1; k++) {
-			rn = ImageRN[k+1];
-			//What is the RNcode for this rn value?
-			RNcode = 0;
-			for (j = 1; j <= pIdata->RNcount; j++) {
-				if (pIdata->pImageRN[j].RN != rn) continue;
-				RNcode = j;
-				break;
-			}
-			if (RNcode == 0) break; //Should never happen
-			if (pIdata->pON[i].RL[k+1] != RNcode) break;
-			len2++;
-		}
-		if (len2 == len1) {
-			fnd = 1;
-			break;
-		}
-	}
-	if (fnd == 1) {
+	i = FindImageRL(pIdata, RL);
+	if (i >= 0) {
 		//Found the same Recognition List in ONcode, [i];
 		//Add this digit to the end of that ON's list of Surrogates,
 		//if it's not already there...
@@ -1118,33 +1122,26 @@ void StoreImage(ImageData *pIdata, int N, int *ImageRN, char *ImageName, char di
 		pIdata->pON[pIdata->ONcount].SUR[k] = 0;
 	}
 
-	for (i = 1; i <= NUMBER_OF_IMAGE_RNS; i++) {
-		rn = ImageRN[i];
-		if (rn == 0) break;
-		//What is the RNcode for this rn?
-		RNcode = 0;
-		for (k = 1; k <= pIdata->RNcount; k++) {
-			if (pIdata->pImageRN[k].RN != rn) continue;
-			RNcode = k;
-			break;
-		}
+	for (k = 1; k <= NUMBER_OF_IMAGE_RNS; k++) {
+		if (ImageRN[k] == 0) break;
 
-		//NOTE: RNcode should NEVER be zero
+		//NOTE: RL[k] should NEVER be zero
 
 		// Load the connections between RNs and ONs...
-		pIdata->pRNtoON[pIdata->ConnectCount].RNcode = RNcode;
-		pIdata->pRNtoON[pIdata->ConnectCount].Pos = i;
+		pIdata->pRNtoON[pIdata->ConnectCount].RNcode = RL[k];
+		pIdata->pRNtoON[pIdata->ConnectCount].Pos = k;
 		pIdata->pRNtoON[pIdata->ConnectCount].ONcode = pIdata->ONcount + 1;
 		pIdata->ConnectCount++;
 
 		//This Image/ON's Recognition List of RNcodes
-		pIdata->pON[pIdata->ONcount].RL[i] = RNcode;
+		pIdata->pON[pIdata->ONcount].RL[k] = RL[k];
 	}
 
 	pIdata->pON[pIdata->ONcount].Len = NUMBER_OF_IMAGE_RNS;
 	strcpy(pIdata->pON[pIdata->ONcount].ON, ImageName);
 	pIdata->pON[pIdata->ONcount].ACT[0] = 0; //None of these images trigger an Action
 	pIdata->pON[pIdata->ONcount].SUR[0] = digit;
+	IndexImageON(pIdata, pIdata->ONcount);
 	pIdata->ONcount++;
 }
 
@@ -1162,6 +1159,198 @@ void addImageRNcount(ImageData *pIdata) {
 	}
 }
 
+void HashImageRNs(ImageData *pIdata, int size) {
+	//
+	//	(Re)build the hash table of RNcodes, by RN value, for RNcodes 1 - RNcount
+	//
+	//	size must be a power of 2. It's doubled until the table is no more than half full.
+	//
+	//----------
+
+	int RNcode;
+
+	while ((pIdata->RNcount * 2) >= size) size *= 2;
+
+	pIdata->RNhashSize = size;
+	pIdata->pRNhash = (int *)calloc(size, sizeof(int));
+
+	for (RNcode = 1; RNcode <= pIdata->RNcount; RNcode++) AddImageRNcode(pIdata, RNcode);
+}
+
+int ImageRNcode(ImageData *pIdata, int rn) {
+	//
+	//	Return the RNcode of this rn value, or 0 if it isn't known
+	//
+	//----------
+
+	unsigned int h;
+	int RNcode;
+
+	h = (unsigned int)rn * 2654435761u;
+	h = (h ^ (h >> 16)) & (pIdata->RNhashSize - 1);
+
+	while ((RNcode = pIdata->pRNhash[h]) != 0) {
+		if (pIdata->pImageRN[RNcode].RN == rn) return RNcode;
+		h = (h + 1) & (pIdata->RNhashSize - 1);
+	}
+
+	return 0;
+}
+
+void AddImageRNcode(ImageData *pIdata, int RNcode) {
+	//
+	//	Add this RNcode, whose RN value is already in pImageRN[], to the hash table
+	//
+	//----------
+
+	unsigned int h;
+
+	if ((pIdata->RNcount * 2) >= pIdata->RNhashSize) {
+		//Half full: start over with a table twice the size, which also adds this RNcode
+		free(pIdata->pRNhash);
+		HashImageRNs(pIdata, pIdata->RNhashSize * 2);
+		return;
+	}
+
+	h = (unsigned int)pIdata->pImageRN[RNcode].RN * 2654435761u;
+	h = (h ^ (h >> 16)) & (pIdata->RNhashSize - 1);
+
+	while (pIdata->pRNhash[h] != 0) h = (h + 1) & (pIdata->RNhashSize - 1);
+
+	pIdata->pRNhash[h] = RNcode;
+}
+
+void HashImageONs(ImageData *pIdata, long MaxONs) {
+	//
+	//	Build the hash chains of ONs, by image name and by Recognition List, with room
+	//	for MaxONs ONs. The ONs already in pON[] are added to them.
+	//
+	//----------
+
+	long i;
+
+	pIdata->ONhashSize = 256;
+	while (pIdata->ONhashSize < (MaxONs * 2)) pIdata->ONhashSize *= 2;
+
+	pIdata->pNameHash = (long *)calloc(pIdata->ONhashSize, sizeof(long));
+	pIdata->pListHash = (long *)calloc(pIdata->ONhashSize, sizeof(long));
+	pIdata->pNameNext = (long *)calloc(MaxONs + 1, sizeof(long));
+	pIdata->pListNext = (long *)calloc(MaxONs + 1, sizeof(long));
+
+	for (i = 0; i < pIdata->ONcount; i++) IndexImageON(pIdata, i);
+}
+
+unsigned int HashImageName(char *ImageName) {
+	//
+	//	FNV-1a hash of an image name
+	//
+	//----------
+
+	unsigned int h;
+
+	h = 2166136261u;
+	while (*ImageName != 0) {
+		h ^= (unsigned char)*ImageName;
+		h *= 16777619u;
+		ImageName++;
+	}
+
+	return h;
+}
+
+unsigned int HashImageRL(int *RL) {
+	//
+	//	FNV-1a hash of a Recognition List of RNcodes: RL[1] - RL[NUMBER_OF_IMAGE_RNS]
+	//
+	//----------
+
+	unsigned int h;
+	int k;
+
+	h = 2166136261u;
+	for (k = 1; k <= NUMBER_OF_IMAGE_RNS; k++) {
+		h ^= (unsigned int)RL[k];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+long FindImageName(ImageData *pIdata, char *ImageName) {
+	//
+	//	Return the index in pON[] of the ON with this image name, or -1
+	//
+	//----------
+
+	long i;
+
+	i = pIdata->pNameHash[HashImageName(ImageName) & (pIdata->ONhashSize - 1)];
+	while (i != 0) {
+		if (strcmp(pIdata->pON[i-1].ON, ImageName) == 0) return (i - 1);
+		i = pIdata->pNameNext[i];
+	}
+
+	return -1;
+}
+
+long FindImageRL(ImageData *pIdata, int *RL) {
+	//
+	//	Return the index in pON[] of the first ON with this Recognition List of
+	//	RNcodes, or -1. A list with an unknown RN (RNcode 0) never matches.
+	//
+	//----------
+
+	long i;
+	long fnd;
+	int k;
+
+	for (k = 1; k <= NUMBER_OF_IMAGE_RNS; k++) {
+		if (RL[k] == 0) return -1;
+	}
+
+	fnd = -1;
+	i = pIdata->pListHash[HashImageRL(RL) & (pIdata->ONhashSize - 1)];
+	while (i != 0) {
+		for (k = 1; k <= NUMBER_OF_IMAGE_RNS; k++) {
+			if (pIdata->pON[i-1].RL[k] != RL[k]) break;
+		}
+		if ((k > NUMBER_OF_IMAGE_RNS) && ((fnd < 0) || ((i - 1) < fnd))) fnd = i - 1;
+		i = pIdata->pListNext[i];
+	}
+
+	return fnd;
+}
+
+void IndexImageON(ImageData *pIdata, long i) {
+	//
+	//	Add pON[i] to the front of its name and Recognition List hash chains
+	//
+	//----------
+
+	unsigned int h;
+
+	h = HashImageName(pIdata->pON[i].ON) & (pIdata->ONhashSize - 1);
+	pIdata->pNameNext[i+1] = pIdata->pNameHash[h];
+	pIdata->pNameHash[h] = i + 1;
+
+	h = HashImageRL(pIdata->pON[i].RL) & (pIdata->ONhashSize - 1);
+	pIdata->pListNext[i+1] = pIdata->pListHash[h];
+	pIdata->pListHash[h] = i + 1;
+}
+
+void FreeImageHash(ImageData *pIdata) {
+	//
+	//	Free the RN hash table and the ON hash chains
+	//
+	//----------
+
+	free(pIdata->pRNhash);
+	free(pIdata->pNameHash);
+	free(pIdata->pNameNext);
+	free(pIdata->pListHash);
+	free(pIdata->pListNext);
+}
+
 void GetSmallPanelImage(int panel, NDBimage *FROM, NDBimage *TO) {
 	//
 	//	Split the 28x28 MNIST image up into 9 overlapping panels, each 16x16
@@ -1226,7 +1415,11 @@ void GetSmallPanelImage(int panel, NDBimage *FROM, NDBimage *TO) {
 			for (r = 13; r <= 28; r++) {
 				for (c = 13; c <= 28; c++) TO->image[r-12][c-12] = FROM->image[r][c];
 			}
+			panel = 9;
 	}
+
+	//The panels start at rows and columns 1, 7, 13
+	GetPanelBits(FROM, 1 + (((panel - 1) % 3) * 6), 1 + (((panel - 1) / 3) * 6), TO);
 }
 
 void GetLargePanelImage(int panel, NDBimage *FROM, NDBimage *TO) {
@@ -1293,7 +1486,11 @@ void GetLargePanelImage(int panel, NDBimage *FROM, NDBimage *TO) {
 			for (r = 11; r <= 28; r++) {
 				for (c = 11; c <= 28; c++) TO->image[r-10][c-10] = FROM->image[r][c];
 			}
+			panel = 9;
 	}
+
+	//The panels start at rows and columns 1, 6, 11
+	GetPanelBits(FROM, 1 + (((panel - 1) % 3) * 5), 1 + (((panel - 1) / 3) * 5), TO);
 }
 
 void ImageFormatter(ImageData *pIdata, NDBimage *IMG, int *ImageRN) { //Also called from NdbRecognize.c
@@ -1380,42 +1577,12 @@ int RNvalue(int *offset, int v) {
 	return v;
 }
 
-void GetImageFromRec(MNISTimage *pIMG, long RecNum, char *ImageString) {
+int GetImage(unsigned char *pixel, int CONTRAST, NDBimage *ROW, NDBimage *COL, NDBimage *DIAG) {
 	//
-	//	From the Record Number, get the Image String of 28x28 = 784 characters
+	//	Convert the image from its MNIST_PIXELS pixel values, 0 to 255, row by row:
 	//
-	//		pIMG[RecNum].image[0] = The Digit
-	//		pIMG[RecNum].image[1] = ','
-	//		pIMG[RecNum].image[2] = 1st pixel value
-	//		pIMG[RecNum].image[3] = ','
-	//		pIMG[RecNum].image[4] = 2nd pixel value
-	//		pIMG[RecNum].image[5] = ','
-	//			etc.
-	//
-	//----------
-
-	int p, i;
-	char ch;
-
-	for (i = 0; i < IMAGE_LENGTH; i++) ImageString[i] = 0;
-
-	p = 2; //start reading the image string from here
-	for (i = 0; i < IMAGE_LENGTH; i++) {
-		ch = pIMG[RecNum].image[p];
-		if ((ch == 0) || (ch == 10)) break;
-		ImageString[i] = ch;
-		p++;
-	}
-}
-
-int GetImage(char *ImageString, int CONTRAST, NDBimage *ROW, NDBimage *COL, NDBimage *DIAG) {
-	//
-	//	Convert the image from a string of text:
-	//
-	//		ImageString[0] = 1st pixel value
-	//		ImageString[1] = ','
-	//		ImageString[2] = 2nd pixel value
-	//		ImageString[3] = ','
+	//		pixel[0] = 1st pixel value
+	//		pixel[1] = 2nd pixel value
 	//			etc.
 	//
 	//	into 28x28 arrays in these 3 perspectives:
@@ -1430,157 +1597,158 @@ int GetImage(char *ImageString, int CONTRAST, NDBimage *ROW, NDBimage *COL, NDBi
 	//		3) "n" is a non-zero pixel
 	//		4) "+" is a fully enclosed pixel of value zero
 	//
+	//	The interior spaces are found on bitboards, one row mask per row with bit c for
+	//	column c: n[] for the "n"s, B[] for the boundary markers "B", E[] for the
+	//	exterior boundaries "E", and P[] and S[] for the "+"s and " "s.
+	//
+	//	Returns:	1 if it's a bad image (nothing left), otherwise 0
+	//
 	//----------
 
-	char ch;
-	char x[4]; //the pixel in characters: 0 to 255 with room for a terminating 0
 	int px;
-	int p, i;
+	int p;
 	int r, c;
-	int fnd;
-	int FirstRow, LastRow;
-	int startc, startr;
-	int row[MAX_IMAGE_SIZE+1][MAX_IMAGE_SIZE+1];
-	char diag[MAX_IMAGE_SIZE+MAX_IMAGE_SIZE+1][MAX_IMAGE_SIZE+1];
-	NDBimage T;
+	unsigned int n[MAX_IMAGE_SIZE+2];
 
 	int ImageSize = MAX_IMAGE_SIZE; //28x28, or 18x18, or 16x16
 
-	p = 0; //start reading the Image String from here
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			ch = ImageString[p];
-			for (i = 0; i < 4; i++) x[i] = 0; //clear the pixel buffer
-			i = 0;
-			while ((ch != ',') && (ch != 0)) {
-				x[i] = ch;
-				i++;
-				p++;
-				ch = ImageString[p];
-			}
-			x[i] = 0;
-			px = atoi(x);
-			if (px < CONTRAST) px = 0;
-			row[r][c] = px;
-			p++; //move past the ','
+	for (r = 0; r <= (ImageSize+1); r++) n[r] = 0;
+
+	//Any numeric below CONTRAST is a zero...
+	//The edge of the image is left all zeros: that removes any feature that contacts
+	//the edge of the image (noise), and guarantees the image is surrounded by zeros
+	for (r = 2; r <= (ImageSize-1); r++) {
+		p = ((r - 1) * ImageSize) + 1;
+		for (c = 2; c <= (ImageSize-1); c++) {
+			px = pixel[p];
+			if (px >= CONTRAST) n[r] |= (1u << c);
+			p++;
 		}
 	}
 
-	//Remove any feature that contacts the edge of the image (noise)
-	//This guarantees the image is surrounded by zeros
-	for (r = 1; r <= ImageSize; r++) {
-		row[r][1] = 0;
-		row[r][ImageSize] = 0;
-	}
-	for (c = 1; c <= ImageSize; c++) {
-		row[1][c] = 0;
-		row[ImageSize][c] = 0;
+	return TransformImage(n, ROW, COL, DIAG);
+}
+
+void GetImageViews(unsigned char *pixel, int Vcount, ImageViews *pV) { //Also called from NdbRecognize.c
+	//
+	//	GetImage() at each of the Vcount contrasts pV[0].Contrast, pV[1].Contrast, ...
+	//	all at once, filling in pV[].Bad, pV[].ROW, pV[].COL and pV[].DIAG.
+	//
+	//	The pixels are read only once, each one setting its bit in the "n" row masks of
+	//	every contrast it reaches, then each contrast is transformed.
+	//
+	//----------
+
+	int px;
+	int p;
+	int r, c;
+	int j;
+	unsigned int n[IMAGE_CONTRASTS][MAX_IMAGE_SIZE+2];
+
+	int ImageSize = MAX_IMAGE_SIZE; //28x28, or 18x18, or 16x16
+
+	for (j = 0; j < Vcount; j++) {
+		for (r = 0; r <= (ImageSize+1); r++) n[j][r] = 0;
 	}
 
-	//Copy row[][] into T.image[][], translating numbers into characters
-	T.ImageSize = ImageSize;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (row[r][c] == 0) {
-				T.image[r][c] = ' ';
-			} else {
-				T.image[r][c] = 'n';
+	//As in GetImage(), the edge of the image is left all zeros
+	for (r = 2; r <= (ImageSize-1); r++) {
+		p = ((r - 1) * ImageSize) + 1;
+		for (c = 2; c <= (ImageSize-1); c++) {
+			px = pixel[p];
+			for (j = 0; j < Vcount; j++) {
+				if (px >= pV[j].Contrast) n[j][r] |= (1u << c);
 			}
+			p++;
 		}
 	}
 
+	for (j = 0; j < Vcount; j++) {
+		pV[j].Bad = TransformImage(n[j], &pV[j].ROW, &pV[j].COL, &pV[j].DIAG);
+	}
+}
+
+int TransformImage(unsigned int *n, NDBimage *ROW, NDBimage *COL, NDBimage *DIAG) {
+	//
+	//	The rest of GetImage(), from the "n"s of the image at its contrast: n[1] ... n[ImageSize]
+	//	with n[0] and n[ImageSize+1] zero. n[] is changed.
+	//
+	//	Returns:	1 if it's a bad image (nothing left), otherwise 0
+	//
+	//----------
+
+	int px;
+	int p;
+	int r, c;
+	int fnd;
+	int FirstRow, LastRow;
+	int startc, startr;
+	unsigned int ALL; //columns 1 - ImageSize
+	unsigned int B[MAX_IMAGE_SIZE+2];
+	unsigned int E[MAX_IMAGE_SIZE+2];
+	unsigned int S[MAX_IMAGE_SIZE+2];
+	unsigned int run;
+	char diag[MAX_IMAGE_SIZE+MAX_IMAGE_SIZE+1][MAX_IMAGE_SIZE+1];
+	NDBimage T;
+
+	int ImageSize = MAX_IMAGE_SIZE; //28x28, or 18x18, or 16x16
+
+	ALL = ((1u << ImageSize) - 1) << 1;
+
+	for (r = 0; r <= (ImageSize+1); r++) {
+		B[r] = 0;
+		E[r] = 0;
+	}
+
 	//Mark the end boundary of each row with a 'B'
 	fnd = 0;
 	for (r = 1; r <= ImageSize; r++) {
-		//Find the 1st non-zero pixel from the end...
-		for (c = (ImageSize-1); c > 0; c--) {
-			if (T.image[r][c] == ' ') continue;
-			T.image[r][c+1] = 'B';
-			fnd = 1;
-			break;
-		}
+		if (n[r] == 0) continue;
+		B[r] = 1u << (HighBit(n[r]) + 1);
+		fnd = 1;
 	}
 	if (fnd == 0) return 1; //Bad image
 
-	//Mark the Top boundary
+	//Mark the Top boundary: the row above the 1st row of "n"s
 	FirstRow = 0;
 	for (r = 1; r <= (ImageSize-1); r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r+1][c] == 'n') {
-				T.image[r][c] = 'B';
-				FirstRow = r; //1st boundary row
-			}
-		}
-		if (FirstRow != 0) break;
+		if (n[r+1] == 0) continue;
+		B[r] |= n[r+1];
+		FirstRow = r; //1st boundary row
+		break;
 	}
 
-	//Mark the Bottom boundary
+	//Mark the Bottom boundary: the row below the last row of "n"s
 	LastRow = 0;
 	for (r = ImageSize; r > 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r-1][c] == 'n') {
-				T.image[r][c] = 'B';
-				LastRow = r; //Last boundary row
-			}
-		}
-		if (LastRow != 0) break;
+		if (n[r-1] == 0) continue;
+		B[r] |= n[r-1];
+		LastRow = r; //Last boundary row
+		break;
 	}
 
-	//Set the boundary pixels for all the rest of the rows,
-	//including interior spaces
+	//Set the boundary pixels for all the rest of the rows, including interior spaces:
+	//every zero behind, in front of, above or below an "n"
 	for (r = (FirstRow+1); r <= (LastRow-1); r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r][c] != ' ') continue; //looking for 'zero', aka ' '
-
-			//check behind
-			if (c != 1) {
-				if (T.image[r][c-1] == 'n') {
-					T.image[r][c] = 'B';
-					continue;
-				}
-			}
-
-			//check forward
-			if (c != ImageSize) {
-				if (T.image[r][c+1] == 'n') {
-					T.image[r][c] = 'B';
-					continue;
-				}
-			}
-
-			//check above
-			if (T.image[r-1][c] == 'n') {
-				T.image[r][c] = 'B';
-				continue;
-			}
-
-			//check below
-			if (T.image[r+1][c] == 'n') {
-				T.image[r][c] = 'B';
-				continue;
-			}
-		}
+		B[r] |= ALL & ~n[r] & ((n[r] << 1) | (n[r] >> 1) | n[r-1] | n[r+1]);
 	}
 
- 	//Identify all "exterior" boundaries with an 'E'
+ 	//Identify all "exterior" boundaries with an 'E': the run of "B"s at each end of a row
 	for (r = FirstRow; r <= LastRow; r++) {
-		for (c = ImageSize; c > 0; c--) {
-			if (T.image[r][c] == ' ') continue;
-			while (T.image[r][c] == 'B') {
-				T.image[r][c] = 'E';
-				c--;
-				if (c < 1) break;
-			}
-			break;
+		if ((n[r] | B[r]) == 0) continue;
+		c = HighBit(n[r] | B[r]);
+		if ((B[r] >> c) & 1) {
+			//The "B"s from c back to the first non-"B"
+			run = ((2u << c) - 1) & ~((2u << HighBit(~B[r] & ((2u << c) - 1))) - 1);
+			B[r] &= ~run;
+			E[r] |= run;
 		}
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r][c] == ' ') continue;
-			while (T.image[r][c] == 'B') {
-				T.image[r][c] = 'E';
-				c++;
-				if (c > ImageSize) break;
-			}
-			break;
+		c = LowBit(n[r] | B[r] | E[r]);
+		if ((B[r] >> c) & 1) {
+			//The "B"s from c forward to the first non-"B"
+			run = B[r] & ~(B[r] + (1u << c));
+			B[r] &= ~run;
+			E[r] |= run;
 		}
 	}
 
@@ -1588,101 +1756,75 @@ int GetImage(char *ImageString, int CONTRAST, NDBimage *ROW, NDBimage *COL, NDBi
 	//All boundary neighbors must be the same kind.
 	//Change every "B" touching an "E" into an "E" (External Boundary)
 	//All remaining "B"'s are "Interior Boundaries".
+	//Each scan repeats for as long as the last "B" it came to was changed.
 	fnd = 1; //Check front to back...
-	while (fnd > 0) {
-		fnd = 0;
-		for (r = FirstRow; r <= LastRow; r++) {
-			for (c = 1; c <= ImageSize; c++) {
-				if (T.image[r][c] != 'B') continue;
-				//Are any of B's eight neighbors an E?
-				fnd = CheckNeighbors('B', 'E', r, c, &T);
-			}
-		}
-	}
+	while (fnd > 0) fnd = SpreadBits(B, E, ImageSize, 1, 0);
 
 	fnd = 1; //Check Back to front...
-	while (fnd > 0) {
-		fnd = 0;
-		for (r = FirstRow; r <= LastRow; r++) {
-			for (c = ImageSize; c >= 1; c--) {
-				if (T.image[r][c] != 'B') continue;
-				//Are any of B's eight neighbors an E?
-				fnd = CheckNeighbors('B', 'E', r, c, &T);
-			}
-		}
-	}
-	
+	while (fnd > 0) fnd = SpreadBits(B, E, ImageSize, 0, 0);
+
+	//The column scans work on the transposed bitboards
+	TransposeBits(B, S, ImageSize);
+	TransposeBits(E, T.Pbits, ImageSize);
+
 	fnd = 1; //Check top to bottom...
-	while (fnd > 0) {
-		fnd = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			for (r = FirstRow; r <= LastRow; r++) {
-				if (T.image[r][c] != 'B') continue;
-				//Are any of B's eight neighbors an E?
-				fnd = CheckNeighbors('B', 'E', r, c, &T);
-			}
-		}
-	}
-	
+	while (fnd > 0) fnd = SpreadBits(S, T.Pbits, ImageSize, 1, 0);
+
 	fnd = 1; //Check bottom to top...
-	while (fnd > 0) {
-		fnd = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			for (r = LastRow; r >= FirstRow; r--) {
-				if (T.image[r][c] != 'B') continue;
-				//Are any of B's eight neighbors an E?
-				fnd = CheckNeighbors('B', 'E', r, c, &T);
-			}
-		}
-	}
+	while (fnd > 0) fnd = SpreadBits(S, T.Pbits, ImageSize, 0, 0);
 
-	//Restore all "E"s back to " "s, leaving the "B"s to mark the interior boundaries
-	for (r = FirstRow; r <= LastRow; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r][c] == 'E') T.image[r][c] = ' ';
-		}
-	}
+	TransposeBits(S, B, ImageSize);
 
-	//Change all "B"s and their " "s to "+"s
-	for (r = FirstRow; r <= LastRow; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (T.image[r][c] == 'B') {
-				while (T.image[r][c] != 'n') {
-					T.image[r][c] = '+';
-					c++;
-					if (c > ImageSize) break;
-				}
-			}
+	//Restore all "E"s back to " "s, leaving the "B"s to mark the interior boundaries
+	//Change all "B"s and the " "s following them up to the next "n", to "+"s
+	T.ImageSize = ImageSize;
+	for (r = 0; r <= (ImageSize+1); r++) {
+		T.Nbits[r] = n[r];
+		T.Pbits[r] = B[r];
+		if (B[r] == 0) continue;
+		run = 0;
+		while (run != T.Pbits[r]) {
+			run = T.Pbits[r];
+			T.Pbits[r] |= (T.Pbits[r] << 1) & ALL & ~n[r];
 		}
 	}
 
 	//If any "+" touches a " ", change it to a " "
-	fnd = 1;
-	while (fnd > 0) {
-		fnd = 0;
-		for (r = FirstRow; r <= LastRow; r++) {
-			for (c = 1; c <= ImageSize; c++) {
-				if (T.image[r][c] != '+') continue;
-				//Are any of +'s eight neighbors a ' '?
-				fnd = CheckNeighbors('+', ' ', r, c, &T);
-			}
-			if (fnd > 0) break;
-		}
+	for (r = 0; r <= (ImageSize+1); r++) {
+		S[r] = 0;
+		if ((r >= 1) && (r <= ImageSize)) S[r] = ALL & ~T.Nbits[r] & ~T.Pbits[r];
 	}
+	fnd = 1;
+	while (fnd > 0) fnd = SpreadBits(T.Pbits, S, ImageSize, 1, 1);
 
 	EliminateNoise(&T);
 
+	//Copy the bitboards into T.image[][]
+	for (r = 1; r <= ImageSize; r++) {
+		for (c = 1; c <= ImageSize; c++) {
+			T.image[r][c] = ' ';
+			if ((T.Nbits[r] >> c) & 1) T.image[r][c] = 'n';
+			if ((T.Pbits[r] >> c) & 1) T.image[r][c] = '+';
+		}
+	}
+
 	//Create ROW perspective
 	ROW->ImageSize = ImageSize;
 	for (r = 1; r <= ImageSize; r++) {
 		for (c = 1; c <= ImageSize; c++) ROW->image[r][c] = T.image[r][c];
 	}
+	for (r = 0; r <= (ImageSize+1); r++) {
+		ROW->Nbits[r] = T.Nbits[r];
+		ROW->Pbits[r] = T.Pbits[r];
+	}
 
 	//Create COL perspective
 	COL->ImageSize = ImageSize;
 	for (r = 1; r <= ImageSize; r++) {
 		for (c = 1; c <= ImageSize; c++) COL->image[c][r] = T.image[r][c];
 	}
+	TransposeBits(T.Nbits, COL->Nbits, ImageSize);
+	TransposeBits(T.Pbits, COL->Pbits, ImageSize);
 
 	//Create DIAG perspective...
 	//initialize the diagonal array to zero, i.e. " "
@@ -1722,173 +1864,256 @@ int GetImage(char *ImageString, int CONTRAST, NDBimage *ROW, NDBimage *COL, NDBi
 	}
 	DIAG->ImageSize = ImageSize;
 
+	ImageBits(DIAG);
+
 	return 0;
 }
 
-int CheckNeighbors(char FromChar, char ToChar, int r, int c, NDBimage *Z) {
+int SpreadBits(unsigned int *From, unsigned int *To, int ImageSize, int Forward, int StopAtChange) {
+	//
+	//	One scan of the image, row by row, changing every From-bit with one of its 8
+	//	neighbors in To into a To-bit. Within a row the scan is front to back (Forward=1)
+	//	or back to front, so a change carries on along a row in the direction of the scan.
+	//	This is the bitboard version of scanning image[][] with CheckNeighbors().
+	//
+	//	Rows above have already been scanned, rows below haven't. The column scans pass
+	//	in transposed bitboards: see TransposeBits().
 	//
-	//	A 'FromChar' has been found at Z->image[r][c]. If any of its 8 neighbors
-	//	is a 'ToChar', change the FromChar to the ToChar.
+	//	StopAtChange=1 ends the scan after the first row whose last From-bit changed.
 	//
-	//	Returns 1 if any such change took place
+	//	Returns 1 if the last From-bit scanned was changed, otherwise 0
 	//
 	//----------
- 
-	int fnd;
 
-	int ImageSize = Z->ImageSize;
+	int r;
+	int last;
+	int fnd;
+	unsigned int near;
+	unsigned int x, y;
 
-	//Are any of the 8 neighbors a ToChar?
 	fnd = 0;
-
-	if ((c+1) <= ImageSize) {
-		if (Z->image[r][c+1] == ToChar) fnd = 1; //right
-	}
-	if (fnd == 0) {
-		if ((c-1) > 0) {
-			if (Z->image[r][c-1] == ToChar) fnd = 1; //left
-		}
-		if (fnd == 0) {
-			if ((r-1) > 0) {
-				if (Z->image[r-1][c] == ToChar) fnd = 1; //up
-			}
-			if (fnd == 0) {
-				if ((r+1) <= ImageSize) {
-					if (Z->image[r+1][c] == ToChar) fnd = 1; //down
-				}
-				if (fnd == 0) {
-					if (((r-1) > 0) && ((c+1) <= ImageSize)) {
-						if (Z->image[r-1][c+1] == ToChar) fnd = 1; //upper right
-					}
-					if (fnd == 0) {
-						if (((r-1) > 0) && ((c-1) > 0)) {
-							if (Z->image[r-1][c-1] == ToChar) fnd = 1; //upper left
-						}
-						if (fnd == 0) {
-							if (((r+1) <= ImageSize) && ((c+1) <= ImageSize)) {
-								if (Z->image[r+1][c+1] == ToChar) fnd = 1; //lower right
-							}
-							if (fnd == 0) {
-								if (((r+1) <= ImageSize) && ((c-1) > 0)) {
-									if (Z->image[r+1][c-1] == ToChar) fnd = 1; //lower left
-								}
-							}
-						}
-					}
-				}
+	for (r = 1; r <= ImageSize; r++) {
+		if (From[r] == 0) continue;
+
+		//The From-bits touching a To-bit before this row is scanned
+		near = To[r-1] | (To[r-1] << 1) | (To[r-1] >> 1);
+		near |= To[r+1] | (To[r+1] << 1) | (To[r+1] >> 1);
+		near |= (To[r] << 1) | (To[r] >> 1);
+		x = From[r] & near;
+
+		//...and the ones changed by their neighbor behind them, in the scan direction
+		y = 0;
+		while (x != y) {
+			y = x;
+			if (Forward == 1) {
+				x |= (x << 1) & From[r];
+			} else {
+				x |= (x >> 1) & From[r];
 			}
 		}
-	}
 
-	if (fnd == 1) Z->image[r][c] = ToChar;
+		if (Forward == 1) {
+			last = HighBit(From[r]);
+		} else {
+			last = LowBit(From[r]);
+		}
+		fnd = (x >> last) & 1;
+
+		From[r] &= ~x;
+		To[r] |= x;
+
+		if ((StopAtChange == 1) && (fnd == 1)) break;
+	}
 
 	return fnd;
 }
 
-void EliminateNoise(NDBimage *Z) {
+void TransposeBits(unsigned int *FROM, unsigned int *TO, int ImageSize) {
+	//
+	//	TO[] is FROM[] with its rows and columns swapped
 	//
-	//	Remove isolated pixels
+	//	Only the bits that are set are visited: the boundary bitboards are mostly empty.
 	//
 	//----------
 
 	int r, c;
-	char ch;
-	int fnd;
+	unsigned int x;
 
-	int ImageSize = Z->ImageSize;
+	for (r = 0; r <= (ImageSize+1); r++) TO[r] = 0;
 
 	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-
-			if (Z->image[r][c] == '+') {
-				//Is this position ("+") surrounded by "n" ?
-				ch = 'n';
-				fnd = CheckForNoise(r, c, ch, Z);
-				if (fnd == 8) Z->image[r][c] = ch; //Change "+" to "n"
-				continue;
-			}
-
-			if (Z->image[r][c] == 'n') {
-				//Is this position ("n") surrounded by " " ?
-				ch = ' ';
-				fnd = CheckForNoise(r, c, ch, Z);
-				if (fnd == 8) Z->image[r][c] = ch; //Change "n" to " "
-				continue;
-			}
+		x = FROM[r];
+		while (x != 0) {
+			c = LowBit(x);
+			TO[c] |= (1u << r);
+			x &= x - 1; //next bit
 		}
 	}
 }
 
-int CheckForNoise(int r, int c, char ch, NDBimage *Z) {
+void EliminateNoise(NDBimage *Z) {
 	//
-	//	Check all 8 positions around this pixel for the same alternative: ch
+	//	Remove isolated pixels: a "+" surrounded by "n"s becomes an "n", and an "n"
+	//	surrounded by " "s becomes a " ". Positions off the edge of the image count as
+	//	surrounding the pixel.
+	//
+	//	Only the bitboards are changed.
 	//
 	//----------
 
-	int cnt;
-	char px;
+	int r;
+	unsigned int ALL;
+	unsigned int EDGE;
+	unsigned int N[MAX_IMAGE_SIZE+2];
+	unsigned int S[MAX_IMAGE_SIZE+2];
+	unsigned int toN, toS;
 
 	int ImageSize = Z->ImageSize;
 
-	cnt = 0;
+	ALL = ((1u << ImageSize) - 1) << 1;
+	EDGE = 1u | (1u << (ImageSize+1));
 
-	if ((c+1) <= ImageSize) {
-		px = Z->image[r][c + 1]; //check the pixel in front
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+	//The "n"s and " "s with the positions off the edge of the image added
+	for (r = 0; r <= (ImageSize+1); r++) {
+		if ((r < 1) || (r > ImageSize)) {
+			N[r] = ALL | EDGE;
+			S[r] = ALL | EDGE;
+			continue;
+		}
+		N[r] = Z->Nbits[r] | EDGE;
+		S[r] = (ALL & ~Z->Nbits[r] & ~Z->Pbits[r]) | EDGE;
 	}
 
-	if ((c-1) > 0) {
-		px = Z->image[r][c - 1]; //behind
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+	for (r = 1; r <= ImageSize; r++) {
+		toN = Z->Pbits[r] & SurroundedBits(N, r);
+		toS = Z->Nbits[r] & SurroundedBits(S, r);
+		Z->Pbits[r] &= ~toN;
+		Z->Nbits[r] = (Z->Nbits[r] | toN) & ~toS;
 	}
+}
 
-	if ((r+1) <= ImageSize) {
-		px = Z->image[r + 1][c]; //below
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
-	}
+unsigned int SurroundedBits(unsigned int *Q, int r) {
+	//
+	//	The positions in row r whose 8 neighbors are all Q-bits
+	//
+	//----------
 
-	if ((r-1) > 0) {
-		px = Z->image[r - 1][c]; //above
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
-	}
+	return (Q[r-1] << 1) & Q[r-1] & (Q[r-1] >> 1) & (Q[r] << 1) & (Q[r] >> 1) & (Q[r+1] << 1) & Q[r+1] & (Q[r+1] >> 1);
+}
 
-	if (((r+1) <= ImageSize) && ((c+1) <= ImageSize)) {
-		px = Z->image[r + 1][c + 1]; //below, right
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+void ImageBits(NDBimage *X) {
+	//
+	//	Set the bitboards X->Nbits[] and X->Pbits[] from X->image[][]
+	//
+	//----------
+
+	int r, c;
+
+	int ImageSize = X->ImageSize;
+
+	X->Nbits[0] = 0;
+	X->Pbits[0] = 0;
+	for (r = 1; r <= ImageSize; r++) {
+		X->Nbits[r] = 0;
+		X->Pbits[r] = 0;
+		for (c = 1; c <= ImageSize; c++) {
+			if (X->image[r][c] == 'n') X->Nbits[r] |= (1u << c);
+			if (X->image[r][c] == '+') X->Pbits[r] |= (1u << c);
+		}
 	}
+	X->Nbits[ImageSize+1] = 0;
+	X->Pbits[ImageSize+1] = 0;
+}
 
-	if (((r+1) <= ImageSize) && ((c-1) > 0)) {
-		px = Z->image[r + 1][c - 1]; //below, left
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+void GetPanelBits(NDBimage *FROM, int rb, int cb, NDBimage *TO) { //Also called from NdbRecognize.c
+	//
+	//	Copy the bitboards of the TO->ImageSize square panel whose upper left
+	//	corner is FROM->image[rb][cb]
+	//
+	//----------
+
+	int r;
+	unsigned int ALL;
+
+	int ImageSize = TO->ImageSize;
+
+	ALL = ((1u << ImageSize) - 1) << 1;
+
+	TO->Nbits[0] = 0;
+	TO->Pbits[0] = 0;
+	for (r = 1; r <= ImageSize; r++) {
+		TO->Nbits[r] = (FROM->Nbits[rb+r-1] >> (cb-1)) & ALL;
+		TO->Pbits[r] = (FROM->Pbits[rb+r-1] >> (cb-1)) & ALL;
 	}
+	TO->Nbits[ImageSize+1] = 0;
+	TO->Pbits[ImageSize+1] = 0;
+}
 
-	if (((r-1) > 0) && ((c+1) <= ImageSize)) {
-		px = Z->image[r - 1][c + 1]; //above, right
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+int BitCount(unsigned int x) {
+	//
+	//	The number of bits set in x
+	//
+	//----------
+
+	x = x - ((x >> 1) & 0x55555555u);
+	x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+	x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+
+	return (int)((x * 0x01010101u) >> 24);
+}
+
+int LowBit(unsigned int x) {
+	//
+	//	The lowest bit set in x, i.e. the first column in a row mask (x must not be 0)
+	//
+	//----------
+
+	return BitCount((x & (0u - x)) - 1);
+}
+
+int HighBit(unsigned int x) {
+	//
+	//	The highest bit set in x, i.e. the last column in a row mask (x must not be 0)
+	//
+	//----------
+
+	x |= x >> 1;
+	x |= x >> 2;
+	x |= x >> 4;
+	x |= x >> 8;
+	x |= x >> 16;
+
+	return BitCount(x) - 1;
+}
+
+int FirstBitRow(unsigned int *bits, int ImageSize) {
+	//
+	//	The first row with any bits set, or 0
+	//
+	//----------
+
+	int r;
+
+	for (r = 1; r <= ImageSize; r++) {
+		if (bits[r] != 0) return r;
 	}
 
-	if (((r-1) > 0) && ((c-1) > 0)) {
-		px = Z->image[r - 1][c - 1]; //above, left
-		if (px == ch) cnt++;
-	} else {
-		cnt++;
+	return 0;
+}
+
+int LastBitRow(unsigned int *bits, int ImageSize) {
+	//
+	//	The last row with any bits set, or 0
+	//
+	//----------
+
+	int r;
+
+	for (r = ImageSize; r >= 1; r--) {
+		if (bits[r] != 0) return r;
 	}
 
-	return cnt;
+	return 0;
 }
 
 void GetImageRNs(ImageData *pIdata, NDBimage *X) {
@@ -1948,26 +2173,12 @@ int FindCavitiesFB(NDBimage *X) {
 	//
 	//----------
 
-	int r, c, rc;
 	int cavF, cavB, CAV;
-	NDBimage Z;
-
-	int ImageSize = X->ImageSize;
-
-	cavF = CavityCount(X);
 
-	//Flip the image back to front
-	Z.ImageSize = ImageSize;
-	for (r = 1; r <= ImageSize; r++) {
-		rc = ImageSize;
-		for (c = 1; c <= ImageSize; c++) {
-			Z.image[r][rc] = X->image[r][c];
-			rc--;
-		}
-	}
+	cavF = CavityCount(X, 0);
 
-	cavB = CavityCount(&Z);
-	
+	//The image flipped back to front
+	cavB = CavityCount(X, 1);
 
 	CAV = 0;
 	if ((cavF == 1) && (cavB == 0)) {
@@ -2008,13 +2219,15 @@ int FindCavitiesFB(NDBimage *X) {
 	return CAV;
 }
 
-int CavityCount(NDBimage *X) {
+int CavityCount(NDBimage *X, int Back) {
 	//
 	//	Scan the left side of the image, counting the number of cavities
 	//
+	//	Back=1 scans the right side instead, as if the image were flipped back to front
+	//
 	//----------
 
-	int r, c;
+	int r;
 	int c1, c2;
 	int inCav;
 	int ncav;
@@ -2023,31 +2236,27 @@ int CavityCount(NDBimage *X) {
 
 	ncav = 0;
 
-	c1 = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				c1 = c;
-				break;
-			}
-		}
-		if (c1 != 0) break;
+	r = FirstBitRow(X->Nbits, ImageSize);
+	if (r == 0) return 0; //blank image
+
+	//The 1st "n" in the row
+	if (Back == 0) {
+		c1 = LowBit(X->Nbits[r]);
+	} else {
+		c1 = ImageSize + 1 - HighBit(X->Nbits[r]);
 	}
-	if (c1 == 0) return 0; //blank image
 
 	inCav = 0; //Flag: are you in/out of a cavity?
 
 	//Go down the left side looking for cavities...
 	r++;
 	while (r <= ImageSize) {
-		c2 = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				c2 = c;
-				break;
+		if (X->Nbits[r] != 0) {
+			if (Back == 0) {
+				c2 = LowBit(X->Nbits[r]);
+			} else {
+				c2 = ImageSize + 1 - HighBit(X->Nbits[r]);
 			}
-		}
-		if (c2 != 0) {
 			if (c1 > c2) {
 				//If inCav=0: still searching for the beginning of a cavity
 				if (inCav == 1) { //1st indication of moving out of a cavity
@@ -2078,35 +2287,17 @@ int Pedestal(NDBimage *X) {
 	//
 	//----------
 
-	int r, c;
+	int r;
 	int FirstR, LastR, height, q;
 	int top, bottom;
 	int PED;
 
 	int ImageSize = X->ImageSize;
 
-	FirstR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				FirstR = r;
-				break;
-			}
-		}
-		if (FirstR != 0) break;
-	}
+	FirstR = FirstBitRow(X->Nbits, ImageSize);
 	if (FirstR == 0) return 0; //blank image
 
-	LastR = 0;
-	for (r = ImageSize; r >= 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				LastR = r;
-				break;
-			}
-		}
-		if (LastR != 0) break;
-	}
+	LastR = LastBitRow(X->Nbits, ImageSize);
 
 	height = LastR - FirstR + 1;
 	q = height / 4;
@@ -2114,18 +2305,10 @@ int Pedestal(NDBimage *X) {
 
 	//Which has more pixels: top half or bottom half?
 	bottom = 0;
-	for (r = LastR; r >= (LastR - q); r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') bottom++;
-		}
-	}
+	for (r = LastR; r >= (LastR - q); r--) bottom += BitCount(X->Nbits[r]);
 
 	top = 0;
-	for (r = (LastR-q-1); r >= (LastR-q-1-q); r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') top++;
-		}
-	}
+	for (r = (LastR-q-1); r >= (LastR-q-1-q); r--) top += BitCount(X->Nbits[r]);
 	
 	PED = 0;
 	if ((bottom + bottom) < top) {
@@ -2152,9 +2335,8 @@ int FindInterior(NDBimage *X) {
 	//
 	//----------
 
-	int r, c;
+	int r;
 	int FirstR, LastR;
-	int fnd;
 	int start1;
 	int end1;
 	int start2, end2;
@@ -2163,42 +2345,17 @@ int FindInterior(NDBimage *X) {
 
 	int ImageSize = X->ImageSize;
 
-	FirstR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				FirstR = r;
-				break;
-			}
-		}
-		if (FirstR != 0) break;
-	}
-
+	FirstR = FirstBitRow(X->Nbits, ImageSize);
 	if (FirstR == 0) return 0; //blank image
 
-	LastR = 0;
-	for (r = ImageSize; r >= 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				LastR = r;
-				break;
-			}
-		}
-		if (LastR != 0) break;
-	}
+	LastR = LastBitRow(X->Nbits, ImageSize);
 
 	start1 = 0;
 	for (r = FirstR; r <= LastR; r++) {
-		fnd = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == '+') {
-				if (start1 == 0) start1 = r;
-				end1 = r;
-				fnd = 1;
-				break; //get next row
-			}
-		}
-		if (fnd == 0) { //Didn't find a "+" in this row...
+		if (X->Pbits[r] != 0) {
+			if (start1 == 0) start1 = r;
+			end1 = r;
+		} else { //Didn't find a "+" in this row...
 			if (start1 > 0) break; //start1,end1 define an interior region
 		}
 	}
@@ -2208,16 +2365,10 @@ int FindInterior(NDBimage *X) {
 	//Is there a 2nd interior region?
 	start2 = 0;
 	for (r = end1+1; r <= LastR; r++) {
-		fnd = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == '+') {
-				if (start2 == 0) start2 = r;
-				end2 = r;
-				fnd = 1;
-				break; //get next row
-			}
-		}
-		if (fnd == 0) { //Didn't find a "+" in this row...
+		if (X->Pbits[r] != 0) {
+			if (start2 == 0) start2 = r;
+			end2 = r;
+		} else { //Didn't find a "+" in this row...
 			if (start2 > 0) break; //start2,end2 define a 2nd interior region
 		}
 	}
@@ -2250,7 +2401,7 @@ int GetLongestRow(NDBimage *X) {
 	//
 	//----------
 
-	int r, c;
+	int r;
 	int startR, endR, height;
 	int cnt, maxR, longR;
 	float ratio;
@@ -2260,28 +2411,10 @@ int GetLongestRow(NDBimage *X) {
 
 	LR = 0;
 
-	startR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				startR = r;
-				break;
-			}
-		}
-		if (startR != 0) break;
-	}
+	startR = FirstBitRow(X->Nbits, ImageSize);
 	if (startR == 0) return 0; //blank image
 
-	endR = 0;
-	for (r = ImageSize; r >= 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				endR = r;
-				break;
-			}
-		}
-		if (endR != 0) break;
-	}
+	endR = LastBitRow(X->Nbits, ImageSize);
 
 	height = endR - startR + 1;
 
@@ -2289,10 +2422,7 @@ int GetLongestRow(NDBimage *X) {
 	longR = 0; //location of longest row
 	maxR = 0; //number of pixels in the longest row
 	for (r = startR; r <= endR; r++) {
-		cnt = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			if ((X->image[r][c] == 'n') || (X->image[r][c] == '+')) cnt++;
-		}
+		cnt = BitCount(X->Nbits[r] | X->Pbits[r]);
 		if (cnt > maxR) {
 			maxR = cnt;
 			longR = r;
@@ -2331,7 +2461,7 @@ void ImageShape(ImageData *pIdata, NDBimage *X) {
 	//
 	//----------
 
-	int r, c;
+	int r;
 	int FirstR;
 	int FirstC;
 	int LastR;
@@ -2339,6 +2469,7 @@ void ImageShape(ImageData *pIdata, NDBimage *X) {
 	int FC, LC;
 	int height, width;
 	int x;
+	unsigned int cols;
 	float ratio;
 
 	int ImageSize = X->ImageSize;
@@ -2346,54 +2477,24 @@ void ImageShape(ImageData *pIdata, NDBimage *X) {
 	pIdata->SLANT = 0;
 	pIdata->GIRTH = 0;
 
-	FirstR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				FirstR = r;
-				FirstC = c;
-				break;
-			}
-		}
-		if (FirstR != 0) break;
-	}
+	FirstR = FirstBitRow(X->Nbits, ImageSize);
+	if (FirstR == 0) return; //blank image
 
-	LastR = 0;
-	for (r = ImageSize; r >= 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				LastR = r;
-				LastC = c;
-				break;
-			}
-		}
-		if (LastR != 0) break;
-	}
+	LastR = LastBitRow(X->Nbits, ImageSize);
 
 	height = LastR - FirstR + 1;
 
-	if (height == 1) return; //blank image
+	if (height == 1) return; //a single row
 
-	FC = 0;
-	for (c = 1; c <= ImageSize; c++) {
-		for (r = FirstR; r <= LastR; r++) {
-			if (X->image[r][c] == 'n') {
-				FC = c;
-				break;
-			}
-		}
-		if (FC != 0) break;
-	}
-	LC = 0;
-	for (c = ImageSize; c >= 1; c--) {
-		for (r = FirstR; r <= LastR; r++) {
-			if (X->image[r][c] == 'n') {
-				LC = c;
-				break;
-			}
-		}
-		if (LC != 0) break;
-	}
+	//The 1st "n" in the first and last rows
+	FirstC = LowBit(X->Nbits[FirstR]);
+	LastC = LowBit(X->Nbits[LastR]);
+
+	//The first and last columns with an "n"
+	cols = 0;
+	for (r = FirstR; r <= LastR; r++) cols |= X->Nbits[r];
+	FC = LowBit(cols);
+	LC = HighBit(cols);
 
 	width = LC - FC + 1;
 
@@ -2432,110 +2533,28 @@ void GetLongestLine(ImageData *pIdata, NDBimage *X) {
 	//			= 30, diagonal, centered on upper left
 	//			= 40, diagonal centered on lower left
 	//
+	//	Only lines of 2 or more "n"s count.
+	//
 	//----------
 
-	int r, c;
-	int cnt;
-	int startr, startc;
 	int maxR, maxC, maxD1, maxD2, max;
 
-	int ImageSize = X->ImageSize;
-
 	//Row line lengths...
-	maxR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		cnt = 0;
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-				continue;
-			}
-			if ((cnt > 1) && (cnt > maxR)) maxR = cnt;
-			cnt = 0;
-		}
-		if ((cnt > 1) && (cnt > maxR)) maxR = cnt;
-	}
+	maxR = LongestLine(X, 0, 1);
 
 	//Column line lengths...
-	maxC = 0;
-	for (c = 1; c <= ImageSize; c++) {
-		cnt = 0;
-		for (r = 1; r <= ImageSize; r++) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-				continue;
-			}
-			if ((cnt > 1) && (cnt > maxC)) maxC = cnt;
-			cnt = 0;
-		}
-		if ((cnt > 1) && (cnt > maxC)) maxC = cnt;
-	}
+	maxC = LongestLine(X, 1, 0);
 
 	//Longest diagonal_1 line (upper right to lower left)...
-	maxD1 = 0;
-	for (startc = ImageSize; startc >= 1; startc--) {
-		cnt = 0;
-		c = startc;
-		for (r = 1; r <= ImageSize; r++) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-			} else {
-				if ((cnt > 1) && (cnt > maxD1)) maxD1 = cnt;
-				cnt = 0;
-			}
-			c--; //move diagonally
-			if (c < 1) break;
-		}
-		if ((cnt > 1) && (cnt > maxD1)) maxD1 = cnt;
-	}
-	for (startr = 2; startr <= ImageSize; startr++) {
-		cnt = 0;
-		r = startr;
-		for (c = ImageSize; c >= 1; c--) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-			} else {
-				if ((cnt > 1) && (cnt > maxD1)) maxD1 = cnt;
-				cnt = 0;
-			}
-			r++; //move diagonally
-			if (r > ImageSize) break;
-		}
-		if ((cnt > 1) && (cnt > maxD1)) maxD1 = cnt;
-	}
+	maxD1 = LongestLine(X, 1, -1);
 
 	//Longest diagonal_2 line (upper left to lower right)...
-	maxD2 = 0;
-	for (startc = 1; startc <= ImageSize; startc++) {
-		cnt = 0;
-		c = startc;
-		for (r = 1; r <= ImageSize; r++) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-			} else {
-				if ((cnt > 1) && (cnt > maxD2)) maxD2 = cnt;
-				cnt = 0;
-			}
-			c++; //move diagonally
-			if (c > ImageSize) break;
-		}
-		if ((cnt > 1) && (cnt > maxD2)) maxD2 = cnt;
-	}
-	for (startr = 2; startr <= ImageSize; startr++) {
-		cnt = 0;
-		r = startr;
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				cnt++;
-			} else {
-				if ((cnt > 1) && (cnt > maxD2)) maxD2 = cnt;
-				cnt = 0;
-			}
-			r++; //move diagonally
-			if (r > ImageSize) break;
-		}
-		if ((cnt > 1) && (cnt > maxD2)) maxD2 = cnt;
-	}
+	maxD2 = LongestLine(X, 1, 1);
+
+	if (maxR < 2) maxR = 0;
+	if (maxC < 2) maxC = 0;
+	if (maxD1 < 2) maxD1 = 0;
+	if (maxD2 < 2) maxD2 = 0;
 
 	pIdata->LL = 0;	//longest line
 	max = 0;
@@ -2558,6 +2577,56 @@ void GetLongestLine(ImageData *pIdata, NDBimage *X) {
 
 }
 
+int LongestLine(NDBimage *X, int dr, int dc) {
+	//
+	//	The length of the longest line of "n"s going in the direction: next row + dr,
+	//	next column + dc
+	//
+	//	Bit c of line[r] is set while there's a line of len "n"s starting at [r][c].
+	//	Each step ANDs in the row len steps along, shifted back into line with column c.
+	//
+	//----------
+
+	int r, rr;
+	int len;
+	int fnd;
+	unsigned int line[MAX_IMAGE_SIZE+1];
+
+	int ImageSize = X->ImageSize;
+
+	fnd = 0;
+	for (r = 1; r <= ImageSize; r++) {
+		line[r] = X->Nbits[r];
+		if (line[r] != 0) fnd = 1;
+	}
+	if (fnd == 0) return 0; //blank image
+
+	for (len = 1; len < ImageSize; len++) {
+		fnd = 0;
+		for (r = 1; r <= ImageSize; r++) {
+			if (line[r] == 0) continue;
+			rr = r + (len * dr);
+			if (rr > ImageSize) {
+				line[r] = 0;
+				continue;
+			}
+			if (dc > 0) {
+				line[r] &= (X->Nbits[rr] >> (len * dc));
+			} else {
+				if (dc < 0) {
+					line[r] &= (X->Nbits[rr] << (len * -dc));
+				} else {
+					line[r] &= X->Nbits[rr];
+				}
+			}
+			if (line[r] != 0) fnd = 1;
+		}
+		if (fnd == 0) break;
+	}
+
+	return len;
+}
+
 void GetImageWeights(ImageData *pIdata, NDBimage *X) {
 	//
 	//	Returns: Image Weight
@@ -2580,11 +2649,12 @@ void GetImageWeights(ImageData *pIdata, NDBimage *X) {
 	int FirstR, FirstC;
 	int LastR, LastC;
 
-	int r, c;
+	int r;
 	int d;
 	int third;
 	int toR, top, bottom;
 	int toC, left, right;
+	unsigned int cols, mask;
 	float ratio;
 
 	int ImageSize = X->ImageSize;
@@ -2592,27 +2662,8 @@ void GetImageWeights(ImageData *pIdata, NDBimage *X) {
 	//Which has more pixels, the top third or the bottom third?
 	WTB = 0;
 
-	FirstR = 0;
-	for (r = 1; r <= ImageSize; r++) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				FirstR = r;
-				break;
-			}
-		}
-		if (FirstR != 0) break;
-	}
-
-	LastR = 0;
-	for (r = ImageSize; r >= 1; r--) {
-		for (c = 1; c <= ImageSize; c++) {
-			if (X->image[r][c] == 'n') {
-				LastR = r;
-				break;
-			}
-		}
-		if (LastR != 0) break;
-	}
+	FirstR = FirstBitRow(X->Nbits, ImageSize);
+	LastR = LastBitRow(X->Nbits, ImageSize);
 
 	d = LastR - FirstR + 1;
 
@@ -2620,18 +2671,10 @@ void GetImageWeights(ImageData *pIdata, NDBimage *X) {
 		third = d / 3;
 		toR = FirstR + third;
 		top = 0;
-		for (r = FirstR; r <= toR; r++) {
-			for (c = 1; c <= ImageSize; c++) {
-				if ((X->image[r][c] == 'n') || (X->image[r][c] == '+')) top++;
-			}
-		}
+		for (r = FirstR; r <= toR; r++) top += BitCount(X->Nbits[r] | X->Pbits[r]);
 		toR = LastR - third;
 		bottom = 0;
-		for (r = LastR; r >= toR; r--) {
-			for (c = 1; c <= ImageSize; c++) {
-				if ((X->image[r][c] == 'n') || (X->image[r][c] == '+')) bottom++;
-			}
-		}
+		for (r = LastR; r >= toR; r--) bottom += BitCount(X->Nbits[r] | X->Pbits[r]);
 		d = top + bottom;
 		if (d > 0) {
 			ratio = (float)top / (float)d;
@@ -2652,45 +2695,27 @@ void GetImageWeights(ImageData *pIdata, NDBimage *X) {
  	//Which has more pixels, the left third or the right third?
 	WRL = 0;
 
-	FirstC = 0;
-	for (c = 1; c <= ImageSize; c++) {
-		for (r = 1; r <= ImageSize; r++) {
-			if (X->image[r][c] == 'n') {
-				FirstC = c;
-				break;
-			}
-		}
-		if (FirstC != 0) break;
-	}
+	cols = 0;
+	for (r = 1; r <= ImageSize; r++) cols |= X->Nbits[r];
 
+	FirstC = 0;
 	LastC = 0;
-	for (c = ImageSize; c >= 1; c--) {
-		for (r = 1; r <= ImageSize; r++) {
-			if (X->image[r][c] == 'n') {
-				LastC = c;
-				break;
-			}
-		}
-		if (LastC != 0) break;
+	if (cols != 0) {
+		FirstC = LowBit(cols);
+		LastC = HighBit(cols);
 	}
 
 	d = LastC - FirstC + 1;
 	if (d > 1) {
 		third = d / 3;
 		toC = FirstC + third;
+		mask = ((2u << toC) - 1) & ~((1u << FirstC) - 1); //columns FirstC - toC
 		left = 0;
-		for (c = FirstC; c <= toC; c++) {
-			for (r = 1; r <= ImageSize; r++) {
-				if ((X->image[r][c] == 'n') || (X->image[r][c] == '+')) left++;
-			}
-		}
+		for (r = 1; r <= ImageSize; r++) left += BitCount((X->Nbits[r] | X->Pbits[r]) & mask);
 		toC = LastC - third;
+		mask = ((2u << LastC) - 1) & ~((1u << toC) - 1); //columns toC - LastC
 		right = 0;
-		for (c = LastC; c >= toC; c--) {
-			for (r = 1; r <= ImageSize; r++) {
-				if ((X->image[r][c] == 'n') || (X->image[r][c] == '+')) right++;
-			}
-		}
+		for (r = 1; r <= ImageSize; r++) right += BitCount((X->Nbits[r] | X->Pbits[r]) & mask);
 		d = left + right;
 		if (d > 0) {
 			ratio = (float)left / (float)d;
@@ -2723,6 +2748,7 @@ int Curvy(NDBimage *Z) {
 
 	int r1, c1;
 	int r2, c2;
+	int r;
 	int fnd;
 	int Straight, Curvy, CS;
 	char prev[2]; //previous boundary direction
@@ -2730,24 +2756,13 @@ int Curvy(NDBimage *Z) {
 	int ImageSize = Z->ImageSize;
 	
 	//clear the boundary trace
-	for (r1 = 0; r1 < 196; r1++) {
-		for (c1 = 0; c1 < 196; c1++) pIB.point[r1][c1] = 0;
-	}
+	for (r = 0; r <= (ImageSize+1); r++) pIB.point[r] = 0;
 
 	//In image Z, find the 1st row of the image, the 1st "n".
 	//Note that it may be on the image edge, especially if this is a panel.
-	fnd = 0;
-	for (r1 = 1; r1 <= ImageSize; r1++) {
-		for (c1 = 1; c1 <= ImageSize; c1++) {
-			if (Z->image[r1][c1] == 'n') {
-				fnd = 1;
-				pIB.point[r1][c1] = 1;
-				break;
-			}
-		}
-		if (fnd != 0) break;
-	}
-	if (fnd == 0) return 0; //blank image
+	r1 = FirstBitRow(Z->Nbits, ImageSize);
+	if (r1 == 0) return 0; //blank image
+	c1 = LowBit(Z->Nbits[r1]);
 
 	//remember the previous direction you were going in
 	prev[0] = 0;
@@ -2777,169 +2792,56 @@ int FindNeighbor(int *r1, int *c1, int *r2, int *c2, int *Curvy, int *Straight,
 	//
 	//	Going clockwise from the "n" at r1,c1 find the next "n" at r2,c2
 	//
+	//	The neighbors are tried in the order of Step[]: up, right, down, left, and then the
+	//	diagonals. Each step is its row and column offsets, the direction it leaves in prev[],
+	//	and for the up/down/left/right steps, whether a new location on the Column or Row
+	//	edge of the image is ignored.
+	//
 	//	Since this 'image' may be a sub-image (panel) of the main image, some
 	//	of the "n"s may be on the edge of the image and should NOT alter the
 	//	values of Straight/Curvy.
 	//
 	//----------
 
-	int ImageSize = Z->ImageSize;
-
-	if ((*r1 - 1) > 0) {
-		if (pIB->point[*r1 - 1][*c1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 - 1][*c1] == 'n') { //up
-				*r2 = *r1 - 1;
-				*c2 = *c1;
-				pIB->point[*r1][*c1] = 1;
-				//If this new location is on the edge of the image, ignore it's contribution
-				if ((*c2 != 1 ) && (*c2 != ImageSize)) {
-					if ((prev[0] == 'U') && (prev[1] == 0)) {
-						(*Straight)++;
-					} else {
-						(*Curvy)++;
-						prev[0] = 'U';
-						prev[1] = 0;
-					}
-				}
-				return 1;
-			}
-		}
-	}
+	static const int Step[8][5] = {
+		{-1,  0, 'U',   0, 'C'},	//up
+		{ 0,  1, 'R',   0, 'R'},	//right
+		{ 1,  0, 'D',   0, 'C'},	//down
+		{ 0, -1, 'L',   0, 'R'},	//left
+		{-1,  1, 'U', 'R',   0},	//upper right
+		{ 1,  1, 'L', 'R',   0},	//lower right
+		{ 1, -1, 'L', 'L',   0},	//lower left
+		{-1, -1, 'U', 'L',   0}		//upper left
+	};
+	int r, c;
+	int s;
 
-	if ((*c1 + 1) <= ImageSize) {
-		if (pIB->point[*r1][*c1 + 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1][*c1 + 1] == 'n') { //right
-				*r2 = *r1;
-				*c2 = *c1 + 1;
-				pIB->point[*r1][*c1] = 1;
-				//If this new location is on the edge of the image, ignore it's contribution
-				if ((*r2 != 1) && (*r2 != ImageSize)) {
-					if ((prev[0] == 'R') && (prev[1] == 0)) {
-						(*Straight)++;
-					} else {
-						(*Curvy)++;
-						prev[0] = 'R';
-						prev[1] = 0;
-					}
-				}
-				return 1;
-			}
-		}
-	}
+	int ImageSize = Z->ImageSize;
 
-	if ((*r1 + 1) <= ImageSize) {
-		if (pIB->point[*r1 + 1][*c1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 + 1][*c1] == 'n') { //down
-				*r2 = *r1 + 1;
-				*c2 = *c1;
-				pIB->point[*r1][*c1] = 1;
-				//If this new location is on the edge of the image, ignore it's contribution
-				if ((*c2 != 1) && (*c2 != ImageSize)) {
-					if ((prev[0] == 'D') && (prev[1] == 0)) {
-						(*Straight)++;
-					} else {
-						(*Curvy)++;
-						prev[0] = 'D';
-						prev[1] = 0;
-					}
-				}
-				return 1;
-			}
-		}
-	}
+	pIB->point[*r1] |= (1u << *c1);
 
-	if ((*c1 - 1) > 0) {
-		if (pIB->point[*r1][*c1 - 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1][*c1 - 1] == 'n') { //left
-				*r2 = *r1;
-				*c2 = (*c1) - 1;
-				pIB->point[*r1][*c1] = 1;
-				//If this new location is on the edge of the image, ignore it's contribution
-				if ((*r2 != 1) && (*r2 != ImageSize)) {
-					if ((prev[0] == 'L') && (prev[1] == 0)) {
-						(*Straight)++;
-					} else {
-						(*Curvy)++;
-						prev[0] = 'L';
-						prev[1] = 0;
-					}
-				}
-				return 1;
-			}
-		}
+	//Z->Nbits[] has no "n"s off the edge of the image, so r,c needn't be checked
+	for (s = 0; s < 8; s++) {
+		r = *r1 + Step[s][0];
+		c = *c1 + Step[s][1];
+		if (((Z->Nbits[r] & ~pIB->point[r]) >> c) & 1) break; //an "n" not seen before
 	}
+	if (s == 8) return 0;
 
-	if (((*r1 - 1) > 0) && ((*c1 + 1) <= ImageSize)) {
-		if (pIB->point[*r1 - 1][*c1 + 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 - 1][*c1 + 1] == 'n') { //upper right
-				*r2 = *r1 - 1;
-				*c2 = *c1 + 1;
-				pIB->point[*r1][*c1] = 1;
-				if ((prev[0] == 'U') && (prev[1] == 'R')) {
-					(*Straight)++;
-				} else {
-					(*Curvy)++;
-					prev[0] = 'U';
-					prev[1] = 'R';
-				}
-				return 1;
-			}
-		}
-	}
+	*r2 = r;
+	*c2 = c;
 
-	if (((*r1 + 1) <= ImageSize) && ((*c1 + 1) <= ImageSize)) {
-		if (pIB->point[*r1 + 1][*c1 + 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 + 1][*c1 + 1] == 'n') { //lower right
-				*r2 = *r1 + 1;
-				*c2 = *c1 + 1;
-				pIB->point[*r1][*c1] = 1;
-				if ((prev[0] == 'L') && (prev[1] == 'R')) {
-					(*Straight)++;
-				} else {
-					(*Curvy)++;
-					prev[0] = 'L';
-					prev[1] = 'R';
-				}
-				return 1;
-			}
-		}
-	}
+	//If this new location is on the edge of the image, ignore it's contribution
+	if ((Step[s][4] == 'C') && ((c == 1) || (c == ImageSize))) return 1;
+	if ((Step[s][4] == 'R') && ((r == 1) || (r == ImageSize))) return 1;
 
-	if (((*r1 + 1) <= ImageSize) && ((*c1 - 1) > 0)) {
-		if (pIB->point[*r1 + 1][*c1 - 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 + 1][*c1 - 1] == 'n') { //lower left
-				*r2 = *r1 + 1;
-				*c2 = *c1 - 1;
-				pIB->point[*r1][*c1] = 1;
-				if ((prev[0] == 'L') && (prev[1] == 'L')) {
-					(*Straight)++;
-				} else {
-					(*Curvy)++;
-					prev[0] = 'L';
-					prev[1] = 'L';
-				}
-				return 1;
-			}
-		}
+	if ((prev[0] == Step[s][2]) && (prev[1] == Step[s][3])) {
+		(*Straight)++;
+	} else {
+		(*Curvy)++;
+		prev[0] = (char)Step[s][2];
+		prev[1] = (char)Step[s][3];
 	}
 
-	if (((*r1 - 1) > 0) && ((*c1 - 1) > 0)) {
-		if (pIB->point[*r1 - 1][*c1 - 1] == 0) { //This location has not been seen before
-			if (Z->image[*r1 - 1][*c1 - 1] == 'n') { //upper left
-				*r2 = *r1 - 1;
-				*c2 = *c1 - 1;
-				pIB->point[*r1][*c1] = 1;
-				if ((prev[0] == 'U') && (prev[1] == 'L')) {
-					(*Straight)++;
-				} else {
-					(*Curvy)++;
-					prev[0] = 'U';
-					prev[1] = 'L';
-				}
-				return 1;
-			}
-		}
-	}
- 
-	return 0;
+	return 1;
 }
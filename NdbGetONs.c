@@ -22,10 +22,13 @@ void sortE(NdbData *, RECdata *);
 void LoadONs(NdbData *, RECdata *);
 void addRcount(RECdata *);
 void LoadR(NdbData *, RECdata *, int, int, int, int);
+void ReloadR(NdbData *, RECdata *, int, int, int);
 void StoreResults(NdbData *, RECdata *, int, COMP *);
+int PerfectScore(NdbData *, RECdata *, int);
 int GetPER(NdbData *, RECdata *, int);
 int GetQuality(NdbData *, RECdata *, int);
-float CompositeScore(RECdata *, int);
+void CompositeScore(RECdata *, int);
+int CompareC(Rdata *, Rdata *);
 
 
 int GetONs(NdbData *Ndb, RECdata *pRD) {
@@ -55,6 +58,15 @@ int GetONs(NdbData *Ndb, RECdata *pRD) {
 	pRD->BLcount = 0;
 	pRD->BLblocks = 1;
 
+	//pBL[0] is never used, but the list walks read it when they reach the end (Next=0)
+	pRD->pBL[0].Next = 0;
+	pRD->pBL[0].Prev = 0;
+	pRD->pBL[0].B = INT_MAX; //matches no Bound Section
+	pRD->pBL[0].E = INT_MAX;
+	pRD->pBL[0].qpos = INT_MAX;
+	pRD->pBL[0].dpos = 0;
+	pRD->pBL[0].Skip = 1;
+
 
 	//"Combined" Bound Sections constructed from the initial Bound Sections in pBH/pBL
 	for (i = 0; i < ActualThreads; i++) {
@@ -145,13 +157,7 @@ int GetBoundSections(NdbData *Ndb, RECdata *pRD) {
 	long ic;
 	long ihead, ifirst, ilast, inew, inext, iprev;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		T = clock();
-		printf("\n\nGetBoundSections()...");
-	}
+	StageBegin(pRD, STAGE_BOUNDSECTIONS);
 
 	pRD->BHcount = 0;
 	pRD->BLcount = 0;
@@ -244,11 +250,8 @@ int GetBoundSections(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf(" created %d   runtime: %fsec", pRD->BLcount, runtime);
-	}
+	StageEnd(pRD, STAGE_BOUNDSECTIONS, pRD->BLcount);
+	ExplainStage(pRD, STAGE_BOUNDSECTIONS);
 
 	return pRD->BLcount;
 }
@@ -292,14 +295,9 @@ void mpCombineBoundSections(RECdata *pRD) {
 	//
 	//----------
 
-	clock_t T;
-	double runtime;
 	int th, totc;
 
-	if (ShowProgress == 1) {
-		T = clock();
-		printf("\n\nmpCombineBoundSections()...");
-	}
+	StageBegin(pRD, STAGE_COMBINE);
 
 	//Request ActualThreads from the OS. You may or may not be given this many.
 	//Each thread will work on the Bound Sections belonging to a specific ON
@@ -311,6 +309,9 @@ void mpCombineBoundSections(RECdata *pRD) {
 		int B1, E1, qpos1, dpos1;
 		int B2, E2, qpos2, dpos2;
 		long firstI, I, J, K, ONcode;
+		int Ccount;
+		double t = 0;
+		EXPLAINdata *pX;
 
 		ThreadID = omp_get_thread_num(); //0, 1, 2, ...
 
@@ -318,6 +319,13 @@ void mpCombineBoundSections(RECdata *pRD) {
 		for (ihead = 1; ihead <= pRD->BHcount; ihead++) {
 			ONcode = pRD->pBH[ihead].ONcode; //Every thread has it's own ONcode
 
+			pX = NULL;
+			if (pRD->pX != NULL) { //Explain mode
+				pX = ExplainON(pRD, ONcode);
+				Ccount = pRD->mpCcount[ThreadID];
+				t = omp_get_wtime();
+			}
+
 			//construct combined Bound Sections from any of this ONcode's records
 			I = pRD->pBH[ihead].First;
 			while (I > 0) {
@@ -394,17 +402,18 @@ void mpCombineBoundSections(RECdata *pRD) {
 					I = pRD->pBL[I].Next;
 				}
 			}
+
+			if (pX != NULL) {
+				pX->Combined = pX->Combined + (pRD->mpCcount[ThreadID] - Ccount);
+				pX->Combine = pX->Combine + (omp_get_wtime() - t);
+			}
 		}
 	}
 
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC; //runtime for all threads
-		totc = 0;
-		for (th = 0; th < ActualThreads; th++) totc = totc + pRD->mpCcount[th];
-		printf(" %d new combinations   runtime: %fsec", totc, runtime);
-	}
+	totc = 0;
+	for (th = 0; th < ActualThreads; th++) totc = totc + pRD->mpCcount[th];
+	StageEnd(pRD, STAGE_COMBINE, totc);
 
 }
 
@@ -478,6 +487,7 @@ void mpCombineBound1(RECdata *pRD, int ThreadID, long firstI, long J, int B1, in
 			pRD->mpC[ThreadID][cp].ONcode = ONcode;
 			pRD->mpC[ThreadID][cp].qpos = pRD->pBL[K].qpos;
 			pRD->mpC[ThreadID][cp].dpos = pRD->pBL[K].dpos;
+			pRD->mpC[ThreadID][cp].Skip = 0;
 			mpaddCcount(pRD, ThreadID);
 		}
 		K = pRD->pBL[K].Next;
@@ -580,6 +590,7 @@ void mpCombineBound2(RECdata *pRD, int ThreadID, long firstI, long J, int B1, in
 			pRD->mpC[ThreadID][cp].ONcode = ONcode;
 			pRD->mpC[ThreadID][cp].qpos = pRD->pBL[K].qpos;
 			pRD->mpC[ThreadID][cp].dpos = pRD->pBL[K].dpos;
+			pRD->mpC[ThreadID][cp].Skip = 0;
 			mpaddCcount(pRD, ThreadID);
 		}
 		K = pRD->pBL[K].Next;
@@ -675,14 +686,10 @@ int mpRunHitThreshold(NdbData *Ndb, RECdata *pRD) {
 	int is[INQUIRY_LENGTH];
 	float x;
 	BC *pc;
+	double t = 0;
+	EXPLAINdata *pX;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		T = clock();
-		printf("\n\nmpRunHitThreshold()...");
-	}
+	StageBegin(pRD, STAGE_HIT);
 
 	pRD->Dcount = 0;
 
@@ -690,6 +697,7 @@ int mpRunHitThreshold(NdbData *Ndb, RECdata *pRD) {
 		ONcode = pRD->pBH[ihead].ONcode;
 		len = Ndb->pON[ONcode].Len;
 		I = pRD->pBH[ihead].First;
+		if (pRD->pX != NULL) t = omp_get_wtime(); //Explain mode
 
 		while (I > 0) {
 			if (pRD->pBL[I].Skip == 0) {
@@ -740,6 +748,11 @@ int mpRunHitThreshold(NdbData *Ndb, RECdata *pRD) {
 			}
 			I = pRD->pBL[I].Next;
 		}
+
+		if (pRD->pX != NULL) {
+			pX = ExplainON(pRD, ONcode);
+			pX->Threshold = pX->Threshold + (omp_get_wtime() - t);
+		}
 	}
 
 	for (th = 0; th < ActualThreads; th++) {
@@ -749,6 +762,7 @@ int mpRunHitThreshold(NdbData *Ndb, RECdata *pRD) {
 		for (i = 0; i < pRD->mpCcount[th]; i++) {
 
 			if (pc[i].Skip == 1) continue;
+			if (pRD->pX != NULL) t = omp_get_wtime();
 
 			for (j = 0; j < INQUIRY_LENGTH; j++) is[j] = 0; //clear the qpos list
 			B1 = pc[i].B;
@@ -794,16 +808,18 @@ int mpRunHitThreshold(NdbData *Ndb, RECdata *pRD) {
 				pRD->pD[pRD->Dcount].cntA = 0;
 				addDcount(pRD);
 			}
+
+			if (pRD->pX != NULL) {
+				pX = ExplainON(pRD, ONcode);
+				pX->Threshold = pX->Threshold + (omp_get_wtime() - t);
+			}
 		}
 	}
 
 	if (pRD->Dcount > 0) sortD(pRD);
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf(" %d BoundSections survived  runtime: %fsec", pRD->Dcount, runtime);
-	}
+	StageEnd(pRD, STAGE_HIT, pRD->Dcount);
+	ExplainStage(pRD, STAGE_HIT);
 
 	return pRD->Dcount;
 }
@@ -925,13 +941,7 @@ int RunAnomalyThreshold(NdbData *Ndb, RECdata *pRD) {
 	int cntA;
 	float x;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		T = clock();
-		printf("\nRunAnomalyThreshold()...");
-	}
+	StageBegin(pRD, STAGE_ANOMALY);
 
 	redo = 1;
 	while (redo == 1) {
@@ -1003,11 +1013,8 @@ int RunAnomalyThreshold(NdbData *Ndb, RECdata *pRD) {
 
 	if (pRD->Ecount > 0) sortE(Ndb, pRD);
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf(" %d BoundSections survived  runtime: %fsec", pRD->Ecount, runtime);
-	}
+	StageEnd(pRD, STAGE_ANOMALY, pRD->Ecount);
+	ExplainStage(pRD, STAGE_ANOMALY);
 
 	return pRD->Ecount;
 }
@@ -1089,13 +1096,7 @@ void LoadONs(NdbData *Ndb, RECdata *pRD) {
 
 	int i;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nLoadONs()...");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_LOADONS);
 
 	pRD->Rcount = 0;
 	for (i = 0; i < pRD->Ecount; i++) {
@@ -1103,11 +1104,8 @@ void LoadONs(NdbData *Ndb, RECdata *pRD) {
 		LoadR(Ndb, pRD, pRD->Rcount, pRD->pE[i].B, pRD->pE[i].E, pRD->pE[i].ONcode);
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf(" BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
+	StageEnd(pRD, STAGE_LOADONS, pRD->Rcount);
+	ExplainStage(pRD, STAGE_LOADONS);
 
 }
 
@@ -1119,7 +1117,7 @@ void addRcount(RECdata *pRD) {
 
 	pRD->Rcount++;
 
-	if ((pRD->Rcount % R_RECORDS) == 0) { // The list is full
+	if (pRD->Rcount >= (pRD->Rblocks * R_RECORDS)) { // The list is full
 		pRD->Rblocks++;
 		pRD->pR = (Rdata *)realloc(pRD->pR, (pRD->Rblocks * R_RECORDS * sizeof(Rdata))); //pRD->pR[B,E,ON,...]
 	}
@@ -1132,21 +1130,41 @@ void LoadR(NdbData *Ndb, RECdata *pRD, int Index, int B, int E, int ONcode) {
 	//
 	//----------
 
-	int j;
-	int res;
+	pRD->pR[Index].ONcode = ONcode;
+	pRD->pR[Index].Perfect = PerfectScore(Ndb, pRD, ONcode); //Needed by GetPER()
+	pRD->pR[Index].B = -1; //There's no SCU data to start from
 
-	//Memory for the 2 competitors
+	ReloadR(Ndb, pRD, Index, B, E);
+}
+
+void ReloadR(NdbData *Ndb, RECdata *pRD, int Index, int B, int E) {
+	//
+	//	Give pRD->pR[Index] new boundaries, B...E, and reload its competition data.
+	//	The results are exactly what LoadR() would give.
+	//
+	//	The SCU scans the Input Stream from the Begin Boundary, and each qpos depends only
+	//	on the ones before it. So if B hasn't changed, the scan so far is kept: the RN hits
+	//	in qpos[], dpos[], rn[], and the running Stand-Alone Score in Scan[]. Moving the End
+	//	Boundary back just drops what's beyond it, and moving it forward scans only the new
+	//	positions. A new Begin Boundary has to be scanned from the start.
+	//
+	//----------
+
+	int j, n;
+	int qpos;
+	int start;
+	double t = 0;
+
+	//Memory for the competitor
 	COMP A;
-	COMP Z;
 
-	//All it takes to ignore "Z" as a competitor is this:
-	Z.Mcount = 0;
+	if (pRD->pX != NULL) t = omp_get_wtime(); //Explain mode
 
 	// Load the "A" competitor with 'minimal' identifying data
 	A.Mcount = 1; //This competitor is comprised of a single ON
 	A.m[0].B = B;
 	A.m[0].E = E;
-	A.m[0].ONcode = ONcode;
+	A.m[0].ONcode = pRD->pR[Index].ONcode;
 	A.m[0].nrec = 0; // number of hits in .order[]
 	for (j = 0; j < INQUIRY_LENGTH; j++) {
 		A.m[0].RLhit[j] = 0;
@@ -1167,8 +1185,37 @@ void LoadR(NdbData *Ndb, RECdata *pRD, int Index, int B, int E, int ONcode) {
 	A.mislead = 0;
 	for (j = 0; j < INQUIRY_LENGTH; j++) A.SpaceClaim[j] = 0;
 
-	// Run this fake 'competition' to load "A" with its competition data
-	res = RunSCU(Ndb, pRD, &A, &Z);
+	start = B;
+	if ((B == pRD->pR[Index].B) && (B <= E) && (B <= pRD->pR[Index].E)) {
+		//Pick up the scan where it ends, or where the new End Boundary is
+		n = 0;
+		for (j = 0; j < INQUIRY_LENGTH; j++) {
+			qpos = pRD->pR[Index].qpos[j];
+			if ((qpos == 0) || (qpos > E)) break;
+			n++;
+			A.m[0].order[n].dpos = pRD->pR[Index].dpos[j];
+			A.m[0].order[n].qpos = qpos;
+			A.m[0].order[n].rn = pRD->pR[Index].rn[j];
+			A.m[0].RLhit[pRD->pR[Index].dpos[j] - 1] = 1;
+		}
+		A.m[0].nrec = n;
+
+		if (E <= pRD->pR[Index].E) {
+			A.Score = pRD->pR[Index].Scan[E];
+			start = E + 1;
+		} else {
+			A.Score = pRD->pR[Index].Scan[pRD->pR[Index].E];
+			start = pRD->pR[Index].E + 1;
+		}
+	}
+
+	//The same scan RunSCU() would do, with no second competitor
+	for (qpos = start; qpos <= E; qpos++) {
+		A.Score = SetScore(Ndb, pRD, &A, qpos);
+		pRD->pR[Index].Scan[qpos] = A.Score;
+	}
+
+	if (pRD->pX != NULL) ExplainScan(pRD, pRD->pR[Index].ONcode, (pRD->pR[Index].B != -1), omp_get_wtime() - t);
 
 	StoreResults(Ndb, pRD, Index, &A);
 }
@@ -1217,7 +1264,7 @@ void StoreResults(NdbData *Ndb, RECdata *pRD, int Index, COMP *pA) {
 		
 		pRD->pR[Index].cntA = 0; //This count will be made AFTER any upcoming boundary adjustments
 
-		pRD->pR[Index].C = CompositeScore(pRD, Index); //depends on all the above data
+		CompositeScore(pRD, Index); //depends on all the above data
 
 		//Is this ON reognized by ALL of its RNs, even if some are out-of-order?
 		pRD->pR[Index].ALL = 1;  //assume yes
@@ -1238,21 +1285,15 @@ void StoreResults(NdbData *Ndb, RECdata *pRD, int Index, COMP *pA) {
 	}
 }
 
-int GetPER(NdbData *Ndb, RECdata *pRD, int Index) {
+int PerfectScore(NdbData *Ndb, RECdata *pRD, int ONcode) {
 	//
-	//	To get the %recognition for this ON:
-	//
-	//	Get the 'perfect' score as if ALL RNs in the ON were recognized in the correct order.
-	//	The %recognition (PER) is then the Stand-Alone Score from the Input Stream divided by
-	//	this 'perfect' score
+	//	Get the 'perfect' score of an ON: its Stand-Alone Score as if ALL the RNs in its
+	//	Recognition List were recognized in the correct order. It depends only on the ON,
+	//	so it's kept in pRD->pR[].Perfect and not run again when the boundaries change.
 	//
 	//----------
 
-	int ONcode;
-	int PER;
-	int score;
-	int i, j;
-	int rn, fnd;
+	int j;
 	int len;
 	int temp[INQUIRY_LENGTH+1];
 
@@ -1260,8 +1301,6 @@ int GetPER(NdbData *Ndb, RECdata *pRD, int Index) {
 	COMP W;
 	COMP Y;
 
-	ONcode = pRD->pR[Index].ONcode;
-
 	//Call the SCU with a single, perfect ON, and no second competitor 'W'
 	W.Mcount = 0;
 
@@ -1315,6 +1354,28 @@ int GetPER(NdbData *Ndb, RECdata *pRD, int Index) {
 		if (pRD->ISRN[j] == 0) break;
 	}
 
+	return Y.Score;
+}
+
+int GetPER(NdbData *Ndb, RECdata *pRD, int Index) {
+	//
+	//	To get the %recognition for this ON:
+	//
+	//	The %recognition (PER) is the Stand-Alone Score from the Input Stream divided by
+	//	the ON's 'perfect' score, pRD->pR[Index].Perfect - see PerfectScore()
+	//
+	//----------
+
+	int ONcode;
+	int PER;
+	int score;
+	int i;
+	int rn, fnd;
+	int len;
+	int temp[INQUIRY_LENGTH+1];
+
+	ONcode = pRD->pR[Index].ONcode;
+
 	score = pRD->pR[Index].Score; //This is the non-perfect score from the Input Stream
 
 	//Reduce the Stand-Alone Score from the Input Stream if there are any repetitions in dpos[]
@@ -1339,10 +1400,10 @@ int GetPER(NdbData *Ndb, RECdata *pRD, int Index) {
 	pRD->pR[Index].Score = score;
 
 
-	if ((score == 0) || (Y.Score == 0)) {
+	if ((score == 0) || (pRD->pR[Index].Perfect == 0)) {
 		PER = 0;
 	} else {
-		PER = (int)(((float)score/(float)Y.Score) * 100.0);
+		PER = (int)(((float)score/(float)pRD->pR[Index].Perfect) * 100.0);
 	}
 	if (PER > 100) PER = 100;
 
@@ -1373,7 +1434,7 @@ int GetQuality(NdbData *Ndb, RECdata *pRD, int Index) {
 	return q;
 }
 
-float CompositeScore(RECdata *pRD, int Index) {
+void CompositeScore(RECdata *pRD, int Index) {
 	//
 	//	Create a combined-score from various measurements to help differentiate ONs
 	//
@@ -1383,31 +1444,37 @@ float CompositeScore(RECdata *pRD, int Index) {
  	//	pRD->pR[Index].dpos = positions recognized in the Output Neuron's Recognition List
 	//	pRD->pR[Index].PER = %recognized
 	//	pRD->pR[Index].QUAL = quality of recognition (smaller is better)
+	//
+	//	C = (pr * pr * ln * ln) / qu, divided by 10 for every anomaly: pr = PER/100,
+	//	ln = length of the Bound Section, qu = QUAL + 1. It's all done in integers so
+	//	the scores come out the same with any compiler. The parts are stored as well:
+	//	Cn = PER*PER*ln*ln, Cq = qu, Cexp = number of anomalies, and C is the value in
+	//	units of 1/C_UNIT for adding up scores and testing thresholds.
 	//	
 	//---------
 
-	int i, p, fnd;
-	int len;
-	int qpos, dpos1, dpos2;
+	int i, p;
+	int len, ln;
+	int qpos;
 	int Arn, Ais; //anomaly counts
-	float pr;
-	float ln;
-	float qu;
-	float C;
-
+	unsigned long long hit[2]; //bitmask of the qpos list, bit p = position p
+	long long C;
+	static const long long pow10[17] = {1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL,
+										10000000LL, 100000000LL, 1000000000LL, 10000000000LL,
+										100000000000LL, 1000000000000LL, 10000000000000LL,
+										100000000000000LL, 1000000000000000LL, 10000000000000000LL};
 
 	//Ais is the number of missing positions in the Bound Section from the Input Stream
+	hit[0] = 0;
+	hit[1] = 0;
+	for (i = 0; i < INQUIRY_LENGTH; i++) {
+		qpos = pRD->pR[Index].qpos[i];
+		if (qpos == 0) break; //end of list
+		hit[qpos >> 6] = hit[qpos >> 6] | (1ULL << (qpos & 63));
+	}
 	Ais = 0;
-	for (p = pRD->pR[Index].B; p <= pRD->pR[Index].E; p++) { //Is position p in the qpos list?
-		fnd = 0;
-		for (i = 0; i < INQUIRY_LENGTH; i++) {
-			qpos = pRD->pR[Index].qpos[i];
-			if (qpos == 0) break; //end of list
-			if (qpos != p) continue;
-			fnd = 1;
-			break;
-		}
-		if (fnd == 0) Ais++;
+	for (p = pRD->pR[Index].B; p <= pRD->pR[Index].E; p++) {
+		if ((hit[p >> 6] & (1ULL << (p & 63))) == 0) Ais++;
 	}
 
 	//Arn is the number of anomalies in the order of RNs from the ON's Recognition List
@@ -1415,22 +1482,56 @@ float CompositeScore(RECdata *pRD, int Index) {
 	for (len = 0; len < INQUIRY_LENGTH; len++) if (pRD->pR[Index].dpos[len] == 0) break;
 
 	for (i = 0; i < (len - 1); i++) {
-		dpos1 = pRD->pR[Index].dpos[i];
-		dpos2 = pRD->pR[Index].dpos[i+1];
-		if ((dpos2 - dpos1) != 1) Arn = Arn + 2;
+		if ((pRD->pR[Index].dpos[i+1] - pRD->pR[Index].dpos[i]) != 1) Arn = Arn + 2;
 	}
 	Arn = Arn / 3 ; //RN anomalies are not quite as bad as QPOS anomalies
 
-	pr = (float)pRD->pR[Index].PER / 100.0;
-	ln = (float)(pRD->pR[Index].E - pRD->pR[Index].B + 1); //length of this Bound Section
-	qu = (float)(pRD->pR[Index].QUAL + 1); //QUAL = 0, 1, 2, ...
+	ln = pRD->pR[Index].E - pRD->pR[Index].B + 1; //length of this Bound Section
+
+	pRD->pR[Index].Cn = pRD->pR[Index].PER * pRD->pR[Index].PER * ln * ln;
+	pRD->pR[Index].Cq = pRD->pR[Index].QUAL + 1; //QUAL = 0, 1, 2, ...
+	pRD->pR[Index].Cexp = Ais + Arn;
+
+	//C_UNIT / 10000 = 10^8, and Cn * 10^8 stays below 10^16
+	C = 0;
+	if (pRD->pR[Index].Cexp <= 16) {
+		C = ((long long)pRD->pR[Index].Cn * 100000000LL) / ((long long)pRD->pR[Index].Cq * pow10[pRD->pR[Index].Cexp]);
+	}
+	pRD->pR[Index].C = C;
+}
 
-	C = (pr * pr * ln * ln) / qu;
+int CompareC(Rdata *pA, Rdata *pZ) {
+	//
+	//	Compare the exact Composite Scores of two ONs
+	//
+	//	Returns:	1 if A is higher, -1 if Z is higher, 0 if they are equal
+	//
+	//	A: Cn / (Cq * 10^Cexp) vs. Z: Cn / (Cq * 10^Cexp) --> compare the cross products.
+	//	Cn * Cq is less than 10^10, so a difference of 10 or more anomalies settles it.
+	//
+	//---------
+
+	long long a, z;
+	int d;
+
+	a = (long long)pA->Cn * (long long)pZ->Cq;
+	z = (long long)pZ->Cn * (long long)pA->Cq;
+
+	if ((a == 0) || (z == 0)) {
+		if (a > z) return 1;
+		if (z > a) return -1;
+		return 0;
+	}
 
-	for (i = 0; i < Ais; i++) C = C / 10.0;
-	for (i = 0; i < Arn; i++)  C = C / 10.0;
+	d = pZ->Cexp - pA->Cexp;
+	if (d >= 10) return 1;
+	if (d <= -10) return -1;
+	for (; d > 0; d--) a = a * 10;
+	for (; d < 0; d++) z = z * 10;
 
-	return C;
+	if (a > z) return 1;
+	if (z > a) return -1;
+	return 0;
 }
 
 
@@ -0,0 +1,209 @@
+﻿//The Neural Database - Direct lookup of the ONs of an IMAGE_28X28 Ndb
+//(c) Copyright 2024 Gary J. Lassiter. All Rights Reserved.
+
+#include <ndb.h>
+
+
+//Every image ON has a Recognition List of exactly NUMBER_OF_IMAGE_RNS RNs, and since
+//ImageFormatter() gives each position its own range of RN values, an RN can only ever be
+//in one position. So the ONs nearest to an inquiry image are simply those whose RLs differ
+//from it in the fewest positions (the Hamming distance). Those are found here by hashing:
+//the whole RL finds an exact match, and each of IMAGE_LOOKUP_PARTS parts of the RL finds
+//every ON within IMAGE_LOOKUP_PARTS - 1 positions, because at least one of its parts has
+//to match exactly. See RunImageView() for when RecognizeINPUT() is still used.
+
+
+//Functions:
+int IndexImageONs(NdbData *);
+void FreeImageIndex(NdbData *);
+unsigned int HashImageParts(int *, int, int);
+int LookupImage(NdbData *, int *, long *, int *);
+int ImageDistance(NdbData *, long, int *, int);
+
+
+int IndexImageONs(NdbData *Ndb) {
+	//
+	//	Build Ndb->pIndex: hash chains of the ONs by their whole RL, and by each part of it
+	//
+	//	Returns:	0 for success, 1 for no memory (Ndb->pIndex stays NULL)
+	//
+	//----------
+
+	ImageIndex *pX;
+	long ONcode;
+	long slot;
+	int t, b, e;
+
+	pX = (ImageIndex *)malloc(sizeof(ImageIndex));
+	if (pX == NULL) return 1;
+
+	//At least twice as many slots as ONs, so the chains stay short
+	pX->Size = 1024;
+	while (pX->Size < (2 * Ndb->ONcount)) pX->Size = 2 * pX->Size;
+
+	for (t = 0; t <= IMAGE_LOOKUP_PARTS; t++) {
+		pX->pHead[t] = (long *)calloc(pX->Size, sizeof(long));
+		pX->pNext[t] = (long *)malloc((Ndb->ONcount + 1) * sizeof(long));
+		if ((pX->pHead[t] == NULL) || (pX->pNext[t] == NULL)) {
+			for (; t >= 0; t--) {
+				free(pX->pHead[t]);
+				free(pX->pNext[t]);
+			}
+			free(pX);
+			return 1;
+		}
+	}
+
+	//Table 0 is the whole RL, tables 1 ... IMAGE_LOOKUP_PARTS are RL[b] ... RL[e - 1]
+	for (ONcode = Ndb->ONcount; ONcode > 0; ONcode--) { //backwards, so each chain is in ONcode order
+		for (t = 0; t <= IMAGE_LOOKUP_PARTS; t++) {
+			b = 0;
+			e = NUMBER_OF_IMAGE_RNS;
+			if (t > 0) {
+				b = ((t - 1) * NUMBER_OF_IMAGE_RNS) / IMAGE_LOOKUP_PARTS;
+				e = (t * NUMBER_OF_IMAGE_RNS) / IMAGE_LOOKUP_PARTS;
+			}
+			slot = HashImageParts(Ndb->pON[ONcode].RL, b, e) & (pX->Size - 1);
+			pX->pNext[t][ONcode] = pX->pHead[t][slot];
+			pX->pHead[t][slot] = ONcode;
+		}
+	}
+
+	Ndb->pIndex = pX;
+	return 0;
+}
+
+void FreeImageIndex(NdbData *Ndb) {
+	//
+	//	Free Ndb->pIndex, if there is one
+	//
+	//----------
+
+	int t;
+
+	if (Ndb->pIndex == NULL) return;
+
+	for (t = 0; t <= IMAGE_LOOKUP_PARTS; t++) {
+		free(Ndb->pIndex->pHead[t]);
+		free(Ndb->pIndex->pNext[t]);
+	}
+	free(Ndb->pIndex);
+	Ndb->pIndex = NULL;
+}
+
+unsigned int HashImageParts(int *RL, int b, int e) {
+	//
+	//	FNV-1a hash of the RNcodes RL[b] ... RL[e - 1]
+	//
+	//----------
+
+	unsigned int h;
+	int k;
+
+	h = 2166136261u;
+	for (k = b; k < e; k++) {
+		h ^= (unsigned int)RL[k];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+int LookupImage(NdbData *Ndb, int *RL, long *pONcodes, int *Count) {
+	//
+	//	Find the ONs of Ndb nearest to the inquiry RL[0] ... RL[NUMBER_OF_IMAGE_RNS - 1] (the
+	//	RNcodes of the inquiry image, in position order): all those whose RLs match it
+	//	exactly, or if there are none, all those that differ from it in the fewest positions,
+	//	as long as that's no more than IMAGE_LOOKUP_PARTS - 1.
+	//
+	//	Their ONcodes go in pONcodes[1] ... pONcodes[*Count], and the distance in positions
+	//	is returned.
+	//	When there's nothing near enough, or too many nearest ONs to fit in the results
+	//	(TOTAL_ALLOWED_RESULTS), or too many candidates in a chain, -1 is returned and
+	//	the inquiry has to go through RecognizeINPUT() after all.
+	//
+	//----------
+
+	ImageIndex *pX;
+	long ONcode;
+	long slot;
+	long checked;
+	int count;
+	int best;
+	int d;
+	int i, t, b, e;
+
+	pX = Ndb->pIndex;
+
+	//Exact matches: the whole RL
+	count = 0;
+	slot = HashImageParts(RL, 0, NUMBER_OF_IMAGE_RNS) & (pX->Size - 1);
+	for (ONcode = pX->pHead[0][slot]; ONcode != 0; ONcode = pX->pNext[0][ONcode]) {
+		if (ImageDistance(Ndb, ONcode, RL, 1) != 0) continue;
+		if (count == TOTAL_ALLOWED_RESULTS) return -1;
+		count++;
+		pONcodes[count] = ONcode;
+	}
+	if (count > 0) {
+		*Count = count;
+		return 0;
+	}
+
+	//Near matches: every ON within IMAGE_LOOKUP_PARTS - 1 positions shares at least one part
+	best = IMAGE_LOOKUP_PARTS - 1;
+	checked = 0;
+	for (t = 1; t <= IMAGE_LOOKUP_PARTS; t++) {
+		b = ((t - 1) * NUMBER_OF_IMAGE_RNS) / IMAGE_LOOKUP_PARTS;
+		e = (t * NUMBER_OF_IMAGE_RNS) / IMAGE_LOOKUP_PARTS;
+		slot = HashImageParts(RL, b, e) & (pX->Size - 1);
+		for (ONcode = pX->pHead[t][slot]; ONcode != 0; ONcode = pX->pNext[t][ONcode]) {
+			checked++;
+			if (checked > IMAGE_LOOKUP_CANDIDATES) return -1; //A common part (a blank panel?)
+
+			d = ImageDistance(Ndb, ONcode, RL, best + 1);
+			if (d > best) continue;
+			if (d < best) {
+				best = d;
+				count = 0;
+			}
+			for (i = 1; i <= count; i++) {
+				if (pONcodes[i] == ONcode) break; //already found through another part
+			}
+			if (i <= count) continue;
+			if (count == TOTAL_ALLOWED_RESULTS) return -1;
+			count++;
+			pONcodes[count] = ONcode;
+		}
+	}
+	if (count == 0) return -1;
+	*Count = count;
+
+	//Keep them in ONcode order, like the exact matches
+	for (i = 2; i <= count; i++) {
+		ONcode = pONcodes[i];
+		for (t = i; (t > 1) && (pONcodes[t - 1] > ONcode); t--) pONcodes[t] = pONcodes[t - 1];
+		pONcodes[t] = ONcode;
+	}
+
+	return best;
+}
+
+int ImageDistance(NdbData *Ndb, long ONcode, int *RL, int limit) {
+	//
+	//	The number of positions where ONcode's RL differs from RL[], counting no further
+	//	than limit
+	//
+	//----------
+
+	int d;
+	int k;
+
+	d = 0;
+	for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) {
+		if (Ndb->pON[ONcode].RL[k] == RL[k]) continue;
+		d++;
+		if (d >= limit) break;
+	}
+
+	return d;
+}
@@ -0,0 +1,348 @@
+﻿//The Neural Database - The binary MNIST image store
+//(c) Copyright 2024 Gary J. Lassiter. All Rights Reserved.
+
+#include <ndb.h>
+
+
+//Functions:
+MNISTimage *LoadMNIST(char *, long, long *);
+long ReadMNISTstore(char *, MNISTimage *, long);
+int WriteMNISTstore(char *, MNISTimage *, long);
+long ImportMNISTtext(char *, MNISTimage *, long, long);
+int ParseMNIST(char *, MNISTimage *);
+long ImportMNISTidx(char *, char *, MNISTimage *, long);
+long ReadBigEndian(FILE *);
+
+
+MNISTimage *LoadMNIST(char *Set, long NumberOfImages, long *Count) {
+	//
+	//	Get up to NumberOfImages images of the MNIST "train" or "test" Set into memory:
+	//	pIMG[1], pIMG[2], ... pIMG[*Count]
+	//
+	//	They come from the binary image store, mnist_train.bin or mnist_test.bin. If there's
+	//	no store yet, it's made from the text files, mnist_train_1.txt ... or mnist_test.txt,
+	//	or if those aren't there, from the original MNIST IDX files. Delete the store to have
+	//	it made again.
+	//
+	//	The store is a header followed by fixed-length records, already in memory order, so
+	//	it's read with one fread() (it could just as well be memory-mapped).
+	//
+	//	Returns:	the images (free() them), or NULL
+	//
+	//----------
+
+	MNISTimage *pIMG;
+	char StoreFile[32];
+	char TextFile[32];
+	char IDXimages[32];
+	char IDXlabels[32];
+	long n;
+	int f;
+	FILE *fh;
+	clock_t T;
+	double runtime;
+
+	*Count = 0;
+	pIMG = (MNISTimage *)malloc((NumberOfImages+1) * sizeof(MNISTimage)); //pIMG[0] isn't used
+	if (pIMG == NULL) {
+		printf("\nERROR: No memory for %ld MNIST images", NumberOfImages);
+		return NULL;
+	}
+
+	sprintf(StoreFile, "mnist_%s.bin", Set);
+	n = ReadMNISTstore(StoreFile, pIMG, NumberOfImages);
+	if (n > 0) {
+		*Count = n;
+		return pIMG;
+	}
+	if (n < 0) { //It's there, but it's not an image store
+		free(pIMG);
+		return NULL;
+	}
+
+	printf("\nMaking the image store %s...", StoreFile);
+	T = clock();
+
+	//The text files: mnist_test.txt, or mnist_train_1.txt, mnist_train_2.txt, ...
+	sprintf(TextFile, "mnist_%s.txt", Set);
+	fh = fopen(TextFile, "r");
+	if (fh != NULL) {
+		fclose(fh);
+		n = ImportMNISTtext(TextFile, pIMG, 0, NumberOfImages);
+	} else {
+		for (f = 1; n < NumberOfImages; f++) {
+			sprintf(TextFile, "mnist_%s_%d.txt", Set, f);
+			fh = fopen(TextFile, "r");
+			if (fh == NULL) break;
+			fclose(fh);
+			n = ImportMNISTtext(TextFile, pIMG, n, NumberOfImages);
+		}
+	}
+
+	//...or the original IDX files: t10k-images-idx3-ubyte, or train-images-idx3-ubyte
+	if (n == 0) {
+		if (strcmp(Set, "test") == 0) {
+			strcpy(IDXimages, "t10k-images-idx3-ubyte");
+			strcpy(IDXlabels, "t10k-labels-idx1-ubyte");
+		} else {
+			sprintf(IDXimages, "%s-images-idx3-ubyte", Set);
+			sprintf(IDXlabels, "%s-labels-idx1-ubyte", Set);
+		}
+		n = ImportMNISTidx(IDXimages, IDXlabels, pIMG, NumberOfImages);
+	}
+
+	if (n == 0) {
+		printf("\nERROR: Failed to find any images in %s, mnist_%s.txt, or %s", StoreFile, Set, IDXimages);
+		printf("\nThe text line format should be 'digit,pixel,pixel,...'\n");
+		free(pIMG);
+		return NULL;
+	}
+
+	if (WriteMNISTstore(StoreFile, pIMG, n) != 0) {
+		printf("\nERROR: Failed to write %s, the images will be read from the text files again next time", StoreFile);
+	}
+
+	T = clock() - T;
+	runtime = ((double)T) / CLOCKS_PER_SEC;
+	printf("\n%ld images in %fsec", n, runtime);
+
+	*Count = n;
+	return pIMG;
+}
+
+long ReadMNISTstore(char *StoreFile, MNISTimage *pIMG, long NumberOfImages) {
+	//
+	//	Read up to NumberOfImages images from the binary image store into pIMG[1]...
+	//
+	//	Returns:	the number of images, 0 if there's no store, -1 if it's no good
+	//
+	//----------
+
+	FILE *fh;
+	MNISTstore H;
+	long n;
+
+	fh = fopen(StoreFile, "rb");
+	if (fh == NULL) return 0;
+
+	n = -1;
+	if (fread(&H, sizeof(MNISTstore), 1, fh) == 1) {
+		if ((memcmp(H.Magic, "NDBMNIST", 8) == 0) && (H.Version == 1)
+			&& (H.Size == MAX_IMAGE_SIZE) && (H.Record == sizeof(MNISTimage))) {
+			n = H.Count;
+			if (n > NumberOfImages) n = NumberOfImages;
+			if ((long)fread(&pIMG[1], sizeof(MNISTimage), n, fh) != n) n = -1;
+		}
+	}
+	fclose(fh);
+
+	if (n < 0) printf("\nERROR: %s is not an image store for this version of the Ndb, delete it to have it made again", StoreFile);
+
+	return n;
+}
+
+int WriteMNISTstore(char *StoreFile, MNISTimage *pIMG, long Count) {
+	//
+	//	Write pIMG[1]...pIMG[Count] to the binary image store
+	//
+	//	Returns:	0 if OK, 1 if not
+	//
+	//----------
+
+	FILE *fh;
+	MNISTstore H;
+	int er;
+
+	memset(&H, 0, sizeof(MNISTstore));
+	memcpy(H.Magic, "NDBMNIST", 8);
+	H.Version = 1;
+	H.Count = Count;
+	H.Size = MAX_IMAGE_SIZE;
+	H.Record = sizeof(MNISTimage);
+
+	fh = fopen(StoreFile, "wb");
+	if (fh == NULL) return 1;
+
+	er = 0;
+	if (fwrite(&H, sizeof(MNISTstore), 1, fh) != 1) er = 1;
+	if ((long)fwrite(&pIMG[1], sizeof(MNISTimage), Count, fh) != Count) er = 1;
+	if (fclose(fh) != 0) er = 1;
+
+	if (er == 1) remove(StoreFile); //Don't leave half a store behind
+
+	return er;
+}
+
+long ImportMNISTtext(char *TextFile, MNISTimage *pIMG, long n, long NumberOfImages) {
+	//
+	//	Add the images in TextFile to pIMG[n+1]..., up to NumberOfImages in all
+	//
+	//	Returns:	the number of images in pIMG[] now
+	//
+	//----------
+
+	FILE *fh;
+	char line[IMAGE_LENGTH+8]; //ParseMNIST() needs 8 bytes of room after the line
+	long first;
+	double bytes;
+	double runtime;
+
+	fh = fopen(TextFile, "r");
+	if (fh == NULL) return n;
+
+	first = n;
+	bytes = 0;
+	runtime = omp_get_wtime(); //A line parses in a few microseconds, so the whole loop is timed
+	while ((n < NumberOfImages) && (fgets(line, IMAGE_LENGTH, fh) != NULL)) {
+		if (ParseMNIST(line, &pIMG[n+1]) != 0) continue; //Not an image, e.g. an empty line
+		bytes += strlen(line);
+		n++;
+	}
+	runtime = omp_get_wtime() - runtime;
+	fclose(fh);
+
+	printf("\n  %s: %ld images, %.1fMB of pixels", TextFile, n - first, bytes / 1048576);
+	if (runtime > 0) printf(" read and parsed at %.0fMB/s", (bytes / 1048576) / runtime);
+
+	return n;
+}
+
+int ParseMNIST(char *line, MNISTimage *pI) {
+	//
+	//	Convert a line from the MNIST text files, 'digit,pixel,pixel,...', into an image
+	//
+	//	In order to reduce the size of these MNIST image files, all pixels of value 0
+	//	have been removed except for any 0 at the end of a line. So an empty pixel is a 0,
+	//	and so is any pixel missing at the end.
+	//
+	//	The line is read a word at a time rather than a character at a time (SWAR, "SIMD
+	//	within a register"): a word of 8 commas is 8 empty pixels at once, and the digits
+	//	of a pixel value are found in one 4-byte word. The words are little-endian, the
+	//	first character in the lowest byte, as on every Windows PC. line[] must have room
+	//	for 8 more bytes after the end of the line, since a word can run past it.
+	//
+	//	Returns:	0 if OK, 1 if the line isn't an image
+	//
+	//----------
+
+	int p;
+	int px;
+	int i;
+	int len;
+	unsigned long long w8;
+	unsigned int w, nd;
+
+	if ((line[0] < '0') || (line[0] > '9') || (line[1] != ',')) return 1;
+
+	pI->digit = line[0];
+
+	p = 2; //start reading the pixels from here
+	i = 0;
+	while (i < MNIST_PIXELS) {
+		//8 empty pixels: ",,,,,,,,"
+		if ((i + 8) <= MNIST_PIXELS) {
+			memcpy(&w8, &line[p], 8);
+			if (w8 == 0x2C2C2C2C2C2C2C2CULL) {
+				memset(&pI->pixel[i], 0, 8);
+				i += 8;
+				p += 8;
+				continue;
+			}
+		}
+
+		//The digits '0' - '9' become 0 - 9 in w, and nd has the high bits of every byte
+		//that isn't a digit. The pixel value is the digits before the first of those.
+		memcpy(&w, &line[p], 4);
+		w ^= 0x30303030u;
+		nd = ((w + 0x06060606u) | w) & 0xF0F0F0F0u;
+		if ((nd & 0x000000FFu) != 0) {
+			len = 0; //an empty pixel
+			px = 0;
+		} else if ((nd & 0x0000FF00u) != 0) {
+			len = 1;
+			px = w & 0x0F;
+		} else if ((nd & 0x00FF0000u) != 0) {
+			len = 2;
+			px = ((w & 0x0F) * 10) + ((w >> 8) & 0x0F);
+		} else {
+			len = 3;
+			px = ((w & 0x0F) * 100) + (((w >> 8) & 0x0F) * 10) + ((w >> 16) & 0x0F);
+			while ((line[p+len] >= '0') && (line[p+len] <= '9')) { //hardly ever
+				px = (px * 10) + (line[p+len] - '0');
+				if (px > 255) px = 256; //255 in the end, without overflowing
+				len++;
+			}
+		}
+		p += len;
+
+		if (px > 255) px = 255;
+		pI->pixel[i] = (unsigned char)px;
+		i++;
+		if (line[p] != ',') break; //the end of the line, the rest are 0
+		p++;
+	}
+	if (i < MNIST_PIXELS) memset(&pI->pixel[i], 0, MNIST_PIXELS - i);
+
+	return 0;
+}
+
+long ImportMNISTidx(char *IDXimages, char *IDXlabels, MNISTimage *pIMG, long NumberOfImages) {
+	//
+	//	Read the original MNIST IDX files: IDXimages has 28x28 pixel bytes for each image,
+	//	IDXlabels a byte for each digit. Both start with big-endian 32 bit integers:
+	//		images: 0x00000803, count, rows, columns
+	//		labels: 0x00000801, count
+	//
+	//	Returns:	the number of images in pIMG[1]..., 0 if there are none
+	//
+	//----------
+
+	FILE *fhi;
+	FILE *fhl;
+	long n, count;
+	int label;
+
+	fhi = fopen(IDXimages, "rb");
+	if (fhi == NULL) return 0;
+	fhl = fopen(IDXlabels, "rb");
+	if (fhl == NULL) {
+		printf("\nERROR: Found %s but not %s", IDXimages, IDXlabels);
+		fclose(fhi);
+		return 0;
+	}
+
+	n = 0;
+	if ((ReadBigEndian(fhi) == 0x803) && (ReadBigEndian(fhl) == 0x801)) {
+		count = ReadBigEndian(fhi);
+		if (ReadBigEndian(fhl) < count) count = 0; //The labels don't match the images
+		if ((ReadBigEndian(fhi) != MAX_IMAGE_SIZE) || (ReadBigEndian(fhi) != MAX_IMAGE_SIZE)) count = 0;
+		if (count > NumberOfImages) count = NumberOfImages;
+
+		while (n < count) {
+			label = fgetc(fhl);
+			if ((label < 0) || (label > 9)) break;
+			if (fread(pIMG[n+1].pixel, 1, MNIST_PIXELS, fhi) != MNIST_PIXELS) break;
+			pIMG[n+1].digit = (char)('0' + label);
+			n++;
+		}
+	}
+	if (n == 0) printf("\nERROR: %s and %s are not MNIST IDX files", IDXimages, IDXlabels);
+
+	fclose(fhi);
+	fclose(fhl);
+
+	return n;
+}
+
+long ReadBigEndian(FILE *fh) {
+	//
+	//	Read a big-endian 32 bit integer from the file
+	//
+	//----------
+
+	unsigned char b[4];
+
+	if (fread(b, 1, 4, fh) != 4) return -1;
+
+	return ((long)b[0] << 24) | ((long)b[1] << 16) | ((long)b[2] << 8) | (long)b[3];
+}
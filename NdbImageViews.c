@@ -0,0 +1,414 @@
+﻿//The Neural Database - The multi-view image store: all the image Ndbs in one file
+//(c) Copyright 2024 Gary J. Lassiter. All Rights Reserved.
+
+#include <ndb.h>
+
+
+//Each of the 399 image Ndbs (#2000+) is a different view of the same MNIST Training Set
+//images, so their .ndb files all repeat the same image names, each one with its own RN
+//table, ON array and RN-->ON connections. The multi-view image store keeps the image
+//names (and labels) once, in a table shared by all the views, and for each view only its
+//RN values and, for each ON, the name it points to, its Surrogate, and its RL. An image
+//ON's RN-->ON connections are just its RL in position order, so they aren't stored at all.
+//
+//While the store is resident (ViewStore.Views > 0), LoadNdb() gets the image Ndbs from it
+//instead of from their .ndb files: see LoadImageView().
+
+
+//Functions:
+int BuildImageStore(void);
+int AddImageView(ImageStore *, NdbData *, ImageView *, long *, long **, long *);
+int WriteImageStore(ImageStore *, char *);
+int LoadImageStore(void);
+int FindImageView(int);
+int LoadImageView(NdbData *, int);
+void FreeImageStore(ImageStore *);
+
+
+int BuildImageStore(void) {
+	//
+	//	Make the multi-view image store, ImageStoreFile, from the 399 image Ndb .ndb files
+	//	and keep it resident.
+	//
+	//	Returns:	0 for success, or N of the image Ndb that couldn't be stored
+	//
+	//----------
+
+	ImageStore S;	//The new store, resident once it's been saved
+	ImageMP mp[IMAGE_VIEWS];
+	int MPcount;
+	NdbData Ndb;
+	long *pHash;	//Name index + 1 of the first name in each hash chain, 0 = empty chain
+	long *pNext;	//Name index + 1 of the next name in the same chain
+	long NameBlocks;
+	double Bytes;	//Memory the .ndb files take when they're loaded...
+	double Resident;//...and the store
+	char StoreFile[INQUIRY_LENGTH];
+	int i;
+	int er;
+
+	clock_t T;
+	double runtime;
+
+	//The views have to come from the .ndb files, not the old store
+	FreeImageStore(&ViewStore);
+
+	mpLoadImageTasks(&MPcount, mp);
+
+	T = clock();
+	S.Views = MPcount; //The views not made yet are all NULL, so FreeImageStore() can free them all
+	S.Names = 0;
+	S.pView = (ImageView *)calloc(MPcount, sizeof(ImageView));
+	S.pName = (ImageName *)malloc(IMAGE_NAME_BLOCK * sizeof(ImageName));
+	pHash = (long *)calloc(IMAGE_NAME_HASH, sizeof(long));
+	pNext = (long *)malloc(IMAGE_NAME_BLOCK * sizeof(long));
+	if ((S.pView == NULL) || (S.pName == NULL) || (pHash == NULL) || (pNext == NULL)) {
+		printf("\nERROR: not enough memory for the multi-view image store");
+		free(pHash);
+		free(pNext);
+		FreeImageStore(&S);
+		return mp[0].N;
+	}
+	NameBlocks = 1;
+	Bytes = 0;
+
+	for (i = 0; i < MPcount; i++) {
+		Ndb.ID = mp[i].N;
+		er = LoadNdb(&Ndb);
+		if (er != 0) {
+			printf("\nERROR: Failed to load Ndb #%d for the multi-view image store", mp[i].N);
+			break;
+		}
+		Bytes += ((double)(Ndb.RNcount + 1) * sizeof(NdbImageRN)) + ((double)(Ndb.ONcount + 1) * sizeof(NdbON))
+							+ ((double)(Ndb.ConnectCount + 1) * sizeof(NdbRNtoON));
+
+		er = AddImageView(&S, &Ndb, &S.pView[i], pHash, &pNext, &NameBlocks);
+		FreeMem(&Ndb);
+		if (er != 0) {
+			printf("\nERROR: Ndb #%d can't be put in the multi-view image store", mp[i].N);
+			break;
+		}
+	}
+	free(pHash);
+	free(pNext);
+	if (i < MPcount) {
+		FreeImageStore(&S);
+		return mp[i].N;
+	}
+
+	sprintf(StoreFile, "%s%s", SubDirectoryNdbs, ImageStoreFile);
+	er = WriteImageStore(&S, StoreFile);
+	if (er != 0) {
+		FreeImageStore(&S);
+		return mp[0].N;
+	}
+	T = clock() - T;
+	runtime = ((double)T) / CLOCKS_PER_SEC;
+
+	Resident = (double)S.Names * sizeof(ImageName);
+	for (i = 0; i < S.Views; i++) {
+		Resident += ((double)(S.pView[i].RNcount + 1) * sizeof(int))
+							+ ((double)(S.pView[i].ONcount + 1) * sizeof(ImageViewON));
+	}
+	printf("\n%d image Ndb's sharing %ld image names saved in %s (%fsec)", S.Views, S.Names, StoreFile, runtime);
+	printf("\nResident: %.1f MB, instead of %.1f MB for all of them loaded from their .ndb files",
+											Resident / 1048576.0, Bytes / 1048576.0);
+	printf("\n");
+
+	ViewStore = S; //From now on LoadNdb() gets the image Ndbs from here
+
+	return 0;
+}
+
+int AddImageView(ImageStore *pS, NdbData *Ndb, ImageView *pV, long *pHash, long **ppNext, long *NameBlocks) {
+	//
+	//	Copy the loaded image Ndb into the view pV of store pS, adding the names of its ONs
+	//	to the shared name table, pS->pName[], if they aren't there already: pHash[] and
+	//	(*ppNext)[] are its hash chains.
+	//
+	//	Returns:	0 for success, 1 for an Ndb that doesn't fit the store
+	//
+	//----------
+
+	ImageName *pName;
+	long ONcode;
+	long i;
+	long slot;
+	int k;
+
+	if (strcmp(Ndb->Type, "IMAGE_28X28") != 0) return 1;
+	if (Ndb->RNcount > 65535) return 1; //The RLs are kept as unsigned short
+	if (Ndb->ConnectCount != (Ndb->ONcount * NUMBER_OF_IMAGE_RNS)) return 1;
+
+	pV->ID = Ndb->ID;
+	pV->RNcount = Ndb->RNcount;
+	pV->ONcount = Ndb->ONcount;
+	pV->pRN = (int *)malloc((Ndb->RNcount + 1) * sizeof(int));
+	pV->pON = (ImageViewON *)malloc((Ndb->ONcount + 1) * sizeof(ImageViewON));
+	if ((pV->pRN == NULL) || (pV->pON == NULL)) return 1;
+
+	for (k = 1; k <= Ndb->RNcount; k++) pV->pRN[k] = Ndb->pIRN[k].RN;
+
+	for (ONcode = 1; ONcode <= Ndb->ONcount; ONcode++) {
+		if (Ndb->pON[ONcode].Len != NUMBER_OF_IMAGE_RNS) return 1;
+		if (strlen(Ndb->pON[ONcode].ON) >= IMAGE_NAME_LENGTH) return 1;
+		if (strlen(Ndb->pON[ONcode].SUR) >= sizeof(pV->pON[0].SUR)) return 1;
+
+		//The connections have to be the RL in position order, since that's how they're made again
+		for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) {
+			i = ((ONcode - 1) * NUMBER_OF_IMAGE_RNS) + k;
+			if ((Ndb->pRNtoON[i].RNcode != Ndb->pON[ONcode].RL[k]) || (Ndb->pRNtoON[i].Pos != (k + 1))
+								|| (Ndb->pRNtoON[i].ONcode != ONcode)) return 1;
+			pV->pON[ONcode].RL[k] = (unsigned short)Ndb->pON[ONcode].RL[k];
+		}
+		strcpy(pV->pON[ONcode].SUR, Ndb->pON[ONcode].SUR);
+
+		//Find the name in the shared table, or add it
+		slot = HashImageName(Ndb->pON[ONcode].ON) & (IMAGE_NAME_HASH - 1);
+		for (i = pHash[slot]; i != 0; i = (*ppNext)[i - 1]) {
+			if (strcmp(pS->pName[i - 1].Name, Ndb->pON[ONcode].ON) == 0) break;
+		}
+		if (i == 0) {
+			if (pS->Names == (*NameBlocks * IMAGE_NAME_BLOCK)) { // The table is full, get more memory...
+				(*NameBlocks)++;
+				pName = (ImageName *)realloc(pS->pName, *NameBlocks * IMAGE_NAME_BLOCK * sizeof(ImageName));
+				if (pName == NULL) return 1;
+				pS->pName = pName;
+				*ppNext = (long *)realloc(*ppNext, *NameBlocks * IMAGE_NAME_BLOCK * sizeof(long));
+				if (*ppNext == NULL) return 1;
+			}
+			i = pS->Names;
+			strcpy(pS->pName[i].Name, Ndb->pON[ONcode].ON);
+			pS->pName[i].Label = Ndb->pON[ONcode].SUR[0]; //The image's own digit comes first
+			(*ppNext)[i] = pHash[slot];
+			pHash[slot] = i + 1;
+			pS->Names++;
+			i++;
+		}
+		pV->pON[ONcode].Name = i - 1;
+	}
+
+	return 0;
+}
+
+int WriteImageStore(ImageStore *pS, char *StoreFile) {
+	//
+	//	Write the store pS to StoreFile: a header, the shared name table, then each
+	//	view's header, RN values and ON records
+	//
+	//	Returns:	0 for success, 1 for failure
+	//
+	//----------
+
+	FILE *fh;
+	ImageStoreHead H;
+	ImageView *pV;
+	int i;
+	int bad;
+
+	fh = fopen(StoreFile, "wb");
+	if (fh == NULL) {
+		printf("\nERROR: Failed to OPEN file %s for writing.", StoreFile);
+		return 1;
+	}
+
+	memcpy(H.Magic, "NDBVIEWS", 8);
+	H.Version = 1;
+	H.Views = pS->Views;
+	H.Names = pS->Names;
+	H.NameRecord = sizeof(ImageName);
+	H.ONrecord = sizeof(ImageViewON);
+
+	bad = 0;
+	if (fwrite(&H, sizeof(H), 1, fh) != 1) bad = 1;
+	if (fwrite(pS->pName, sizeof(ImageName), pS->Names, fh) != (size_t)pS->Names) bad = 1;
+	for (i = 0; i < pS->Views; i++) {
+		pV = &pS->pView[i];
+		if (fwrite(&pV->ID, sizeof(int), 1, fh) != 1) bad = 1;
+		if (fwrite(&pV->RNcount, sizeof(int), 1, fh) != 1) bad = 1;
+		if (fwrite(&pV->ONcount, sizeof(long), 1, fh) != 1) bad = 1;
+		if (fwrite(&pV->pRN[1], sizeof(int), pV->RNcount, fh) != (size_t)pV->RNcount) bad = 1;
+		if (fwrite(&pV->pON[1], sizeof(ImageViewON), pV->ONcount, fh) != (size_t)pV->ONcount) bad = 1;
+	}
+	fclose(fh);
+
+	if (bad != 0) {
+		printf("\nERROR: Failed to write the multi-view image store %s", StoreFile);
+		return 1;
+	}
+	return 0;
+}
+
+int LoadImageStore(void) {
+	//
+	//	Make the multi-view image store, ImageStoreFile, resident
+	//
+	//	Everything LoadImageView() relies on is checked here, once: the counts, the name of
+	//	each ON and its RL. The strings are cut off at their fields' lengths.
+	//
+	//	Returns:	0 for success, 1 if there's no store or it's no good
+	//
+	//----------
+
+	FILE *fh;
+	ImageStoreHead H;
+	ImageView *pV;
+	ImageViewON *pO;
+	char StoreFile[INQUIRY_LENGTH];
+	long ONcode;
+	long j;
+	int i, k;
+	int bad;
+
+	FreeImageStore(&ViewStore);
+
+	sprintf(StoreFile, "%s%s", SubDirectoryNdbs, ImageStoreFile);
+	fh = fopen(StoreFile, "rb");
+	if (fh == NULL) return 1;
+
+	bad = 0;
+	if (fread(&H, sizeof(H), 1, fh) != 1) bad = 1;
+	if ((bad == 0) && ((memcmp(H.Magic, "NDBVIEWS", 8) != 0) || (H.Version != 1) || (H.Views < 1)
+				|| (H.Names < 0) || (H.NameRecord != sizeof(ImageName)) || (H.ONrecord != sizeof(ImageViewON)))) bad = 1;
+	if (bad != 0) {
+		printf("\nERROR: %s isn't a multi-view image store made by this program", StoreFile);
+		fclose(fh);
+		return 1;
+	}
+
+	ViewStore.pName = (ImageName *)malloc((H.Names + 1) * sizeof(ImageName));
+	ViewStore.pView = (ImageView *)calloc(H.Views, sizeof(ImageView));
+	if ((ViewStore.pName == NULL) || (ViewStore.pView == NULL)) bad = 1;
+	if (bad == 0) {
+		ViewStore.Names = H.Names;
+		if (fread(ViewStore.pName, sizeof(ImageName), H.Names, fh) != (size_t)H.Names) bad = 1;
+		for (j = 0; j < H.Names; j++) ViewStore.pName[j].Name[IMAGE_NAME_LENGTH - 1] = 0;
+	}
+	for (i = 0; (i < H.Views) && (bad == 0); i++) {
+		pV = &ViewStore.pView[i];
+		ViewStore.Views = i + 1; //so FreeImageStore() frees the views read so far
+		if (fread(&pV->ID, sizeof(int), 1, fh) != 1) bad = 1;
+		if (fread(&pV->RNcount, sizeof(int), 1, fh) != 1) bad = 1;
+		if (fread(&pV->ONcount, sizeof(long), 1, fh) != 1) bad = 1;
+		if ((pV->RNcount < 0) || (pV->RNcount > 65535) || (pV->ONcount < 0)) bad = 1;
+		if (bad != 0) break;
+		pV->pRN = (int *)malloc((pV->RNcount + 1) * sizeof(int));
+		pV->pON = (ImageViewON *)malloc((pV->ONcount + 1) * sizeof(ImageViewON));
+		if ((pV->pRN == NULL) || (pV->pON == NULL)) {
+			bad = 1;
+			break;
+		}
+		if (fread(&pV->pRN[1], sizeof(int), pV->RNcount, fh) != (size_t)pV->RNcount) bad = 1;
+		if (fread(&pV->pON[1], sizeof(ImageViewON), pV->ONcount, fh) != (size_t)pV->ONcount) bad = 1;
+
+		for (ONcode = 1; (ONcode <= pV->ONcount) && (bad == 0); ONcode++) {
+			pO = &pV->pON[ONcode];
+			if ((pO->Name < 0) || (pO->Name >= H.Names)) bad = 1; //pName[0] ... pName[Names - 1]
+			for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) {
+				if ((pO->RL[k] < 1) || (pO->RL[k] > pV->RNcount)) bad = 1;
+			}
+			pO->SUR[sizeof(pO->SUR) - 1] = 0;
+		}
+	}
+	fclose(fh);
+
+	if (bad != 0) {
+		printf("\nERROR: Failed to read the multi-view image store %s", StoreFile);
+		FreeImageStore(&ViewStore);
+		return 1;
+	}
+
+	return 0;
+}
+
+int FindImageView(int ID) {
+	//
+	//	The index in ViewStore.pView[] of image Ndb #ID, or -1 if it isn't in the store
+	//
+	//----------
+
+	int i;
+
+	for (i = 0; i < ViewStore.Views; i++) {
+		if (ViewStore.pView[i].ID == ID) return i;
+	}
+
+	return -1;
+}
+
+int LoadImageView(NdbData *Ndb, int v) {
+	//
+	//	Load view ViewStore.pView[v] into the memory structure Ndb-> ... just as LoadNdb()
+	//	would load its .ndb file
+	//
+	//	The function returns 0 if successful, otherwise it returns N, the
+	//	number of the database that failed to load.
+	//
+	//----------
+
+	ImageView *pV;
+	ImageViewON *pO;
+	NdbON *pON;
+	long ONcode;
+	long c;
+	int k;
+
+	pV = &ViewStore.pView[v];
+
+	strcpy(Ndb->Type, "IMAGE_28X28");
+	Ndb->RNcount = pV->RNcount;
+	Ndb->ONcount = pV->ONcount;
+	Ndb->ConnectCount = pV->ONcount * NUMBER_OF_IMAGE_RNS;
+	Ndb->pIRN = (NdbImageRN *)malloc((Ndb->RNcount+1) * sizeof(NdbImageRN));
+	Ndb->pON = (NdbON *)malloc((Ndb->ONcount+1) * sizeof(NdbON));
+	Ndb->pRNtoON = (NdbRNtoON *)malloc((Ndb->ConnectCount+1) * sizeof(NdbRNtoON));
+	if ((Ndb->pIRN == NULL) || (Ndb->pON == NULL) || (Ndb->pRNtoON == NULL)) {
+		printf("ERROR: not enough memory to load Ndb #%d\n", Ndb->ID);
+		FreeMem(Ndb);
+		return Ndb->ID;
+	}
+
+	for (k = 1; k <= pV->RNcount; k++) Ndb->pIRN[k].RN = pV->pRN[k];
+
+	c = 0;
+	for (ONcode = 1; ONcode <= pV->ONcount; ONcode++) {
+		pO = &pV->pON[ONcode];
+		pON = &Ndb->pON[ONcode];
+		strcpy(pON->ON, ViewStore.pName[pO->Name].Name);
+		strcpy(pON->SUR, pO->SUR);
+		pON->ACT[0] = 0;
+		pON->Len = NUMBER_OF_IMAGE_RNS;
+		for (k = 0; k < NUMBER_OF_IMAGE_RNS; k++) {
+			pON->RL[k] = pO->RL[k];
+			Ndb->pRNtoON[c].RNcode = pO->RL[k];
+			Ndb->pRNtoON[c].Pos = k + 1;
+			Ndb->pRNtoON[c].ONcode = ONcode;
+			c++;
+		}
+		pON->RL[NUMBER_OF_IMAGE_RNS] = 0;
+	}
+
+	return 0;
+}
+
+void FreeImageStore(ImageStore *pS) {
+	//
+	//	Free the multi-view image store pS, if there is one
+	//
+	//----------
+
+	int i;
+
+	if (pS->pView != NULL) {
+		for (i = 0; i < pS->Views; i++) {
+			free(pS->pView[i].pRN);
+			free(pS->pView[i].pON);
+		}
+	}
+	free(pS->pView);
+	free(pS->pName);
+	pS->pView = NULL;
+	pS->pName = NULL;
+	pS->Views = 0;
+	pS->Names = 0;
+}
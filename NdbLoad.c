@@ -33,6 +33,14 @@ int LoadNdb(NdbData *Ndb) {
 	long Lres;
 	int badfile;
 
+	Ndb->pIndex = NULL; //IMAGE_28X28 lookup index, built after loading if it's wanted: see RunImageView()
+
+	//The image Ndbs come from the multi-view image store while it's resident
+	if (ViewStore.Views > 0) {
+		res = FindImageView(Ndb->ID);
+		if (res >= 0) return LoadImageView(Ndb, res);
+	}
+
 	sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, Ndb->ID);
 	fh_read = fopen(ndbfile, "r");
 	if (fh_read == NULL) {
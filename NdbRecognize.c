@@ -6,37 +6,140 @@
 
 //Functions:
 //NdbData is often included for any diagnostic code that could be added
-int RecognizeTEXT(NdbData *, char *);
+int OpenSession(SESSIONdata *);
+void CloseSession(SESSIONdata *);
+int RecognizeTEXT(NdbData *, SESSIONdata *, char *);
 int PreProcessText(NdbData *, RECdata *, char *);
 int PreProcessQuestion(NdbData *, RECdata *, char *);
-int mpRecognizeIMAGE(long, char *);
-int mpRunIMAGE(char *, ImageMP *);
+int mpRecognizeIMAGE(SESSIONdata *, long, unsigned char *);
+int mpRecognizeIMAGES(SESSIONdata *, MNISTimage *, long, long, char *);
+int SetImageContrasts(int, ImageMP *, ImageViews *);
+void CountImageResults(ImageMP *, int *);
+int ImageVote(int *);
+int VoteDecided(int *, int);
+int TierMarginReached(int *, int);
+int OrderImageTiers(int, ImageMP *);
+int mpRateImageViews(SESSIONdata *, MNISTimage *, long, int *, long *);
+int mpRunIMAGE(SESSIONdata *, ImageViews *, ImageMP *);
+int RunImageView(NdbData *, SESSIONdata *, ImageViews *, ImageMP *);
+int ImageResults(NdbData *, long *, int, ImageMP *);
 void mpLoadImageTasks(int *, ImageMP *);
 void RecognizeINPUT(NdbData *, RECdata *);
-int FinishRecognition(NdbData *, RECdata *);
+int FinishRecognition(NdbData *, RECdata *, SESSIONdata *);
+void IndexR(RECdata *);
+void ReindexR(RECdata *, int, int);
+void CompactR(RECdata *);
 int RemoveEnvelopments(NdbData *, RECdata *);
 int RetractAnomalousBoundaries(NdbData *, RECdata *);
+int AnomalousBoundary(RECdata *, int, int *);
+void RetractAnomalousON(NdbData *, RECdata *, int, int, int);
 int RetractWeakBoundaries(NdbData *, RECdata *);
 int ExpandBoundaries(NdbData *, RECdata *);
+int ExpansionSide(NdbData *, RECdata *, int, int, int);
 int ExpandBeginBoundary(NdbData *, RECdata *, int);
+int BeginPattern(NdbData *, RECdata *, int, int);
 int ExpandEndBoundary(NdbData *, RECdata *, int);
+int EndPattern(NdbData *, RECdata *, int, int);
 void RemoveWeakONs(NdbData *, RECdata *);
 void GetAnomalyCounts(RECdata *);
 int MakeBranches(NdbData *, RECdata *);
+int TraceBranches(NdbData *, RECdata *, int);
+void ShiftLengths(unsigned long long *, int, unsigned long long *);
+void GrowBranches(NdbData *, RECdata *, int);
 void BuildBranches(NdbData *, RECdata *);
+void BeamBranches(RECdata *, int);
 void addBRHcount(RECdata *);
 void addBRcount(RECdata *);
 int CompeteBranches(NdbData *, RECdata *);
 void addTcount(RECdata *);
 int RunCompetitions(NdbData *, RECdata *);
 int GetWinners(NdbData *, RECdata *, int, int);
+void LoadCompetitor(RECdata *, int, COMP *);
 
 
-int RecognizeTEXT(NdbData *Ndb, char *INPUT) {
+int OpenSession(SESSIONdata *pS) {
+	//
+	//	Open a recognition session: take the switches from the Menu's settings as they are
+	//	now, and get the memory for the results. Changing the settings afterwards doesn't
+	//	change an open session.
+	//
+	//	Returns:	0 for success, 1 for no memory
+	//
+	//----------
+
+	pS->ShowProgress = ShowProgress;
+	pS->SCUmask = SCUmask;
+	pS->Beam = BeamWidth;
+	pS->Explain = ExplainMode;
+	pS->StageStats = StageStats;
+	pS->FullVote = FullVote;
+	pS->TierMargin = TierMargin;
+	pS->ImageLookup = ImageLookup;
+
+	pS->OUTcount = 0;
+	pS->pOUT = (OUTPUT *)malloc((TOTAL_ALLOWED_RESULTS + 1) * sizeof(OUTPUT));
+
+	pS->Matches = 0;
+	pS->Pruned = 0;
+	pS->BeamPruned = 0;
+	pS->BeamLost = 0;
+	pS->ImageViewsRun = 0;
+	pS->Lookup.Exact = 0;
+	pS->Lookup.ExactAgree = 0;
+	pS->Lookup.Near = 0;
+	pS->Lookup.NearAgree = 0;
+	pS->Lookup.Fallback = 0;
+	StageTotalsClear(pS);
+
+	//RecognizeTEXT()'s memory starts at one block of each
+	pS->pR = (Rdata *)malloc(R_RECORDS * sizeof(Rdata));
+	pS->Rblocks = 1;
+	pS->pBRH = (BRHdata *)malloc(BR_RECORDS * sizeof(BRHdata));
+	pS->BRHblocks = 1;
+	pS->pBR = (BRdata *)malloc(BR_RECORDS * sizeof(BRdata));
+	pS->BRblocks = 1;
+	pS->pT = (Tdata *)malloc(T_RECORDS * sizeof(Tdata));
+	pS->Tblocks = 1;
+	pS->pIXnext = NULL; //IndexR() gets it
+	pS->IXsize = 0;
+
+	if ((pS->pOUT == NULL) || (pS->pR == NULL) || (pS->pBRH == NULL) || (pS->pBR == NULL) || (pS->pT == NULL)) {
+		printf("\nERROR: No memory for a recognition session");
+		CloseSession(pS);
+		return 1;
+	}
+
+	return 0;
+}
+
+void CloseSession(SESSIONdata *pS) {
+	//
+	//	Free the memory of a session from OpenSession()
+	//
+	//----------
+
+	free(pS->pOUT);
+	free(pS->pR);
+	free(pS->pBRH);
+	free(pS->pBR);
+	free(pS->pT);
+	free(pS->pIXnext);
+	pS->pOUT = NULL;
+	pS->pR = NULL;
+	pS->pBRH = NULL;
+	pS->pBR = NULL;
+	pS->pT = NULL;
+	pS->pIXnext = NULL;
+	pS->OUTcount = 0;
+}
+
+int RecognizeTEXT(NdbData *Ndb, SESSIONdata *pS, char *INPUT) {
 	//
 	//	Recognize the INPUT[] using Ndb #N
 	//
-	//	Results in R[] will be put in the array OUTPUT[]
+	//	Results in R[] will be put in the session's array pS->pOUT[]
+	//
+	//	Ndb is only read, so any number of sessions can use it at the same time.
 	//
 	//----------
 
@@ -44,34 +147,43 @@ int RecognizeTEXT(NdbData *Ndb, char *INPUT) {
 	int i;
 	RECdata pRD;
 
-	if (ShowProgress == 1) printf("\nNdb #%d: Identifying: %s ...", Ndb->ID, INPUT);
+	if (pS->ShowProgress == 1) printf("\nNdb #%d: Identifying: %s ...", Ndb->ID, INPUT);
 
 
 	if ((strcmp(Ndb->Type, "TEXT") != 0) && (strcmp(Ndb->Type, "CENTRAL") != 0)) {
 		printf("\nERROR: Unknown Ndb TYPE: %s", Ndb->Type);
+		pS->OUTcount = 0;
 		return 1;
 	}
 
-	//Get memory for pRD->pR[]
-	pRD.pR = (Rdata *)malloc(R_RECORDS * sizeof(Rdata));
+	pRD.ShowProgress = pS->ShowProgress;
+	pRD.SCUmask = pS->SCUmask;
+	pRD.StageStats = pS->StageStats;
+	pRD.Beam = pS->Beam;
+	pRD.Explain = pS->Explain;
+
+	//The session's memory for pRD->pR[], and the index of it
+	pRD.pR = pS->pR;
 	pRD.Rcount = 0;
-	pRD.Rblocks = 1;
+	pRD.Rblocks = pS->Rblocks;
+	pRD.pIXnext = pS->pIXnext;
+	pRD.IXsize = pS->IXsize;
 
 
-	//Get memory for pBRH...pBR[] - linked lists of ONs/pRD->pR[] making up the branches
-	pRD.pBRH = (BRHdata *)malloc(BR_RECORDS * sizeof(BRHdata)); //memory for Branch Head
+	//pBRH...pBR[] - linked lists of ONs/pRD->pR[] making up the branches
+	pRD.pBRH = pS->pBRH; //memory for Branch Head
 	pRD.BRHcount = 0;
-	pRD.BRHblocks = 1;
+	pRD.BRHblocks = pS->BRHblocks;
 
-	pRD.pBR = (BRdata *)malloc(BR_RECORDS * sizeof(BRdata)); //memory for Branch Members
+	pRD.pBR = pS->pBR; //memory for Branch Members
 	pRD.BRcount = 0;
-	pRD.BRblocks = 1;
+	pRD.BRblocks = pS->BRblocks;
 
 
-	//Get memory for pT[] - list of the competing Branches
-	pRD.pT = (Tdata *)malloc(T_RECORDS * sizeof(Tdata));
+	//pT[] - list of the competing Branches
+	pRD.pT = pS->pT;
 	pRD.Tcount = 0;
-	pRD.Tblocks = 1;
+	pRD.Tblocks = pS->Tblocks;
 
 
 	if (strcmp(Ndb->Type, "TEXT") == 0) {
@@ -86,18 +198,32 @@ int RecognizeTEXT(NdbData *Ndb, char *INPUT) {
 
 	RecognizeINPUT(Ndb, &pRD); //[IS] -> pRES[]
 
+	pS->Matches = pS->Matches + pRD.Matches;
+	pS->Pruned = pS->Pruned + pRD.Pruned;
+	pS->BeamPruned = pS->BeamPruned + pRD.BeamPruned;
+	pS->BeamLost = pS->BeamLost + pRD.BeamLost;
+	StageReport(Ndb, &pRD, pS, INPUT);
+	ExplainReport(Ndb, &pRD, INPUT);
+
 	if (pRD.RESULTcount == 0) {
-		OUTcount = 0;
+		pS->OUTcount = 0;
 		er = 99; //Unable to recognize INPUT[]
 	} else {
-		er = FinishRecognition(Ndb, &pRD); //pRES[] -> pOUT[]
+		er = FinishRecognition(Ndb, &pRD, pS); //pRES[] -> pS->pOUT[]
 	}
 
+	//Give the memory back to the session, wherever it's been moved to as it grew
 	for (i = 1; i <= pRD.Tcount; i++) free(pRD.pT[i].pNC);
-	free(pRD.pT);
-	free(pRD.pBR);
-	free(pRD.pBRH);
-	free(pRD.pR);
+	pS->pT = pRD.pT;
+	pS->Tblocks = pRD.Tblocks;
+	pS->pBR = pRD.pBR;
+	pS->BRblocks = pRD.BRblocks;
+	pS->pBRH = pRD.pBRH;
+	pS->BRHblocks = pRD.BRHblocks;
+	pS->pR = pRD.pR;
+	pS->Rblocks = pRD.Rblocks;
+	pS->pIXnext = pRD.pIXnext;
+	pS->IXsize = pRD.IXsize;
 	return er;
 }
 
@@ -313,27 +439,43 @@ int PreProcessQuestion(NdbData *Ndb, RECdata *pRD, char *INPUT) {
 	return 0;
 }
 
-int mpRecognizeIMAGE(long RecNum, char *INPUT) {
+int mpRecognizeIMAGE(SESSIONdata *pS, long RecNum, unsigned char *pixel) {
 	//
 	//	Setup multi-threading to run this inquiry on the 399 'image' databases...
 	//
+	//	The votes are counted as each database finishes. Once no number of votes from the
+	//	databases still to run could change the winner, the rest are skipped, unless the
+	//	session's FullVote is set (audit runs). pS->ImageViewsRun is set to the number of
+	//	databases run, and the digit recognized goes in pS->pOUT[1].
+	//
+	//	With the cascade turned on (pS->TierMargin > 0), the first tier of databases votes
+	//	first, see OrderImageTiers(). The rest only run if the first tier's winner leads by
+	//	less than TierMargin votes.
+	//
+	//	To recognize many images, see mpRecognizeIMAGES()
+	//
 	//----------
 
-	ImageMP mp[399];
+	ImageMP mp[IMAGE_VIEWS];
 	int MPcount;
+	ImageViews View[IMAGE_CONTRASTS];
+	int Vcount;
 
 	int Counts[10]; //Number of databases that recognized this digit
+	int Remaining;	//Databases that haven't voted yet
+	int Decided;	//1: the databases still to run can't change the winner
+	int Tier1;		//mp[0] ... mp[Tier1 - 1] are the first tier
 	int i, j, k;
-	char digit;
-	int max;
 	int ResultFlag;
-	int er;
 
 	ResultFlag = 0; //or =N of any database that failed to load
-	er = 0;	//Success"
+	pS->ImageViewsRun = 0;
 
 	mpLoadImageTasks(&MPcount, mp);
 
+	Tier1 = MPcount;
+	if ((pS->TierMargin > 0) && (pS->FullVote == 0)) Tier1 = OrderImageTiers(MPcount, mp);
+
 	for (i = 0; i < MPcount; i++) {
 		mp[i].RecNum = RecNum;
 		for (j = 1; j <= TOTAL_ALLOWED_RESULTS; j++) {
@@ -341,6 +483,15 @@ int mpRecognizeIMAGE(long RecNum, char *INPUT) {
 		}
 	}
 
+	//Only the contrast differs from one database to the next, so the image is transformed
+	//at all the contrasts at once. The databases just cut out their panels.
+	Vcount = SetImageContrasts(MPcount, mp, View);
+	if (Vcount == 0) return mp[0].N;
+	GetImageViews(pixel, Vcount, View);
+
+	for (i = 0; i < 10; i++) Counts[i] = 0; //clear the digit counts
+	Remaining = MPcount;
+	Decided = 0;
 
 	//Request ActualThreads from the OS. You may or may not be given this many.
 	omp_set_num_threads(ActualThreads);
@@ -349,69 +500,309 @@ int mpRecognizeIMAGE(long RecNum, char *INPUT) {
 
 		int er;
 		int i;
+		int tier, first, last;
+
+		for (tier = 1; tier <= 2; tier++) {
+			first = 0;
+			last = Tier1;
+			if (tier == 2) {
+				first = Tier1;
+				last = MPcount;
+			}
 
-		#pragma omp for //OpenMP will split the loop up among the threads, each having a unique i
-		for (i = 0; i < MPcount; i++) {
-			er = mpRunIMAGE(INPUT, &mp[i]);
+			//The databases are handed out in order, so the ones skipped are those at the end
+			#pragma omp for schedule(dynamic)
+			for (i = first; i < last; i++) {
+				//Reading Decided is a race condition, but it only goes from 0 to 1, and a late
+				//read just costs one database that wasn't needed.
+				if (Decided == 1) continue;
 
-			if (er != 0) {
-				//Setting ResultFlag is a race condition, but who cares - nobody is setting it back to zero.
-				if (er > 1999) ResultFlag = er; //Failed to load mp[i].N, OR Bad INPUT/Panel Image.
-				continue;
+				er = mpRunIMAGE(pS, &View[mp[i].View], &mp[i]);
+
+				if (er > 1999) { //Failed to load mp[i].N, OR Bad INPUT/Panel Image.
+					#pragma omp critical (ImageVotes)
+					if ((ResultFlag == 0) || (er < ResultFlag)) ResultFlag = er; //the same N whichever thread is first
+					continue;
+				}
+
+				#pragma omp critical (ImageVotes)
+				{
+					CountImageResults(&mp[i], Counts);
+					Remaining--;
+					pS->ImageViewsRun++;
+					if ((pS->FullVote == 0) && (VoteDecided(Counts, Remaining) == 1)) Decided = 1;
+				}
+			}
+
+			//All the threads wait here for the first tier to finish voting
+			#pragma omp single
+			{
+				if ((tier == 1) && (Tier1 < MPcount) && (TierMarginReached(Counts, pS->TierMargin) == 1)) Decided = 1;
 			}
 		}
 
 	} // ------------------------------------------------------------ End of OpenMP
 
 	//Failed to load at least one database (corrupt file?), or bad image in INPUT[]
-	if (ResultFlag != 0) return ResultFlag;
-	
-	for (i = 0; i < 10; i++) Counts[i] = 0; //clear the digit counts
+	if (ResultFlag != 0) {
+		pS->OUTcount = 0;
+		return ResultFlag;
+	}
 
-	for (i = 0; i < MPcount; i++) {
-		for (j = 1; j <= TOTAL_ALLOWED_RESULTS; j++) {
-			for (k = 0; k < 10; k++) {
-				digit = mp[i].Results[j][k];
-				if (digit == 0) break; //done with this set of digits
-
-				switch (digit) {
-					case '0':
-						Counts[0]++;
-						break;
-					case '1':
-						Counts[1]++;
-						break;
-					case '2':
-						Counts[2]++;
-						break;
-					case '3':
-						Counts[3]++;
-						break;
-					case '4':
-						Counts[4]++;
-						break;
-					case '5':
-						Counts[5]++;
-						break;
-					case '6':
-						Counts[6]++;
-						break;
-					case '7':
-						Counts[7]++;
-						break;
-					case '8':
-						Counts[8]++;
-						break;
-					case '9':
-						Counts[9]++;
-						break;
-					default:
-						break;
+	j = ImageVote(Counts);
+
+	if (j == 99) {
+		pS->OUTcount = 0; // No Result
+	} else {
+		pS->OUTcount = 1;
+		pS->pOUT[1].REScount = 1;
+		sprintf(pS->pOUT[1].Result[1].ON, "%d", j);
+	}
+
+	return 0; //success
+}
+
+int mpRecognizeIMAGES(SESSIONdata *pS, MNISTimage *pIMG, long FirstRecNum, long Count, char *pResult) {
+	//
+	//	Recognize the Count images pIMG[FirstRecNum] ... on the 399 'image' databases,
+	//	putting the digit recognized for pIMG[FirstRecNum + i] in pResult[i], or 0 for
+	//	No Result.
+	//
+	//	All Count x 399 (image, database) inquiries are shared out among the threads in
+	//	one parallel loop, so the threads don't sit idle waiting for the slowest database
+	//	of each image. Each task is one database and a block of IMAGE_BATCH_BLOCK images.
+	//	The tasks are ordered database by database and handed out dynamically, so a thread
+	//	usually gets the next block for the database it already has loaded, and each
+	//	database is loaded from its file only a few times per call instead of once per image.
+	//
+	//	Each image needs its 7 contrast views in memory, so Count should be kept to a batch
+	//	of images: see IMAGE_BATCH and TestAllMNIST().
+	//
+	//	As in mpRecognizeIMAGE(), an image's remaining databases are skipped once its winner
+	//	is decided, unless FullVote is set, and pS->ImageViewsRun is set to the total run. A block
+	//	whose images are all decided doesn't even load its database. The cascade works the
+	//	same way too: the whole batch runs on the first tier before any image goes on to the
+	//	rest of the databases.
+	//
+	//	Returns:	0 for success, or N of a database that failed to load, or of one whose
+	//				view of an image was bad, just like mpRecognizeIMAGE()
+	//
+	//----------
+
+	ImageMP mp[IMAGE_VIEWS];
+	int MPcount;
+	ImageViews View[IMAGE_CONTRASTS];
+	int Vcount;
+
+	ImageViews *pV;	//The views of each image: pV[(image * IMAGE_CONTRASTS) + View]
+	int *pVotes;	//Each image's votes for each digit: pVotes[(image * 10) + digit]
+	int *pRemaining;//Each image's databases that haven't voted yet...
+	char *pDecided;	//...and 1 once they can't change its winner
+	long Blocks;
+	int Tier1;		//mp[0] ... mp[Tier1 - 1] are the first tier
+	long i;
+	int j;
+	int ResultFlag;
+
+	ResultFlag = 0; //or =N of any database that failed to load
+	pS->ImageViewsRun = 0;
+
+	mpLoadImageTasks(&MPcount, mp);
+
+	Tier1 = MPcount;
+	if ((pS->TierMargin > 0) && (pS->FullVote == 0)) Tier1 = OrderImageTiers(MPcount, mp);
+
+	Vcount = SetImageContrasts(MPcount, mp, View);
+	if (Vcount == 0) return mp[0].N;
+
+	pV = (ImageViews *)malloc(Count * IMAGE_CONTRASTS * sizeof(ImageViews));
+	pVotes = (int *)calloc(Count * 10, sizeof(int));
+	pRemaining = (int *)malloc(Count * sizeof(int));
+	pDecided = (char *)calloc(Count, sizeof(char));
+	if ((pV == NULL) || (pVotes == NULL) || (pRemaining == NULL) || (pDecided == NULL)) {
+		printf("\nERROR: not enough memory to recognize %ld images at once", Count);
+		free(pV);
+		free(pVotes);
+		free(pRemaining);
+		free(pDecided);
+		return mp[0].N;
+	}
+	for (i = 0; i < Count; i++) pRemaining[i] = MPcount;
+
+	Blocks = (Count + IMAGE_BATCH_BLOCK - 1) / IMAGE_BATCH_BLOCK;
+
+	//Request ActualThreads from the OS. You may or may not be given this many.
+	omp_set_num_threads(ActualThreads);
+	#pragma omp parallel
+	{ // ------------------------------------------------------------ Start of OpenMP
+
+		NdbData Ndb;	//The database this thread has loaded...
+		int Loaded;		//...Ndb #Loaded, or 0 for none
+		ImageMP task;
+		ImageViews *pImageView;
+		long i, img, last;
+		int j, k, er;
+		int tier, first;
+		long Tasks;
+
+		Loaded = 0;
+
+		//Transform each image at all the contrasts at once...
+		#pragma omp for
+		for (i = 0; i < Count; i++) {
+			pImageView = &pV[i * IMAGE_CONTRASTS];
+			for (j = 0; j < Vcount; j++) pImageView[j].Contrast = View[j].Contrast;
+			GetImageViews(pIMG[FirstRecNum + i].pixel, Vcount, pImageView);
+		}
+
+		//...then run every block of images on every database, the first tier first
+		for (tier = 1; tier <= 2; tier++) {
+			first = 0;
+			Tasks = Tier1 * Blocks;
+			if (tier == 2) {
+				first = Tier1;
+				Tasks = (MPcount - Tier1) * Blocks;
+			}
+
+			#pragma omp for schedule(dynamic)
+			for (i = 0; i < Tasks; i++) {
+				task = mp[first + (i / Blocks)];
+
+				img = (i % Blocks) * IMAGE_BATCH_BLOCK;
+				last = img + IMAGE_BATCH_BLOCK;
+				if (last > Count) last = Count;
+				for (; img < last; img++) {
+					//Reading pDecided[] is a race condition, but it only goes from 0 to 1, and a
+					//late read just costs one database that wasn't needed.
+					if (pDecided[img] == 1) continue;
+
+					pImageView = &pV[(img * IMAGE_CONTRASTS) + task.View];
+					if (pImageView->Bad == 1) { //Bad image
+						#pragma omp critical (ImageVotes)
+						if ((ResultFlag == 0) || (task.N < ResultFlag)) ResultFlag = task.N;
+						continue;
+					}
+
+					if (task.N != Loaded) {
+						if (Loaded != 0) FreeMem(&Ndb);
+						Loaded = 0;
+						Ndb.ID = task.N;
+						er = LoadNdb(&Ndb);
+						if (er != 0) { //Ndb #N failed to load...
+							#pragma omp critical (ImageVotes)
+							if ((ResultFlag == 0) || (task.N < ResultFlag)) ResultFlag = task.N;
+							break;
+						}
+						if (pS->ImageLookup > 0) IndexImageONs(&Ndb);
+						Loaded = task.N;
+					}
+
+					task.RecNum = FirstRecNum + img;
+					for (j = 1; j <= TOTAL_ALLOWED_RESULTS; j++) {
+						for (k = 0; k < 10; k++) task.Results[j][k] = 0;
+					}
+					RunImageView(&Ndb, pS, pImageView, &task);
+
+					#pragma omp critical (ImageVotes)
+					{
+						CountImageResults(&task, &pVotes[img * 10]);
+						pRemaining[img]--;
+						pS->ImageViewsRun++;
+						if ((pS->FullVote == 0) && (VoteDecided(&pVotes[img * 10], pRemaining[img]) == 1)) pDecided[img] = 1;
+					}
 				}
 			}
+
+			//All the threads wait here for the first tier to finish voting
+			#pragma omp single
+			{
+				if ((tier == 1) && (Tier1 < MPcount)) {
+					for (img = 0; img < Count; img++) {
+						if (TierMarginReached(&pVotes[img * 10], pS->TierMargin) == 1) pDecided[img] = 1;
+					}
+				}
+			}
+		}
+
+		if (Loaded != 0) FreeMem(&Ndb);
+
+	} // ------------------------------------------------------------ End of OpenMP
+
+	for (i = 0; i < Count; i++) {
+		j = ImageVote(&pVotes[i * 10]);
+		pResult[i] = 0; //No Result
+		if (j != 99) pResult[i] = '0' + j;
+	}
+
+	free(pV);
+	free(pVotes);
+	free(pRemaining);
+	free(pDecided);
+
+	return ResultFlag;
+}
+
+int SetImageContrasts(int MPcount, ImageMP *mp, ImageViews *View) {
+	//
+	//	Only the contrast differs from one database's view of an image to the next:
+	//	set View[].Contrast to the distinct contrasts and point each database at its
+	//	view, mp[i].View
+	//
+	//	Returns the number of contrasts, or 0 if there are too many
+	//
+	//----------
+
+	int Vcount;
+	int i, j;
+
+	Vcount = 0;
+	for (i = 0; i < MPcount; i++) {
+		for (j = 0; j < Vcount; j++) {
+			if (View[j].Contrast == mp[i].Contrast) break;
+		}
+		if (j == Vcount) {
+			if (Vcount == IMAGE_CONTRASTS) {
+				printf("\nERROR: More than %d contrasts in the image databases", IMAGE_CONTRASTS);
+				return 0;
+			}
+			View[j].Contrast = mp[i].Contrast;
+			Vcount++;
 		}
+		mp[i].View = j;
 	}
 
+	return Vcount;
+}
+
+void CountImageResults(ImageMP *mp, int *Counts) {
+	//
+	//	Add the digits recognized by this database, mp->Results[][], to Counts[]
+	//
+	//----------
+
+	int j, k;
+	char digit;
+
+	for (j = 1; j <= TOTAL_ALLOWED_RESULTS; j++) {
+		for (k = 0; k < 10; k++) {
+			digit = mp->Results[j][k];
+			if (digit == 0) break; //done with this set of digits
+			if ((digit >= '0') && (digit <= '9')) Counts[digit - '0']++;
+		}
+	}
+}
+
+int ImageVote(int *Counts) {
+	//
+	//	The digit recognized by the most databases, the lowest on a tie
+	//
+	//	Returns 0 - 9, or 99 if no database recognized anything
+	//
+	//----------
+
+	int i, j;
+	int max;
+
 	max = 0;
 	j = 99;
 	for (i = 0; i < 10; i++) {
@@ -421,53 +812,278 @@ int mpRecognizeIMAGE(long RecNum, char *INPUT) {
 		}
 	}
 
-	if (j == 99) {
-		OUTcount = 0; // No Result
-	} else {
-		OUTcount = 1;
-		pOUT[1].REScount = 1;
-		sprintf(pOUT[1].Result[1].ON, "%d", j);
+	return j;
+}
+
+int VoteDecided(int *Counts, int Remaining) {
+	//
+	//	Can the Remaining databases still change the winner ImageVote() would pick from
+	//	Counts[]? A database votes at most IMAGE_AMBIGUITY_THRESHOLD - 1 times (see
+	//	RunImageView()), so every other digit is given that many votes from each of them.
+	//
+	//	Returns 1 if the winner is decided, 0 if not
+	//
+	//----------
+
+	int i, j;
+	long most;
+
+	j = ImageVote(Counts);
+	if (j == 99) return (Remaining == 0);
+
+	for (i = 0; i < 10; i++) {
+		if (i == j) continue;
+		most = Counts[i] + ((long)Remaining * (IMAGE_AMBIGUITY_THRESHOLD - 1));
+		if (most > Counts[j]) return 0;
+		if ((most == Counts[j]) && (i < j)) return 0; //ImageVote() picks the lowest digit on a tie
 	}
 
-	return 0; //success
+	return 1;
 }
 
-int mpRunIMAGE(char *INPUT, ImageMP *mp) {
+int TierMarginReached(int *Counts, int Margin) {
 	//
-	//	Get the result for this Image/Panel from Ndb mp[i].N
+	//	Cascade: does the winner of the first tier's votes, Counts[], lead the runner-up by
+	//	at least Margin votes (the session's TierMargin)?
+	//
+	//	Returns 1 if it does, 0 if the rest of the databases have to vote
 	//
 	//----------
 
-	NDBimage ROW;
-	NDBimage COL;
-	NDBimage DIAG;
-	NDBimage A;
+	int i;
+	int first, second;
+
+	first = 0;
+	second = 0;
+	for (i = 0; i < 10; i++) {
+		if (Counts[i] > first) {
+			second = first;
+			first = Counts[i];
+		} else {
+			if (Counts[i] > second) second = Counts[i];
+		}
+	}
+
+	if (first == 0) return 0; //Nothing recognized yet
+	if ((first - second) >= Margin) return 1;
+
+	return 0;
+}
+
+int OrderImageTiers(int MPcount, ImageMP *mp) {
+	//
+	//	Cascade: move the first tier of databases to the front of mp[], keeping the order
+	//	of each tier. The first tier is ImageTier1[], learned from the Training Set by
+	//	LearnImageTiers(), or if there isn't one (Tier1Count == 0), the full 28x28 views.
+	//
+	//	Returns the number of first tier databases
+	//
+	//----------
+
+	ImageMP *pT;	//Scratch copy of the second tier
+	int i, j;
+	int Tier1, Tier2;
+	int first;
+
+	pT = (ImageMP *)malloc(MPcount * sizeof(ImageMP));
+	if (pT == NULL) return MPcount; //No cascade, every database is in the first tier
+
+	Tier1 = 0;
+	Tier2 = 0;
+	for (i = 0; i < MPcount; i++) {
+		if (Tier1Count == 0) {
+			first = (mp[i].Size == MAX_IMAGE_SIZE);
+		} else {
+			first = 0;
+			for (j = 0; j < Tier1Count; j++) {
+				if (ImageTier1[j] == mp[i].N) {
+					first = 1;
+					break;
+				}
+			}
+		}
+
+		if (first == 1) {
+			mp[Tier1] = mp[i]; //Tier1 <= i, so this never overwrites one not yet looked at
+			Tier1++;
+		} else {
+			pT[Tier2] = mp[i];
+			Tier2++;
+		}
+	}
+	for (i = 0; i < Tier2; i++) mp[Tier1 + i] = pT[i];
+
+	free(pT);
+
+	return Tier1;
+}
+
+int mpRateImageViews(SESSIONdata *pS, MNISTimage *pIMG, long Count, int *pN, long *pRight) {
+	//
+	//	Run the images pIMG[1] ... pIMG[Count] on every one of the 399 image databases, and
+	//	count in pRight[i] the images that database #pN[i] got right: it voted, and only for
+	//	the image's digit. See LearnImageTiers().
+	//
+	//	Each thread loads one database at a time and runs all the images on it.
+	//
+	//	Returns:	0 for success, or N of a database that failed to load, or of one whose
+	//				view of an image was bad
+	//
+	//----------
+
+	ImageMP mp[IMAGE_VIEWS];
+	int MPcount;
+	ImageViews View[IMAGE_CONTRASTS];
+	int Vcount;
+
+	ImageViews *pV;	//The views of each image: pV[(image * IMAGE_CONTRASTS) + View]
+	int ResultFlag;
+
+	ResultFlag = 0; //or =N of any database that failed to load
+
+	mpLoadImageTasks(&MPcount, mp);
+
+	Vcount = SetImageContrasts(MPcount, mp, View);
+	if (Vcount == 0) return mp[0].N;
+
+	pV = (ImageViews *)malloc((Count + 1) * IMAGE_CONTRASTS * sizeof(ImageViews));
+	if (pV == NULL) {
+		printf("\nERROR: not enough memory to rate the image databases on %ld images", Count);
+		return mp[0].N;
+	}
+
+	//Request ActualThreads from the OS. You may or may not be given this many.
+	omp_set_num_threads(ActualThreads);
+	#pragma omp parallel
+	{ // ------------------------------------------------------------ Start of OpenMP
+
+		NdbData Ndb;
+		ImageMP task;
+		ImageViews *pImageView;
+		int Counts[10];
+		long i, img;
+		int j, k, er;
+
+		//Transform each image at all the contrasts at once...
+		#pragma omp for
+		for (img = 1; img <= Count; img++) {
+			pImageView = &pV[img * IMAGE_CONTRASTS];
+			for (j = 0; j < Vcount; j++) pImageView[j].Contrast = View[j].Contrast;
+			GetImageViews(pIMG[img].pixel, Vcount, pImageView);
+		}
+
+		//...then run them all on one database at a time
+		#pragma omp for schedule(dynamic)
+		for (i = 0; i < MPcount; i++) {
+			task = mp[i];
+			pN[i] = task.N;
+			pRight[i] = 0;
+
+			Ndb.ID = task.N;
+			er = LoadNdb(&Ndb);
+			if (er != 0) { //Ndb #N failed to load...
+				#pragma omp critical (ImageVotes)
+				if ((ResultFlag == 0) || (task.N < ResultFlag)) ResultFlag = task.N;
+				continue;
+			}
+			if (pS->ImageLookup > 0) IndexImageONs(&Ndb);
+
+			for (img = 1; img <= Count; img++) {
+				pImageView = &pV[(img * IMAGE_CONTRASTS) + task.View];
+				if (pImageView->Bad == 1) { //Bad image
+					#pragma omp critical (ImageVotes)
+					if ((ResultFlag == 0) || (task.N < ResultFlag)) ResultFlag = task.N;
+					continue;
+				}
+
+				task.RecNum = img;
+				for (j = 1; j <= TOTAL_ALLOWED_RESULTS; j++) {
+					for (k = 0; k < 10; k++) task.Results[j][k] = 0;
+				}
+				RunImageView(&Ndb, pS, pImageView, &task);
+
+				for (k = 0; k < 10; k++) Counts[k] = 0;
+				CountImageResults(&task, Counts);
+				k = pIMG[img].digit - '0';
+				if ((k < 0) || (k > 9) || (Counts[k] == 0)) continue;
+				for (j = 0; j < 10; j++) {
+					if ((j != k) && (Counts[j] > 0)) break; //also voted for another digit
+				}
+				if (j == 10) pRight[i]++;
+			}
+
+			FreeMem(&Ndb);
+		}
+
+	} // ------------------------------------------------------------ End of OpenMP
+
+	free(pV);
+
+	return ResultFlag;
+}
+
+int mpRunIMAGE(SESSIONdata *pS, ImageViews *pV, ImageMP *mp) {
+	//
+	//	Get the result for this Image/Panel from Ndb mp[i].N, using the inquiry image at
+	//	the database's contrast: pV->ROW, COL, DIAG from mpRecognizeIMAGE()
+	//
+	//----------
 
 	NdbData Ndb;
-	RECdata pRD;
-	ImageData pIdata;
-	int ImageRN[NUMBER_OF_IMAGE_RNS+1]; //some extra room
-	int rb, re, cb, ce, row, col, ro, co;
-	int i, j, k;
-	int RNcode;
-	int ONcode;
 	int N;
 	int er;
-	int Tcnt;
-	char digit;
 
 	N = mp->N;
 	Ndb.ID = N;
 
+	//Bad image (there actually aren't any unless the file has been corrupted)
+	if (pV->Bad == 1) return N;
+
 	er = LoadNdb(&Ndb);
 	if (er != 0) return N; //Ndb #N failed to load...
-	
-	er = GetImage(INPUT, mp->Contrast, &ROW, &COL, &DIAG); //Returns ROW[], COL[], DIAG[]
-	if (er == 1) {
-		//Bad image (there actually aren't any unless the file has been corrupted)
-		FreeMem(&Ndb);
-		return N;
-	}
+	if (pS->ImageLookup > 0) IndexImageONs(&Ndb); //see RunImageView()
+
+	er = RunImageView(&Ndb, pS, pV, mp);
+
+	FreeMem(&Ndb);
+
+	return er;
+}
+
+int RunImageView(NdbData *Ndb, SESSIONdata *pS, ImageViews *pV, ImageMP *mp) {
+	//
+	//	Run the Image/Panel view for database mp->N through Ndb, which is already loaded,
+	//	leaving the digits recognized in mp->Results[][]
+	//
+	//	With the session's ImageLookup = 1, the winning ONs come straight from LookupImage()
+	//	whenever it finds an exact match (or a near one, with IMAGE_LOOKUP_NEAR), and
+	//	RecognizeINPUT() only runs when it doesn't. With ImageLookup = 2, RecognizeINPUT()
+	//	always runs, and pS->Lookup counts how often the lookup agreed.
+	//
+	//	The lookup needs Ndb->pIndex, which whoever loaded the Ndb builds right after
+	//	loading it (IndexImageONs()). The Ndb is only read from then on, so it can be shared.
+	//
+	//	Returns 0, or 99 if nothing was recognized
+	//
+	//----------
+
+	NDBimage A;
+
+	RECdata pRD;
+	ImageData pIdata;
+	int ImageRN[NUMBER_OF_IMAGE_RNS+4]; //some extra room
+	int RL[NUMBER_OF_IMAGE_RNS];	//The RNcodes of ImageRN[], by position
+	long LookONs[TOTAL_ALLOWED_RESULTS+1];	//The ONs found by LookupImage()...
+	int LookCount;
+	int Distance;	//...this many positions from RL[], -1: none
+	long RecONs[TOTAL_ALLOWED_RESULTS+1];	//The ONs recognized by RecognizeINPUT()
+	ImageMP look;
+	int RecCounts[10], LookCounts[10];
+	int agree;
+	int rb, re, cb, ce, row, col, ro, co;
+	int i, j, k;
+	int RNcode;
+	int er;
 
 	rb = mp->rb;
 	re = mp->re;
@@ -484,17 +1100,26 @@ int mpRunIMAGE(char *INPUT, ImageMP *mp) {
 			if (cb != 1) co = cb - 1;
 
 			if (mp->Type == 'R') {
-				A.image[row-ro][col-co] = ROW.image[row][col];
+				A.image[row-ro][col-co] = pV->ROW.image[row][col];
 			} else {
 				if (mp->Type == 'C') {
-					A.image[row-ro][col-co] = COL.image[row][col];
+					A.image[row-ro][col-co] = pV->COL.image[row][col];
 				} else {
-					A.image[row-ro][col-co] = DIAG.image[row][col];
+					A.image[row-ro][col-co] = pV->DIAG.image[row][col];
 				}
 			}
 		}
 	}
 	A.ImageSize = mp->Size;
+	if (mp->Type == 'R') {
+		GetPanelBits(&(pV->ROW), rb, cb, &A);
+	} else {
+		if (mp->Type == 'C') {
+			GetPanelBits(&(pV->COL), rb, cb, &A);
+		} else {
+			GetPanelBits(&(pV->DIAG), rb, cb, &A);
+		}
+	}
 
 	//Get the Recognition List of RNs: ImageRN[]
 	ImageFormatter(&pIdata, &A, ImageRN);
@@ -508,23 +1133,55 @@ int mpRunIMAGE(char *INPUT, ImageMP *mp) {
 	//Load the Input Stream with the RNs produced by the inquiry image
 	//ImageRN[] begins at 1, but pRD.ISRN[j] begins at 0
 	//Convert the RN-values to the RNcodes that are specific to this Ndb...
+	//RL[] keeps them by position for LookupImage(), 0 for an RN this Ndb doesn't have
 	k = 0;
 	for (j = 1; j < INQUIRY_LENGTH; j++) {
 		if (ImageRN[j] == 0) break;
+		if (j <= NUMBER_OF_IMAGE_RNS) RL[j-1] = 0;
 
-		for (RNcode = 1; RNcode <= Ndb.RNcount; RNcode++) {
-			if (Ndb.pIRN[RNcode].RN == ImageRN[j]) {
+		for (RNcode = 1; RNcode <= Ndb->RNcount; RNcode++) {
+			if (Ndb->pIRN[RNcode].RN == ImageRN[j]) {
 				pRD.ISRN[k] = RNcode;
 				k++;
+				if (j <= NUMBER_OF_IMAGE_RNS) RL[j-1] = RNcode;
 				break;
 			}
 		}
 	}
 
+	//Every RN is in the Ndb, so the nearest ONs can be looked up directly.
+	//(An RN missing from the Ndb shifts the rest of the Input Stream, which only
+	//RecognizeINPUT() does the same thing with.)
+	Distance = -1;
+	if ((pS->ImageLookup > 0) && (k == NUMBER_OF_IMAGE_RNS) && (j == (NUMBER_OF_IMAGE_RNS + 1))) {
+		if (Ndb->pIndex != NULL) Distance = LookupImage(Ndb, RL, LookONs, &LookCount);
+	}
+
+	if ((pS->ImageLookup == 1) && ((Distance == 0) || ((Distance > 0) && (IMAGE_LOOKUP_NEAR == 1)))) {
+		er = ImageResults(Ndb, LookONs, LookCount, mp);
+
+		#pragma omp critical (LookupStats)
+		{
+			if (Distance == 0) {
+				pS->Lookup.Exact++;
+			} else {
+				pS->Lookup.Near++;
+			}
+		}
+		return er;
+	}
+
 	//Get memory for pRD->pR[]
 	pRD.pR = (Rdata *)malloc(R_RECORDS * sizeof(Rdata));
 	pRD.Rcount = 0;
 	pRD.Rblocks = 1;
+	pRD.pIXnext = NULL; //The index of pR[] gets its memory in IndexR()
+	pRD.IXsize = 0;
+	pRD.ShowProgress = pS->ShowProgress;
+	pRD.SCUmask = pS->SCUmask;
+	pRD.StageStats = pS->StageStats;
+	pRD.Beam = pS->Beam;
+	pRD.Explain = 0; //Explain mode is for RecognizeTEXT()
 
 	//Get memory for pBRH...pBR[] - linked lists of ONs/pRD->pR[] making up the Branches
 	pRD.pBRH = (BRHdata *)malloc(BR_RECORDS * sizeof(BRHdata)); //memory for Branch Head
@@ -540,31 +1197,44 @@ int mpRunIMAGE(char *INPUT, ImageMP *mp) {
 	pRD.Tcount = 0;
 	pRD.Tblocks = 1;
 
-	RecognizeINPUT(&Ndb, &pRD); //[IS] -> pRES[]
+	RecognizeINPUT(Ndb, &pRD); //[IS] -> pRES[]
 
-	if (pRD.RESULTcount == 0) {
-		er = 99; //Unable to recognize INPUT[]
-	} else {
-		er = 0;
-		//The Image ON's Surrogate has the recognition results: the list of digits recognized.
-		//Also, there may be multiple winning ONs, each representing multiple digits... 
-		Tcnt = 0;
-		for (i = 1; i <= pRD.RESULTcount; i++) {
-			ONcode = pRD.pRES[i].Result[1].ONcode;
-			for (j = 0; j < 10; j++) {
-				digit = Ndb.pON[ONcode].SUR[j];
-				if (digit == 0) break; //end of SUR
-				Tcnt++;
+	//The winning ONs
+	for (i = 1; i <= pRD.RESULTcount; i++) RecONs[i] = pRD.pRES[i].Result[1].ONcode;
+	er = ImageResults(Ndb, RecONs, pRD.RESULTcount, mp);
+
+	if (pS->ImageLookup > 0) {
+		//Compare mode: would the lookup have given the same digits?
+		agree = 0;
+		if ((pS->ImageLookup == 2) && (Distance >= 0)) {
+			look = *mp;
+			for (i = 1; i <= TOTAL_ALLOWED_RESULTS; i++) {
+				for (j = 0; j < 10; j++) look.Results[i][j] = 0;
+			}
+			ImageResults(Ndb, LookONs, LookCount, &look);
+			for (i = 0; i < 10; i++) {
+				RecCounts[i] = 0;
+				LookCounts[i] = 0;
+			}
+			CountImageResults(mp, RecCounts);
+			CountImageResults(&look, LookCounts);
+			agree = 1;
+			for (i = 0; i < 10; i++) {
+				if (RecCounts[i] != LookCounts[i]) agree = 0;
 			}
 		}
 
-		if (Tcnt < IMAGE_AMBIGUITY_THRESHOLD) {
-			for (i = 1; i <= pRD.RESULTcount; i++) {
-				ONcode = pRD.pRES[i].Result[1].ONcode;
-				for (j = 0; j < 10; j++) {
-					digit = Ndb.pON[ONcode].SUR[j];
-					if (digit == 0) break; //end of SUR
-					mp->Results[i][j] = digit;
+		#pragma omp critical (LookupStats)
+		{
+			if ((pS->ImageLookup == 1) || (Distance < 0)) {
+				pS->Lookup.Fallback++;
+			} else {
+				if (Distance == 0) {
+					pS->Lookup.Exact++;
+					pS->Lookup.ExactAgree += agree;
+				} else {
+					pS->Lookup.Near++;
+					pS->Lookup.NearAgree += agree;
 				}
 			}
 		}
@@ -575,11 +1245,52 @@ int mpRunIMAGE(char *INPUT, ImageMP *mp) {
 	free(pRD.pBR);
 	free(pRD.pBRH);
 	free(pRD.pR);
-	FreeMem(&Ndb);
-
+	free(pRD.pIXnext);
 	return er;
 }
 
+int ImageResults(NdbData *Ndb, long *pONcodes, int ONcount, ImageMP *mp) {
+	//
+	//	The Image ON's Surrogate has the recognition results: the list of digits recognized.
+	//	Put the digits of the winning ONs pONcodes[1] ... pONcodes[ONcount] in mp->Results[][],
+	//	unless there are so many of them that the view is too ambiguous to count.
+	//
+	//	Returns 0, or 99 if nothing was recognized
+	//
+	//----------
+
+	int i, j;
+	int Tcnt;
+	long ONcode;
+	char digit;
+
+	if (ONcount == 0) return 99; //Unable to recognize INPUT[]
+
+	//There may be multiple winning ONs, each representing multiple digits... 
+	Tcnt = 0;
+	for (i = 1; i <= ONcount; i++) {
+		ONcode = pONcodes[i];
+		for (j = 0; j < 10; j++) {
+			digit = Ndb->pON[ONcode].SUR[j];
+			if (digit == 0) break; //end of SUR
+			Tcnt++;
+		}
+	}
+
+	if (Tcnt < IMAGE_AMBIGUITY_THRESHOLD) {
+		for (i = 1; i <= ONcount; i++) {
+			ONcode = pONcodes[i];
+			for (j = 0; j < 10; j++) {
+				digit = Ndb->pON[ONcode].SUR[j];
+				if (digit == 0) break; //end of SUR
+				mp->Results[i][j] = digit;
+			}
+		}
+	}
+
+	return 0;
+}
+
 void mpLoadImageTasks(int *MPcount, ImageMP *mp) {
 	//
 	//	Define all the parameters to run the inquiry on all 399 image databases...
@@ -1235,6 +1946,14 @@ void RecognizeINPUT(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 	pRD->RESULTcount = 0;
+	pRD->Matches = 0;
+	pRD->Pruned = 0;
+	StageClear(pRD);
+	pRD->BeamPruned = 0;
+	pRD->BeamLost = 0;
+	pRD->pBeamLens = NULL;
+	pRD->pX = NULL; //Explain mode gets its memory in GetBoundSections()
+	pRD->Xcount = 0;
 
 	if (pRD->ISRN[0] == 0) return; //It's not an error if there's nothing to recognize
 
@@ -1256,7 +1975,7 @@ void RecognizeINPUT(NdbData *Ndb, RECdata *pRD) {
 	return;
 }
 
-int FinishRecognition(NdbData *Ndb, RECdata *pRD) {
+int FinishRecognition(NdbData *Ndb, RECdata *pRD, SESSIONdata *pS) {
 	//
 	//	Load results into OUTPUT, making Surrogate replacements if necessary and
 	//	returning any Actions associated with each recognized ON...
@@ -1268,28 +1987,28 @@ int FinishRecognition(NdbData *Ndb, RECdata *pRD) {
 	int ONcode;
 
 
-	OUTcount = pRD->RESULTcount;
-	for (i = 1; i <= OUTcount; i++) {
+	pS->OUTcount = pRD->RESULTcount;
+	for (i = 1; i <= pS->OUTcount; i++) {
 		REScount = pRD->pRES[i].NumberOfONs;
-		pOUT[i].REScount = REScount;
+		pS->pOUT[i].REScount = REScount;
 
 		for (j = 1; j <= REScount; j++) {
-			pOUT[i].Result[j].B = pRD->pRES[i].Result[j].B;
-			pOUT[i].Result[j].E = pRD->pRES[i].Result[j].E;
+			pS->pOUT[i].Result[j].B = pRD->pRES[i].Result[j].B;
+			pS->pOUT[i].Result[j].E = pRD->pRES[i].Result[j].E;
 			ONcode = pRD->pRES[i].Result[j].ONcode;
-			pOUT[i].Result[j].ONcode = ONcode;
+			pS->pOUT[i].Result[j].ONcode = ONcode;
 
 			// Replace ON with Surrogate?
 			if (Ndb->pON[ONcode].SUR[0] != 0) {
-				strcpy(pOUT[i].Result[j].ON, Ndb->pON[ONcode].SUR);
+				strcpy(pS->pOUT[i].Result[j].ON, Ndb->pON[ONcode].SUR);
 			} else {
-				strcpy(pOUT[i].Result[j].ON, Ndb->pON[ONcode].ON);
+				strcpy(pS->pOUT[i].Result[j].ON, Ndb->pON[ONcode].ON);
 			}
 
 			//Return any Action text associated with this ON
-			pOUT[i].Result[j].ACT[0] = 0;
+			pS->pOUT[i].Result[j].ACT[0] = 0;
 			if (Ndb->pON[ONcode].ACT[0] != 0) {
-				strcpy(pOUT[i].Result[j].ACT, Ndb->pON[ONcode].ACT);
+				strcpy(pS->pOUT[i].Result[j].ACT, Ndb->pON[ONcode].ACT);
 			}
 		}
 	}
@@ -1297,6 +2016,97 @@ int FinishRecognition(NdbData *Ndb, RECdata *pRD) {
 	return 0;
 }
 
+void IndexR(RECdata *pRD) {
+	//
+	//	Build the index of pRD->pR[] by Begin Boundary: IXhead[b] starts a list of the
+	//	records with Begin Boundary b, linked through pIXnext[] in pR[] order.
+	//
+	//	Boundaries never fall outside the Input Stream, so any search for the ONs inside
+	//	B...E only has to walk the lists from B to E, no matter how big Rcount gets.
+	//
+	//----------
+
+	int b, r;
+
+	if (pRD->IXsize < (pRD->Rblocks * R_RECORDS)) { //pR[] has grown
+		pRD->IXsize = pRD->Rblocks * R_RECORDS;
+		pRD->pIXnext = (int *)realloc(pRD->pIXnext, (pRD->IXsize * sizeof(int)));
+	}
+
+	for (b = 0; b < (INQUIRY_LENGTH + 2); b++) pRD->IXhead[b] = 0;
+	pRD->IXspan = 0;
+
+	//Link from the bottom up, so every list comes out in pR[] order
+	for (r = pRD->Rcount; r > 0; r--) {
+		b = pRD->pR[r].B;
+		pRD->pIXnext[r] = pRD->IXhead[b];
+		pRD->IXhead[b] = r;
+		if ((pRD->pR[r].E - b) > pRD->IXspan) pRD->IXspan = pRD->pR[r].E - b;
+	}
+}
+
+void ReindexR(RECdata *pRD, int r, int oldB) {
+	//
+	//	pRD->pR[r] has just been reloaded with new boundaries (ReloadR). Move it from the
+	//	list for its old Begin Boundary to the list for its new one.
+	//
+	//----------
+
+	int b, j, p;
+
+	b = pRD->pR[r].B;
+	if ((pRD->pR[r].E - b) > pRD->IXspan) pRD->IXspan = pRD->pR[r].E - b;
+
+	if (b == oldB) return; //same list
+
+	//Unlink r...
+	p = 0;
+	for (j = pRD->IXhead[oldB]; j > 0; j = pRD->pIXnext[j]) {
+		if (j == r) break;
+		p = j;
+	}
+	if (p == 0) {
+		pRD->IXhead[oldB] = pRD->pIXnext[r];
+	} else {
+		pRD->pIXnext[p] = pRD->pIXnext[r];
+	}
+
+	//...and link it back in, in pR[] order
+	p = 0;
+	for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
+		if (j > r) break;
+		p = j;
+	}
+	pRD->pIXnext[r] = j;
+	if (p == 0) {
+		pRD->IXhead[b] = r;
+	} else {
+		pRD->pIXnext[p] = r;
+	}
+}
+
+void CompactR(RECdata *pRD) {
+	//
+	//	Records are deleted by setting their ONcode to 0. Close up the gaps in pRD->pR[]
+	//	in one pass, keeping the live records in order, and reset Rcount.
+	//
+	//----------
+
+	int i, k;
+
+	k = 0; //new record count
+	for (i = 1; i <= pRD->Rcount; i++) {
+		if (pRD->pR[i].ONcode == 0) continue; //deleted record
+		k++;
+		if (k != i) pRD->pR[k] = pRD->pR[i];
+	}
+
+	if (k != pRD->Rcount) {
+		pRD->Rcount = k;
+		IndexR(pRD);
+	}
+}
+
 int RemoveEnvelopments(NdbData *Ndb, RECdata *pRD) {
 	//
 	//	Remove any ON that is fully enveloped and has a Composite Score
@@ -1304,19 +2114,13 @@ int RemoveEnvelopments(NdbData *Ndb, RECdata *pRD) {
 	//
 	//----------
 
-	int redo;
 	int sort;
-	int i, j, k;
+	int i, j;
+	int b;
 	int ilen, jlen;
 	Rdata pt;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nRemoveEnvelopments():... ");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_ENVELOP);
 
 	// sort pRD->pR[] by the Composite Score
 	sort = 1;
@@ -1324,7 +2128,7 @@ int RemoveEnvelopments(NdbData *Ndb, RECdata *pRD) {
 		sort = 0;
 		for (i = 1; i < pRD->Rcount; i++) {
 			for (j = i; j < pRD->Rcount; j++) {
-				if (pRD->pR[j].C < pRD->pR[j+1].C) {
+				if (CompareC(&pRD->pR[j], &pRD->pR[j+1]) < 0) {
 					pt = pRD->pR[j+1];
 					pRD->pR[j+1] = pRD->pR[j];
 					pRD->pR[j] = pt;
@@ -1334,158 +2138,240 @@ int RemoveEnvelopments(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
-	redo = 1;
-	while (redo == 1) {
-		redo = 0;
+	IndexR(pRD);
+
+	//Check for envelopments from the most powerful (CS value) to the least powerful...
+	//Removing an ON never gives a more powerful ON anything new to envelop, so a single
+	//pass settles everything. Removed ONs are marked (ONcode=0) and closed up at the end.
+	for (i = 1; i <= pRD->Rcount; i++) {
+		if (pRD->pR[i].ONcode == 0) continue; //removed
+
+		//Ignore ONs that are too short
+		if (pRD->pR[i].B == pRD->pR[i].E) continue;
+
+		//Is this ON well enough recognized (by %recognition) to envelop anything?
+		if (pRD->pR[i].PER < ENVELOPMENT_THRESHOLD) continue; //No
+
+		for (ilen = 0; ilen < INQUIRY_LENGTH; ilen++) if (pRD->pR[i].dpos[ilen] == 0) break;
+
+		//Only the ONs below pRD->pR[i] that begin inside it can be enveloped by it
+		for (b = pRD->pR[i].B; b <= pRD->pR[i].E; b++) {
+			for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
+				if (j <= i) continue;
+				if (pRD->pR[j].ONcode == 0) continue; //removed
+				if (pRD->pR[j].E > pRD->pR[i].E) continue; //Not fully enveloped by pRD->pR[i]
+
+				//Keeping 'perfect' ONs (%recognized=100) from being removed
+				//helps define the boundaries of less well recognized ONs. 
+				if (pRD->pR[j].PER >= 100) continue;
+
+				//But pRD->pR[j] cannot be removed by an ON that is recognized by fewer RNs...
+				for (jlen = 0; jlen < INQUIRY_LENGTH; jlen++) if (pRD->pR[j].dpos[jlen] == 0) break;
+				if (jlen <= ilen) pRD->pR[j].ONcode = 0; //remove pRD->pR[j]
+			}
+		}
+	}
+
+	CompactR(pRD);
+
+	StageEnd(pRD, STAGE_ENVELOP, pRD->Rcount);
+
+	return 0;
+}
+
+int RetractAnomalousBoundaries(NdbData *Ndb, RECdata *pRD) {
+	//
+	//	Remove an ONs trailing RNs if they belong to another ON
+	//
+	//	Only an ON with a trailing anomaly can be retracted, and it only looks at the ONs
+	//	that begin where it would retract to. ONs that could change, and the ones they look
+	//	at, are put in the same group. Nothing in one group can affect another, so the
+	//	groups are run in parallel, each one in pR[] order - just as if it were one pass.
+	//
+	//----------
+
+	int i, j, k;
+	int r;
+	int Gcount;
+	int *pP;		//Location of pRD->pR[i]'s trailing anomaly in dpos[], 0 if none
+	int *pB;		//The Begin Boundary pRD->pR[i] would give up, 0 if it can't retract
+	int *pGroup;	//Groups as linked trees: pGroup[i] = i at the root
+	int *pFirst;	//First record in the group with this root
+	int *pNext;		//Next record in the same group, in pR[] order
+	int *pRoot;		//The groups
+
+	StageBegin(pRD, STAGE_RETRACTANOMALOUS);
+
+	IndexR(pRD);
+
+	pP = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pB = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pGroup = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pFirst = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pNext = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pRoot = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+
+	for (i = 1; i <= pRD->Rcount; i++) {
+		pGroup[i] = i;
+		pFirst[i] = 0;
+		pNext[i] = 0;
+		pB[i] = AnomalousBoundary(pRD, i, &pP[i]);
+	}
+
+	//Join each ON that can retract with the ONs it looks at that can retract too.
+	//The others never change, so it doesn't matter when they're looked at.
+	for (i = 1; i <= pRD->Rcount; i++) {
+		if (pB[i] == 0) continue;
+		for (j = pRD->IXhead[pB[i]]; j > 0; j = pRD->pIXnext[j]) {
+			if (pB[j] == 0) continue;
+			r = i;
+			while (pGroup[r] != r) r = pGroup[r];
+			k = j;
+			while (pGroup[k] != k) k = pGroup[k];
+			if (r < k) pGroup[k] = r;
+			if (k < r) pGroup[r] = k;
+		}
+	}
+
+	//List each group's records in pR[] order
+	Gcount = 0;
+	for (i = pRD->Rcount; i > 0; i--) {
+		if (pB[i] == 0) continue;
+		r = i;
+		while (pGroup[r] != r) r = pGroup[r];
+		if (pFirst[r] == 0) {
+			pRoot[Gcount] = r;
+			Gcount++;
+		}
+		pNext[i] = pFirst[r];
+		pFirst[r] = i;
+	}
+
+	omp_set_num_threads(ActualThreads);
+	#pragma omp parallel if (Gcount > 1)
+	{
+		int g, n; //private
 
-		//Check for envelopments from the most powerful (CS value) to the least powerful...
-		for (i = 1; i <= pRD->Rcount; i++) {
-			if (redo > 0) break; //get out of i-forloop
-
-			//Ignore ONs that are too short
-			if (pRD->pR[i].B == pRD->pR[i].E) continue;
-
-			//Is this ON well enough recognized (by %recognition) to envelop anything?
-			if (pRD->pR[i].PER < ENVELOPMENT_THRESHOLD) continue; //No
-
-			//Start comparing ONs from the bottom up...
-			for (j = pRD->Rcount; j > i; j--) {
-				//Is this ON fully enveloped by pRD->pR[i]?
-				if ((pRD->pR[i].B <= pRD->pR[j].B) && (pRD->pR[j].E <= pRD->pR[i].E)) { //Yes...
-
-					//Keeping 'perfect' ONs (%recognized=100) from being removed
-					//helps define the boundaries of less well recognized ONs. 
-					if (pRD->pR[j].PER < 100) {
-						//But pRD->pR[j] cannot be removed by an ON that is recognized by fewer RNs...
-						for (ilen = 0; ilen < INQUIRY_LENGTH; ilen++) if (pRD->pR[i].dpos[ilen] == 0) break;
-						for (jlen = 0; jlen < INQUIRY_LENGTH; jlen++) if (pRD->pR[j].dpos[jlen] == 0) break;
-						if (jlen <= ilen) {
-							//remove pRD->pR[j] by moving everyone below up
-							for (k = j; k < pRD->Rcount; k++) pRD->pR[k] = pRD->pR[k+1];
-							pRD->Rcount--;
-							redo = 1;
-							break;
-						}
-					}
-				}
-			}
+		#pragma omp for schedule(dynamic)
+		for (g = 0; g < Gcount; g++) {
+			for (n = pFirst[pRoot[g]]; n > 0; n = pNext[n]) RetractAnomalousON(Ndb, pRD, n, pP[n], pB[n]);
 		}
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
+	free(pP);
+	free(pB);
+	free(pGroup);
+	free(pFirst);
+	free(pNext);
+	free(pRoot);
+
+	if (pRD->ShowProgress == 1) printf("Groups=%d ", Gcount);
+	StageEnd(pRD, STAGE_RETRACTANOMALOUS, pRD->Rcount);
 
 	return 0;
 }
 
-int RetractAnomalousBoundaries(NdbData *Ndb, RECdata *pRD) {
+int AnomalousBoundary(RECdata *pRD, int i, int *pP) {
 	//
-	//	Remove an ONs trailing RNs if they belong to another ON
+	//	Find where pRD->pR[i] could retract to: just before its trailing anomaly
+	//
+	//	Returns:	b, the first position given up (new End Boundary + 1), 0 if none
+	//				*pP = the location of the anomaly in dpos[]
 	//
 	//----------
 
-	int h, i, j, k;
+	int j;
 	int len;
-	int p, b;
-	int newE;
+	int p;
 	int dpos1, dpos2;
-	int qpos1, qpos2;
-	int fnd, ok;
-	int x, z;
-	Rdata Rtest;
 
-	clock_t T;
-	double runtime;
+	*pP = 0;
+
+	//Don't retract the boundary of a well-recognized ON (%recognition = 100)
+	if (pRD->pR[i].PER == 100) return 0;
+
+	//Check for anomalies starting from the end of the RN data pRD->pR[i].dpos.
+	for (len = 0; len < INQUIRY_LENGTH; len++) if (pRD->pR[i].dpos[len] == 0) break;
 
-	if (ShowProgress == 1) {
-		printf("\nRetractAnomalousBoundaries():... ");
-		T = clock();
+	p = 0;
+	for (j = (len - 1); j > 0; j--) {
+		dpos1 = pRD->pR[i].dpos[j];
+		dpos2 = pRD->pR[i].dpos[j-1];
+		if ((dpos2 - dpos1) != 1) {
+			p = j;
+			break;
+		}
 	}
 
-	for (i = 1; i <= pRD->Rcount; i++) {
+	if (p == 0) return 0;
+
+	*pP = p;
 
-		//Don't retract the boundary of a well-recognized ON (%recognition = 100)
-		if (pRD->pR[i].PER == 100) continue;
+	//pRD->pR[i].qpos has the positions of the Bound Section from the Input Stream
+	//p - 1 is the position of a possible new End Boundary if the anomaly is "given up"
+	return (pRD->pR[i].qpos[p - 1] + 1);
+}
 
-		//Check for anomalies starting from the end of the RN data pRD->pR[i].dpos.
-		for (len = 0; len < INQUIRY_LENGTH; len++) if (pRD->pR[i].dpos[len] == 0) break;
+void RetractAnomalousON(NdbData *Ndb, RECdata *pRD, int i, int p, int b) {
+	//
+	//	Retract pRD->pR[i]'s End Boundary to b-1, giving up its trailing RNs from dpos[p] on,
+	//	if they belong to another ON and the retraction increases its Composite Score.
+	//
+	//	Only pRD->pR[i] changes, and only its End Boundary, so the index stays as it is.
+	//
+	//----------
 
-		p = 0;
-		for (j = (len - 1); j > 0; j--) {
-			dpos1 = pRD->pR[i].dpos[j];
-			dpos2 = pRD->pR[i].dpos[j-1];
-			if ((dpos2 - dpos1) != 1) {
-				p = j;
+	int h, j, k;
+	int qpos1, qpos2;
+	int fnd, ok;
+	int x, z;
+	Rdata Rtest;
+
+	//Does any other ON have this b as a Begin Boundary?
+	for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
+
+		//Ignore overlapping by the same ON
+		if ((pRD->pR[i].ONcode == pRD->pR[j].ONcode) && (b <= pRD->pR[i].E)) continue;
+		
+		//Ignore pRD->pR[j] if it is less well recognized than pRD->pR[i]: %recognized - quality
+		x = pRD->pR[i].PER - pRD->pR[i].QUAL;
+		z = pRD->pR[j].PER - pRD->pR[j].QUAL;
+		if (x > z) continue;
+
+		//The trailing part of pRD->pR[i] to be removed is from b to pRD->pR[i].E
+		//These are array elements p to the end
+		//Is all of that found in pRD->pR[j]?
+		ok = 1; //assume yes
+		k = p;
+		while (pRD->pR[i].qpos[k] != 0) {
+			qpos1 = pRD->pR[i].qpos[k]; //Is this qpos in pRD->pR[j].qpos[]?
+			fnd = 0;
+			for (h = 0; h < INQUIRY_LENGTH; h++) {
+				qpos2 = pRD->pR[j].qpos[h];
+				if (qpos2 == 0) break; //searched to the end
+				if (qpos2 != qpos1) continue;
+				fnd = 1;
+				break;
+			}
+			if (fnd == 0) {
+				ok = 0;
 				break;
 			}
+			k++; //get next qpos1
 		}
-
-		if (p > 0) { //Found an anomaly at location p
-
-			//See if pulling back the End Boundary increases the ON's Composite Score.
-			//pRD->pR[i].qpos has the positions of the Bound Section from the Input Stream
-			newE = p - 1; //This is the position of a possible new End Boundary if the anomaly is "given up"
-
-			b = pRD->pR[i].qpos[newE] + 1; //Does any other ON have this b as a Begin Boundary?
-
-			for (j = 1; j <= pRD->Rcount; j++) {
-				if (pRD->pR[j].B != b) continue;
-
-				//Ignore overlapping by the same ON
-				if ((pRD->pR[i].ONcode == pRD->pR[j].ONcode) && (b <= pRD->pR[i].E)) continue;
-				
-				//Ignore pRD->pR[j] if it is less well recognized than pRD->pR[i]: %recognized - quality
-				x = pRD->pR[i].PER - pRD->pR[i].QUAL;
-				z = pRD->pR[j].PER - pRD->pR[j].QUAL;
-				if (x > z) continue;
-
-				//The trailing part of pRD->pR[i] to be removed is from b to pRD->pR[i].E
-				//These are array elements p to the end
-				//Is all of that found in pRD->pR[j]?
-				ok = 1; //assume yes
-				k = p;
-				while (pRD->pR[i].qpos[k] != 0) {
-					qpos1 = pRD->pR[i].qpos[k]; //Is this qpos in pRD->pR[j].qpos[]?
-					fnd = 0;
-					for (h = 0; h < INQUIRY_LENGTH; h++) {
-						qpos2 = pRD->pR[j].qpos[h];
-						if (qpos2 == 0) break; //searched to the end
-						if (qpos2 != qpos1) continue;
-						fnd = 1;
-						break;
-					}
-					if (fnd == 0) {
-						ok = 0;
-						break;
-					}
-					k++; //get next qpos1
-				}
-				if (ok == 0) continue; //The part to be removed is NOT in pRD->pR[j]...
+		if (ok == 0) continue; //The part to be removed is NOT in pRD->pR[j]...
 	
 
-				//Will this retraction give pRD->pR[i] a higher Composite Score?
-				Rtest = pRD->pR[i]; //Save the original
-				LoadR(Ndb, pRD, i, pRD->pR[i].B, (b-1), pRD->pR[i].ONcode);
-				if (Rtest.C > pRD->pR[i].C) { //Compare Composite Scores
-					// The retracted boundary is NOT better, restore the original...
-					pRD->pR[i] = Rtest;
-				} else {
-					break; //Check the next pRD->pR[i]...
-				}
-			}
+		//Will this retraction give pRD->pR[i] a higher Composite Score?
+		Rtest = pRD->pR[i]; //Save the original
+		ReloadR(Ndb, pRD, i, pRD->pR[i].B, (b-1));
+		if (CompareC(&Rtest, &pRD->pR[i]) > 0) { //Compare Composite Scores
+			// The retracted boundary is NOT better, restore the original...
+			pRD->pR[i] = Rtest;
+		} else {
+			break; //Done with pRD->pR[i]
 		}
 	}
-
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
-
-	return 0;
 }
 
 int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
@@ -1495,7 +2381,7 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 	//
 	//----------
 
-	int i, j, k;
+	int i, j, k, p;
 	int b, e;
 	int fnd;
 	int qpos;
@@ -1503,13 +2389,7 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 	int BB, EB;
 	Rdata Rtest;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nRetractWeakBoundaries():... ");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_RETRACTWEAK);
 
 	//Sort by Begin Boundary
 	fnd = 1;
@@ -1527,6 +2407,8 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
+	IndexR(pRD);
+
 	//Get the highest value for PER (%recognition)
 	topPER = 0;
 	for (i = 1; i <= pRD->Rcount; i++) {
@@ -1576,14 +2458,12 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 			BB = pRD->pR[i].B;
 			EB = 0;
 			k = 0;
-			for (j = 1; j <= pRD->Rcount; j++) {
-				if (pRD->pR[j].B != BB) {
-					if (EB == 0) {
-						continue;
-					} else {
-						break; //The ONs are already sorted by Begin Boundary
-					}
-				}
+			p = 0;
+			for (j = pRD->IXhead[BB]; j > 0; j = pRD->pIXnext[j]) {
+				//The ONs were sorted by Begin Boundary, but retractions below can break up a run
+				//of them. Stop at the first gap, once a candidate has been found.
+				if ((EB != 0) && (j != (p + 1))) break;
+				p = j;
 				if (pRD->pR[j].PER == topPER) continue;
 				if (pRD->pR[j].E > EB) {
 					EB = pRD->pR[j].E;
@@ -1603,12 +2483,15 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 			}
 
 			//Load new competition data for this reduction of pRD->pR[i]
-			LoadR(Ndb, pRD, k, b, e, pRD->pR[k].ONcode);
+			ReloadR(Ndb, pRD, k, b, e);
 			if (pRD->pR[k].PER < RETRACT_BOUNDARY_THRESHOLD) {
 				//Remove pRD->pR[k] by moving those below up.
 				for (j = k; j < pRD->Rcount; j++) pRD->pR[j] = pRD->pR[j+1];
 				pRD->Rcount--;
+				IndexR(pRD);
 				i--; //Don't skip over any
+			} else {
+				ReindexR(pRD, k, BB);
 			}
 		}
 	}
@@ -1625,11 +2508,7 @@ int RetractWeakBoundaries(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
+	StageEnd(pRD, STAGE_RETRACTWEAK, pRD->Rcount);
 
 	return 0;
 }
@@ -1662,14 +2541,14 @@ int ExpandBoundaries(NdbData *Ndb, RECdata *pRD) {
 	int topPER, nextPER;
 	int redo;
 	int len, maxlen, fnd;
+	int Rcnt;
+	int *pSide;	//1 or 2: pR[i] can expand its Begin or End Boundary, 0: neither
 
-	clock_t T;
-	double runtime;
+	StageBegin(pRD, STAGE_EXPAND);
 
-	if (ShowProgress == 1) {
-		printf("\nExpandBoundaries():... ");
-		T = clock();
-	}
+	IndexR(pRD);
+
+	pSide = (int *)malloc((pRD->Rcount + 1) * sizeof(int)); //Rcount only goes down from here
 
 	topPER = 0;
 	END = 0;
@@ -1746,30 +2625,26 @@ int ExpandBoundaries(NdbData *Ndb, RECdata *pRD) {
 			}
 		
 			//Check for Boundry Expansions for any ON with ALL=1 and PER=topPER
-			for (i = 1; i <= pRD->Rcount; i++) {
-				if (pRD->pR[i].ALL != 1) continue;
-				if (pRD->pR[i].PER != topPER) continue;
-
-				B = pRD->pR[i].B;
-				E = pRD->pR[i].E;
-
-				if (B > 1) {
-					if (((B-1) > 1)&&((pRD->Space[B-1] == 0))) { //Do not expand across a pRD->Space[]
-						if ((E - B + 1) > 1) { //A length of one doesn't get to expand
+			//Only the first ON that expands matters, and checking an ON changes nothing,
+			//so all the ONs are checked in parallel and then that one is expanded.
+			Rcnt = pRD->Rcount;
+			omp_set_num_threads(ActualThreads);
+			#pragma omp parallel if (Rcnt >= EXPAND_MP_COUNT)
+			{
+				int k; //private
+
+				#pragma omp for
+				for (k = 1; k <= Rcnt; k++) pSide[k] = ExpansionSide(Ndb, pRD, k, topPER, END);
+			}
 
-							redo=ExpandBeginBoundary(Ndb, pRD, i);
-							if (redo == 1) break;
-						}
-					}
+			for (i = 1; i <= Rcnt; i++) {
+				if (pSide[i] == 1) {
+					redo = ExpandBeginBoundary(Ndb, pRD, i);
+					break;
 				}
-				if (E < END) {
-					if (pRD->Space[E+1] == 0) { //Do not expand across a pRD->Space[]
-						if ((E - B + 1) > 1) { //A length of one doesn't get to expand
-
-							redo=ExpandEndBoundary(Ndb, pRD, i);
-							if (redo == 1) break;
-						}
-					}
+				if (pSide[i] == 2) {
+					redo = ExpandEndBoundary(Ndb, pRD, i);
+					break;
 				}
 			}
 		}
@@ -1782,10 +2657,40 @@ int ExpandBoundaries(NdbData *Ndb, RECdata *pRD) {
 		topPER = nextPER;
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
+	free(pSide);
+
+	StageEnd(pRD, STAGE_EXPAND, pRD->Rcount);
+
+	return 0;
+}
+
+int ExpansionSide(NdbData *Ndb, RECdata *pRD, int Rindex, int topPER, int END) {
+	//
+	//	Would ExpandBoundaries() expand pRD->pR[Rindex] on this pass?
+	//
+	//	Returns:	1 if its Begin Boundary expands, 2 if its End Boundary does, 0 if neither
+	//
+	//----------
+
+	int B, E;
+
+	if (pRD->pR[Rindex].ALL != 1) return 0;
+	if (pRD->pR[Rindex].PER != topPER) return 0;
+
+	B = pRD->pR[Rindex].B;
+	E = pRD->pR[Rindex].E;
+
+	if ((E - B + 1) < 2) return 0; //A length of one doesn't get to expand
+
+	if (B > 1) {
+		if (((B-1) > 1)&&((pRD->Space[B-1] == 0))) { //Do not expand across a pRD->Space[]
+			if (BeginPattern(Ndb, pRD, Rindex, B) > 0) return 1;
+		}
+	}
+	if (E < END) {
+		if (pRD->Space[E+1] == 0) { //Do not expand across a pRD->Space[]
+			if (EndPattern(Ndb, pRD, Rindex, E) > 0) return 2;
+		}
 	}
 
 	return 0;
@@ -1807,21 +2712,16 @@ int ExpandBeginBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 	//
 	//----------
 
-	int i, j, k, p;
+	int b, j;
 	int redo;
 	int stop;
-	int pos, end;
 	int ONcode;
-	int Len, patlen, ln;
+	int patlen, ln;
 	int B1, E1;
-	int RNcode;
-	int ok, fnd;
 	int Pi, Pj;
-	int zln,zok;
 
 	redo = 0;
 	ONcode = pRD->pR[Rindex].ONcode;
-	Len = Ndb->pON[ONcode].Len;
 
 	B1 = pRD->pR[Rindex].B;
 	E1 = pRD->pR[Rindex].E;
@@ -1830,113 +2730,12 @@ int ExpandBeginBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 	while (stop == 0) {
 		stop = 1;
 
-		//rn = last character at the end of the neighboring ON
-		RNcode = pRD->ISRN[B1 - 2]; // -2 because pRD->ISRN[] starts at 0, but boundaries start at 1
-
-		//Does this RN exist in pRD->pR[Rindex] BEFORE E1?
-		for (end = 0; end < INQUIRY_LENGTH; end++) if (Ndb->pON[ONcode].RL[end] == 0) break;
-		end--; //this is the last position in the list
-
-		pos = 0;
-		for (i = 0; i < (Len-1); i++) { //Don't want to go all the way to the end, only go from 0 to Len-2
-			if (Ndb->pON[ONcode].RL[i] == RNcode) {
-				pos = i + 1;
-				break;
-			}
-		}
-
-		if (pos == 0) break;
-		patlen = pos; //length of the pattern
-
-		//A pattern is now defined from pRD->pR[Rindex].rn[0] to pRD->pR[Rindex].rn[pos-1]
-		//Is this pattern blocked by a Space[]?
-		//But allow for a Space at the beginning (B1-patlen).
-		ok = 1;
-		for (i = B1; i > (B1-patlen); i--) {
-			if (i > 1) {
-				if (pRD->Space[i] == 1) { //These i's are Boundaries: 1, 2, 3, ...
-					ok = 0;
-					break;	//Don't expand across a Space
-				}
-			}
-		}
-		if (ok == 0) break;
-
-		//Is the pattern made of RNs from perfect ONs?
-		ok = 0;
-		for (i = (B1-patlen); i < B1; i++) {
-			if (pRD->Owned[i] != 1) { // [i] like qpos
-				ok = 1;
-				break;	//Not perfect
-			}
-		}
-		if (ok == 0) break;
-
-
-		//A pattern has been found in the ON, such as FRI at the beginning of FRIDAY
-		//Does this pattern exist from INPUT(B1-patlen-1) to INPUT(B1-1-1) ?
-		ok = 1;
-		p = 0;
-		for (i = (B1-1-patlen); i < (B1-1); i++) { //-1 because these start at ZERO
-			if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) { //Same RNcodes?
-				ok = 0;
-				break;
-			}
-			p++;
-		}
-		if (ok == 0) break; //no pattern
-		
-		//Is this expansion allowed by other ONs?
-		ok = 1; //assume yes
-		for (j = 1; j <= pRD->Rcount; j++) {
-			
-			if (j == Rindex) continue; //self
-
-			if (pRD->pR[j].ONcode == 0) continue; //This record has been deleted...
-			
-			if (pRD->pR[j].E < (B1-patlen)) continue; //out of range
-			
-			if ((pRD->pR[j].PER != 100)||(pRD->pR[j].QUAL != 0)) continue; //not powerful enough
-			
-			if (pRD->pR[j].B > (B1-patlen)) continue; //A 'perfect' ON is enveloped by this pattern
-
-			//Cannot cross a powerful ON, UNLESS more RNs can be gained on the other side...
-			//Find the previous RN in the Input Stream BEFORE the current beginning of pRD->pR[Rindex]
-			fnd = 0;
-			RNcode = pRD->ISRN[B1-1-patlen-1]; //go one position beyond the beginning of the pattern
-
-			//Does this RN also exist in pRD->pR[Rindex] BEFORE E1?
-			pos = 0;
-			for (i = 0; i < (Len-1); i++) { //don't want to go all the way to the end, only go from 0 to Len-2
-				if (Ndb->pON[ONcode].RL[i] == RNcode) {
-					pos = i + 1;
-					break;
-				}
-			}
-
-			if (pos != 0){
-				zln = pos; //length of the pattern
-
-				//Does this pattern exist from INPUT(B1-patlen-zln-1) to INPUT(B1-1-patlen-1) ?
-				zok = 1;
-				p = 0;
-				for (i = (B1-patlen-zln-1); i < (B1-1-patlen); i++) {
-					if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) {
-						zok = 0;
-						break;
-					}
-					p++;
-				}
-				if (zok == 1) fnd = 1; //found a pattern beyond the 1st one
-
-			}
-			if (fnd == 1) continue;
-			ok = 0;
-		}
-		if (ok == 0) break;	//Cannot cross over powerful ONs
+		patlen = BeginPattern(Ndb, pRD, Rindex, B1);
+		if (patlen == 0) break;
 
 		//Load new competition data for this expansion of pRD->pR[Rindex]
-		LoadR(Ndb, pRD, Rindex, (B1-patlen), E1, ONcode);
+		ReloadR(Ndb, pRD, Rindex, (B1-patlen), E1);
+		ReindexR(pRD, Rindex, B1);
 		B1 = pRD->pR[Rindex].B; //The new Begin Boundary
 
 		stop = 0; //Now that pRD->pR[Rindex] is different, run through this loop again
@@ -1947,13 +2746,12 @@ int ExpandBeginBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 		//pRD->pR[j] cannot be removed by an ON that is recognized by fewer RNs...
 		for (ln = 0; ln < INQUIRY_LENGTH; ln++) if (pRD->pR[Rindex].dpos[ln] == 0) break;
 		Pi = pRD->pR[Rindex].PER * ln;
-		for (j = 1; j <= pRD->Rcount; j++) {
+		for (b = B1; b <= E1; b++) for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
 			if (j == Rindex) continue;
 			if (pRD->pR[j].ONcode == 0) continue; //deleted record
-			if ((pRD->pR[j].E < B1) || (pRD->pR[j].B > E1)) continue; //out of range
 			if ((pRD->pR[j].PER == 100) && (pRD->pR[j].QUAL == 0)) continue; //Don't mess with a 'perfect' ON
 
-			if ((B1 <= pRD->pR[j].B) && (pRD->pR[j].E <= E1)) { //enveloped
+			if (pRD->pR[j].E <= E1) { //enveloped
 				for (ln = 0; ln < INQUIRY_LENGTH; ln++) if (pRD->pR[j].dpos[ln] == 0) break;
 				Pj = pRD->pR[j].PER * ln;
 				if ((Pi > Pj) || (pRD->pR[j].ONcode == ONcode)) {
@@ -1965,113 +2763,172 @@ int ExpandBeginBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 
 	//Records may have been deleted during this loop.
 	//If so, move all non-empty records up and reset Rcount
-	k = 0; //new record count
-	for (i = 1; i <= pRD->Rcount; i++) {
-		if (pRD->pR[i].ONcode != 0) {
-			k++;
-			continue;
-		}
-		//Found an empty record at pRD->pR[i]...
-		for (j = (i+1); j <= pRD->Rcount; j++) {
-			if (pRD->pR[j].ONcode == 0) continue;
-			//found a record for pRD->pR[i]
-			pRD->pR[i] = pRD->pR[j];
-			pRD->pR[j].ONcode = 0;
-			k++;
-			break; //get the next i
-		}
-	}
-	pRD->Rcount = k;
+	CompactR(pRD);
 
 	return redo;
 }
 
-int ExpandEndBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
+int BeginPattern(NdbData *Ndb, RECdata *pRD, int Rindex, int B1) {
 	//
-	//	Check the follow-on RNs from the Input Stream to see if there's a pattern that
-	//	can expand this ON's END Boundary.
+	//	Is there a pattern in front of pRD->pR[Rindex]'s Begin Boundary, B1, that it can
+	//	expand over? Nothing is changed here, so ONs can be checked at the same time.
+	//
+	//	Returns:	the length of the pattern, 0 if the Begin Boundary can't expand
 	//
 	//----------
 
-	int i, j, k, p;
-	int redo;
-	int stop;
+	int i, j, p;
+	int b, low;
 	int pos, end;
 	int ONcode;
-	int Len, patlen, ln;
-	int B1, E1;
+	int Len, patlen;
 	int RNcode;
-	int ok;
-	int Pi, Pj;
+	int ok, fnd;
+	int zln,zok;
 
-	redo = 0;
 	ONcode = pRD->pR[Rindex].ONcode;
 	Len = Ndb->pON[ONcode].Len;
 
-	B1 = pRD->pR[Rindex].B;
-	E1 = pRD->pR[Rindex].E;
+	//rn = last character at the end of the neighboring ON
+	RNcode = pRD->ISRN[B1 - 2]; // -2 because pRD->ISRN[] starts at 0, but boundaries start at 1
 
-	stop = 0;
-	while (stop == 0) {
-		stop = 1;
+	//Does this RN exist in pRD->pR[Rindex] BEFORE E1?
+	for (end = 0; end < INQUIRY_LENGTH; end++) if (Ndb->pON[ONcode].RL[end] == 0) break;
+	end--; //this is the last position in the list
+
+	pos = 0;
+	for (i = 0; i < (Len-1); i++) { //Don't want to go all the way to the end, only go from 0 to Len-2
+		if (Ndb->pON[ONcode].RL[i] == RNcode) {
+			pos = i + 1;
+			break;
+		}
+	}
+
+	if (pos == 0) return 0;
+	patlen = pos; //length of the pattern
+
+	//A pattern is now defined from pRD->pR[Rindex].rn[0] to pRD->pR[Rindex].rn[pos-1]
+	//Is this pattern blocked by a Space[]?
+	//But allow for a Space at the beginning (B1-patlen).
+	ok = 1;
+	for (i = B1; i > (B1-patlen); i--) {
+		if (i > 1) {
+			if (pRD->Space[i] == 1) { //These i's are Boundaries: 1, 2, 3, ...
+				ok = 0;
+				break;	//Don't expand across a Space
+			}
+		}
+	}
+	if (ok == 0) return 0;
+
+	//Is the pattern made of RNs from perfect ONs?
+	ok = 0;
+	for (i = (B1-patlen); i < B1; i++) {
+		if (pRD->Owned[i] != 1) { // [i] like qpos
+			ok = 1;
+			break;	//Not perfect
+		}
+	}
+	if (ok == 0) return 0;
 
-		RNcode = pRD->ISRN[E1]; // It's E1, not E1+1 because pRD->ISRN[] starts at 0, but boundaries start at 1
 
-		//Does this RN exist in Ndb->pON[ONcode].RL AFTER B1?
-		for (end = 0; end < INQUIRY_LENGTH; end++) {
-			if (Ndb->pON[ONcode].RL[end] == 0) break;
+	//A pattern has been found in the ON, such as FRI at the beginning of FRIDAY
+	//Does this pattern exist from INPUT(B1-patlen-1) to INPUT(B1-1-1) ?
+	ok = 1;
+	p = 0;
+	for (i = (B1-1-patlen); i < (B1-1); i++) { //-1 because these start at ZERO
+		if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) { //Same RNcodes?
+			ok = 0;
+			break;
 		}
-		end--; //this is the last position in the list
+		p++;
+	}
+	if (ok == 0) return 0; //no pattern
+	
+	//Is this expansion allowed by other ONs?
+	//Only an ON beginning within IXspan of (B1-patlen) can reach that far...
+	low = B1 - patlen - pRD->IXspan;
+	if (low < 0) low = 0;
+	ok = 1; //assume yes
+	for (b = (B1-patlen); b >= low; b--) for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
+		
+		if (j == Rindex) continue; //self
+
+		if (pRD->pR[j].ONcode == 0) continue; //This record has been deleted...
+		
+		if (pRD->pR[j].E < (B1-patlen)) continue; //out of range
+		
+		if ((pRD->pR[j].PER != 100)||(pRD->pR[j].QUAL != 0)) continue; //not powerful enough
+
+		//Cannot cross a powerful ON, UNLESS more RNs can be gained on the other side...
+		//Find the previous RN in the Input Stream BEFORE the current beginning of pRD->pR[Rindex]
+		fnd = 0;
+		RNcode = pRD->ISRN[B1-1-patlen-1]; //go one position beyond the beginning of the pattern
 
+		//Does this RN also exist in pRD->pR[Rindex] BEFORE E1?
 		pos = 0;
-		for (i = (Len-1); i > 0; i--) { //Don't want to go all the way to the beginning, only go from Len-1 to 1
+		for (i = 0; i < (Len-1); i++) { //don't want to go all the way to the end, only go from 0 to Len-2
 			if (Ndb->pON[ONcode].RL[i] == RNcode) {
-				pos = i;
+				pos = i + 1;
 				break;
 			}
 		}
-		if (pos == 0) break;
 
-		patlen = end - pos + 1; //pos & end are positions in a list that starts at zero
+		if (pos != 0){
+			zln = pos; //length of the pattern
 
-		//A pattern is now defined from Ndb->pON[ONcode].RL[pos] to Ndb->pON[ONcode].RL[end]
-		//Is this pattern blocked by a Space[]?
-		ok = 1;
-		for (i = (E1+1); i < (E1+patlen+1); i++) {
-			if (i > end) {
-				if (pRD->Space[i] == 1) { //Space[] is 1, 2, 3, ...
-					ok = 0;
-					break;	//Don't expand across a Space
+			//Does this pattern exist from INPUT(B1-patlen-zln-1) to INPUT(B1-1-patlen-1) ?
+			zok = 1;
+			p = 0;
+			for (i = (B1-patlen-zln-1); i < (B1-1-patlen); i++) {
+				if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) {
+					zok = 0;
+					break;
 				}
+				p++;
 			}
-		}
-		if (ok == 0) break;
+			if (zok == 1) fnd = 1; //found a pattern beyond the 1st one
 
-		//Is the pattern made of RNs from perfect ONs?
-		ok = 0;
-		for (i = E1+1; i < (E1+patlen+1); i++) {
-			if (pRD->Owned[i] != 1) { //Owned[] is 1, 2, 3, ...
-				ok = 1;
-				break;	//Not perfect
-			}
 		}
-		if (ok == 0) break;
+		if (fnd == 1) continue;
+		ok = 0;
+	}
+	if (ok == 0) return 0;	//Cannot cross over powerful ONs
 
-		//A pattern has been found in the ON, such as AY at the end of FRIDAY
-		//Does this pattern exist from INPUT(E1) to INPUT(E1+patlen-1) ?
-		ok = 1;
-		p = pos;
-		for (i = E1; i < (E1+patlen); i++) {
-			if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) {
-				ok = 0;
-				break;
-			}
-			p++;
-		}
-		if (ok == 0) break; //no pattern
+	return patlen;
+}
+
+int ExpandEndBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
+	//
+	//	Check the follow-on RNs from the Input Stream to see if there's a pattern that
+	//	can expand this ON's END Boundary.
+	//
+	//----------
+
+	int b, j;
+	int redo;
+	int stop;
+	int ONcode;
+	int patlen, ln;
+	int B1, E1;
+	int Pi, Pj;
+
+	redo = 0;
+	ONcode = pRD->pR[Rindex].ONcode;
+
+	B1 = pRD->pR[Rindex].B;
+	E1 = pRD->pR[Rindex].E;
+
+	stop = 0;
+	while (stop == 0) {
+		stop = 1;
+
+		patlen = EndPattern(Ndb, pRD, Rindex, E1);
+		if (patlen == 0) break;
 
 		//Load new competition data for this expansion of pRD->pR[Rindex]
-		LoadR(Ndb, pRD, Rindex, B1, (E1+patlen), ONcode);
+		ReloadR(Ndb, pRD, Rindex, B1, (E1+patlen));
+		ReindexR(pRD, Rindex, B1);
 		E1 = pRD->pR[Rindex].E;
 
 		stop = 0; //Now that pRD->pR[Rindex] is different, run through this loop again
@@ -2082,13 +2939,12 @@ int ExpandEndBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 		//pRD->pR[j] cannot be removed by an ON that is recognized by fewer RNs...
 		for (ln = 0; ln < INQUIRY_LENGTH; ln++) if (pRD->pR[Rindex].dpos[ln] == 0) break;
 		Pi = pRD->pR[Rindex].PER * ln;
-		for (j = 1; j <= pRD->Rcount; j++) {
+		for (b = B1; b <= E1; b++) for (j = pRD->IXhead[b]; j > 0; j = pRD->pIXnext[j]) {
 			if (j == Rindex) continue;
 			if (pRD->pR[j].ONcode == 0) continue; //deleted record
-			if ((pRD->pR[j].E < B1) || (pRD->pR[j].B > E1)) continue; //out of range
 			if ((pRD->pR[j].PER == 100) && (pRD->pR[j].QUAL == 0)) continue; //Don't mess with a 'perfect' ON
 
-			if ((B1 <= pRD->pR[j].B) && (pRD->pR[j].E <= E1)) { //enveloped
+			if (pRD->pR[j].E <= E1) { //enveloped
 				for (ln = 0; ln < INQUIRY_LENGTH; ln++) if (pRD->pR[j].dpos[ln] == 0) break;
 				Pj = pRD->pR[j].PER * ln;
 				if ((Pi > Pj) || (pRD->pR[j].ONcode == ONcode)) {
@@ -2100,25 +2956,86 @@ int ExpandEndBoundary(NdbData *Ndb, RECdata *pRD, int Rindex) {
 
 	//Records may have been deleted during this loop.
 	//If so, move all non-empty records up and reset Rcount
-	k = 0; //new record count
-	for (i = 1; i <= pRD->Rcount; i++) {
-		if (pRD->pR[i].ONcode != 0) {
-			k++;
-			continue;
+	CompactR(pRD);
+
+	return redo;
+}
+
+int EndPattern(NdbData *Ndb, RECdata *pRD, int Rindex, int E1) {
+	//
+	//	Is there a pattern after pRD->pR[Rindex]'s End Boundary, E1, that it can expand
+	//	over? Nothing is changed here, so ONs can be checked at the same time.
+	//
+	//	Returns:	the length of the pattern, 0 if the End Boundary can't expand
+	//
+	//----------
+
+	int i, p;
+	int pos, end;
+	int ONcode;
+	int Len, patlen;
+	int RNcode;
+	int ok;
+
+	ONcode = pRD->pR[Rindex].ONcode;
+	Len = Ndb->pON[ONcode].Len;
+
+	RNcode = pRD->ISRN[E1]; // It's E1, not E1+1 because pRD->ISRN[] starts at 0, but boundaries start at 1
+
+	//Does this RN exist in Ndb->pON[ONcode].RL AFTER B1?
+	for (end = 0; end < INQUIRY_LENGTH; end++) {
+		if (Ndb->pON[ONcode].RL[end] == 0) break;
+	}
+	end--; //this is the last position in the list
+
+	pos = 0;
+	for (i = (Len-1); i > 0; i--) { //Don't want to go all the way to the beginning, only go from Len-1 to 1
+		if (Ndb->pON[ONcode].RL[i] == RNcode) {
+			pos = i;
+			break;
+		}
+	}
+	if (pos == 0) return 0;
+
+	patlen = end - pos + 1; //pos & end are positions in a list that starts at zero
+
+	//A pattern is now defined from Ndb->pON[ONcode].RL[pos] to Ndb->pON[ONcode].RL[end]
+	//Is this pattern blocked by a Space[]?
+	ok = 1;
+	for (i = (E1+1); i < (E1+patlen+1); i++) {
+		if (i > end) {
+			if (pRD->Space[i] == 1) { //Space[] is 1, 2, 3, ...
+				ok = 0;
+				break;	//Don't expand across a Space
+			}
 		}
-		//Found an empty record at pRD->pR[i]...
-		for (j = (i+1); j <= pRD->Rcount; j++) {
-			if (pRD->pR[j].ONcode == 0) continue;
-			//found a record for pRD->pR[i]
-			pRD->pR[i] = pRD->pR[j];
-			pRD->pR[j].ONcode = 0;
-			k++;
-			break; //get the next i
+	}
+	if (ok == 0) return 0;
+
+	//Is the pattern made of RNs from perfect ONs?
+	ok = 0;
+	for (i = E1+1; i < (E1+patlen+1); i++) {
+		if (pRD->Owned[i] != 1) { //Owned[] is 1, 2, 3, ...
+			ok = 1;
+			break;	//Not perfect
+		}
+	}
+	if (ok == 0) return 0;
+
+	//A pattern has been found in the ON, such as AY at the end of FRIDAY
+	//Does this pattern exist from INPUT(E1) to INPUT(E1+patlen-1) ?
+	ok = 1;
+	p = pos;
+	for (i = E1; i < (E1+patlen); i++) {
+		if (pRD->ISRN[i] != Ndb->pON[ONcode].RL[p]) {
+			ok = 0;
+			break;
 		}
+		p++;
 	}
-	pRD->Rcount = k;
+	if (ok == 0) return 0; //no pattern
 
-	return redo;
+	return patlen;
 }
 
 void RemoveWeakONs(NdbData *Ndb, RECdata *pRD) {
@@ -2127,33 +3044,33 @@ void RemoveWeakONs(NdbData *Ndb, RECdata *pRD) {
 	//
 	//----------
 
-	int i, j;
+	int i;
+	int skip;
 	int len;
-	float power;
-
-	clock_t T;
-	double runtime;
+	long long power;
 
-	if (ShowProgress == 1) {
-		printf("\nRemoveWeakONs():... ");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_WEAKONS);
 
+	//Removed ONs are marked (ONcode=0) and closed up at the end.
+	//The ON right after a removed one has always been passed over, and still is.
+	skip = 0;
 	for (i = 1; i <= pRD->Rcount; i++) {
+		if (skip == 1) {
+			skip = 0;
+			continue;
+		}
+
 		len = pRD->pR[i].E - pRD->pR[i].B + 1;
-		power = pRD->pR[i].C * (float)len;
-		if ((power - 0.001) > WEAK_ON_THRESHOLD) continue;
+		power = pRD->pR[i].C * len;
+		if (power > (long long)((WEAK_ON_THRESHOLD + 0.001) * C_UNIT)) continue;
  
-		// Remove pRD->pR[i] by moving all those below up
-		for (j = i; j < pRD->Rcount; j++) pRD->pR[j] = pRD->pR[j+1];
-		pRD->Rcount--;
+		pRD->pR[i].ONcode = 0; //remove pRD->pR[i]
+		skip = 1;
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
+	CompactR(pRD);
+
+	StageEnd(pRD, STAGE_WEAKONS, pRD->Rcount);
 
 }
 
@@ -2167,13 +3084,7 @@ void GetAnomalyCounts(RECdata *pRD) {
 	int ln, x, y;
 	int cntA;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nGetAnomalyCounts():... ");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_ANOMALYCOUNTS);
 
 	for (i = 1; i <= pRD->Rcount; i++) {
 
@@ -2220,11 +3131,8 @@ void GetAnomalyCounts(RECdata *pRD) {
 		pRD->pR[i].cntA = cntA;
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
+	StageEnd(pRD, STAGE_ANOMALYCOUNTS, pRD->Rcount);
+	ExplainStage(pRD, STAGE_ANOMALYCOUNTS);
 
 }
 
@@ -2240,30 +3148,431 @@ int MakeBranches(NdbData *Ndb, RECdata *pRD) { //Ndb included for any diagnostic
 	//----------
 
 	int i, j, r;
-	int lowB, highB;
+	int lowB;
 	int Tlen;
-	float TC;
-	int fnd;
+	long long TC;
+	int traced;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nMakeBranches():... ");
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_BRANCHES);
 
 	pRD->BRHcount = 0;
 	pRD->BRcount = 0;
 
 	// Initialization: find the lowest Begin Boundary
 	lowB = INQUIRY_LENGTH;
-	highB = 0;
 	for (r = 1; r <= pRD->Rcount; r++) {
 		if (pRD->pR[r].B < lowB) lowB = pRD->pR[r].B;
 		pRD->pR[r].InBranch = 0; //Also make sure no ON is assigned to a branch yet
 	}
 
+	//Only the branches that can compete are traced through the DAG of ONs, unless
+	//there are so many branches that they have to be built, and culled, one by one
+	traced = 1;
+	if (TraceBranches(Ndb, pRD, lowB) != 0) {
+		traced = 0;
+		GrowBranches(Ndb, pRD, lowB);
+		free(pRD->pBeamLens); //From TraceBranches(), in Beam mode
+		pRD->pBeamLens = NULL;
+	}
+
+	//For each viable branch, get its total length and its cumulative Composite Score
+	for (i = 1; i <= pRD->BRHcount; i++) {
+		if (pRD->pBRH[i].Deleted == 1) continue;
+		j = pRD->pBRH[i].First;
+		r = pRD->pBR[j].R;
+		Tlen = pRD->pR[r].E - pRD->pR[r].B + 1;
+		TC = pRD->pR[r].C;
+
+		while (pRD->pBR[j].Next > 0) {
+			j = pRD->pBR[j].Next;
+			r = pRD->pBR[j].R;
+			Tlen = Tlen + (pRD->pR[r].E - pRD->pR[r].B + 1);
+			TC = TC + pRD->pR[r].C;
+		}
+		pRD->pBRH[i].Tlength = Tlen;
+		pRD->pBRH[i].TCscore = TC;
+	}
+
+	if (pRD->ShowProgress == 1) printf("(%s) ", (traced == 1) ? "traced" : "built");
+	StageEnd(pRD, STAGE_BRANCHES, pRD->BRHcount);
+	ExplainStage(pRD, STAGE_BRANCHES);
+
+	return 0;
+}
+
+int TraceBranches(NdbData *Ndb, RECdata *pRD, int lowB) {
+	//
+	//	The ONs in pRD->pR[] make a DAG: an ON's successors are the ONs BuildBranches() would
+	//	add after it, and they depend only on its End Boundary. One pass over the ONs, from
+	//	the last Begin Boundary to the first, gives every ON:
+	//		- the number of branches that start with it
+	//		- the lengths of those branches (one bit per length)
+	//		- the best cumulative Composite Score of those branches, and its lengths
+	//
+	//	That's enough to know LongLen and LongLenC (see CompeteBranches) before any branch
+	//	exists. Then only the branches that can end up with one of those lengths are traced,
+	//	in the same order BuildBranches() would make them, and only they are put in pBRH[].
+	//
+	//	Which branches BuildBranches() culls depends on the order they are built, so nothing
+	//	is done here if there can be more than BRANCH_CULL_COUNT of them.
+	//
+	//	Returns:	0 if the branches are in pBRH[], 1 if they have to be built (GrowBranches)
+	//
+	//----------
+
+	int i, n, r, s, t, x;
+	int b, f;
+	int h, Hcount, Hcnt;
+	int pass;
+	int highB;
+	int len, LongLen;
+	int keep;
+	int add;
+	long paths;
+	long long maxC;
+	unsigned long long Target[2];
+	unsigned long long Lens[2];
+	int Chain[INQUIRY_LENGTH+1];
+
+	int *pSucc[INQUIRY_LENGTH+2];	//Successors of an ON ending at x-1, in pR[] order
+	int SUCCcount[INQUIRY_LENGTH+2];
+
+	long *pPaths;					//Number of branches starting with pR[r]
+	unsigned long long *pLens;		//Their lengths: 2 words per ON
+	long long *pBest;				//Their best cumulative Composite Score
+	unsigned long long *pBestLens;	//The lengths with that score: 2 words per ON
+	int *pMark;						//1: pR[r] is reached from a head (InBranch)
+	int *pHead;						//1: heads from lowB, 2: heads from the 'overlooked' ONs
+
+	//Traced branches share their beginnings: pTR[t] is the ON at node t, pTprev[t] the node before it
+	int TNcount, TNblocks;
+	int *pTR, *pTprev, *pTlen;
+	int *pH;						//The node at the end of each branch, 0 if it can't compete
+
+	IndexR(pRD);
+
+	for (x = 0; x < (INQUIRY_LENGTH + 2); x++) pSucc[x] = NULL;
+
+	pPaths = (long *)malloc((pRD->Rcount + 1) * sizeof(long));
+	pLens = (unsigned long long *)malloc((pRD->Rcount + 1) * 2 * sizeof(unsigned long long));
+	pBest = (long long *)malloc((pRD->Rcount + 1) * sizeof(long long));
+	pBestLens = (unsigned long long *)malloc((pRD->Rcount + 1) * 2 * sizeof(unsigned long long));
+	pMark = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+	pHead = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+
+	//Successor lists, the same way BuildBranches() finds them: the first ON beginning at
+	//or after x, then any others beginning at x - or beyond, if the first one is that short.
+	for (r = 1; r <= pRD->Rcount; r++) {
+		x = pRD->pR[r].E + 1;
+		if (x > (INQUIRY_LENGTH + 1)) continue;
+		if (pSucc[x] != NULL) continue;
+
+		pSucc[x] = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+		SUCCcount[x] = 0;
+		f = 0;
+		for (s = 1; s <= pRD->Rcount; s++) {
+			if (pRD->pR[s].B < x) continue;
+			if (f != 0) {
+				if ((pRD->pR[s].B > x) && (pRD->pR[f].E > x)) continue;
+			} else {
+				f = s;
+			}
+			pSucc[x][SUCCcount[x]] = s;
+			SUCCcount[x]++;
+		}
+	}
+
+	//Successors always begin after an ON ends, so work back from the highest Begin Boundary
+	for (b = (INQUIRY_LENGTH + 1); b >= 0; b--) {
+		for (r = pRD->IXhead[b]; r > 0; r = pRD->pIXnext[r]) {
+			len = pRD->pR[r].E - pRD->pR[r].B + 1;
+			x = pRD->pR[r].E + 1;
+
+			pPaths[r] = 1;
+			pLens[2*r] = 0;
+			pLens[2*r+1] = 0;
+			pBest[r] = 0;
+			pBestLens[2*r] = 0;
+			pBestLens[2*r+1] = 0;
+
+			if ((x > (INQUIRY_LENGTH + 1)) || (SUCCcount[x] == 0)) { //a branch can end here
+				ShiftLengths(NULL, len, &pLens[2*r]);
+				ShiftLengths(NULL, len, &pBestLens[2*r]);
+				pBest[r] = pRD->pR[r].C;
+				continue;
+			}
+
+			pPaths[r] = 0;
+			maxC = -1;
+			for (n = 0; n < SUCCcount[x]; n++) {
+				s = pSucc[x][n];
+				pPaths[r] = pPaths[r] + pPaths[s];
+				if (pPaths[r] > BRANCH_CULL_COUNT) pPaths[r] = BRANCH_CULL_COUNT + 1; //too many, whatever the count
+
+				ShiftLengths(&pLens[2*s], len, Lens);
+				pLens[2*r] |= Lens[0];
+				pLens[2*r+1] |= Lens[1];
+
+				if (pBest[s] > maxC) {
+					maxC = pBest[s];
+					pBestLens[2*r] = 0;
+					pBestLens[2*r+1] = 0;
+				}
+				if (pBest[s] == maxC) {
+					ShiftLengths(&pBestLens[2*s], len, Lens);
+					pBestLens[2*r] |= Lens[0];
+					pBestLens[2*r+1] |= Lens[1];
+				}
+			}
+			pBest[r] = pRD->pR[r].C + maxC;
+		}
+	}
+
+	//The heads: first the ONs at lowB, then the ONs none of their branches reach (see GrowBranches)
+	for (r = 1; r <= pRD->Rcount; r++) {
+		pMark[r] = 0;
+		pHead[r] = 0;
+	}
+
+	highB = 0;
+	for (r = 1; r <= pRD->Rcount; r++) {
+		if (pRD->pR[r].B != lowB) continue;
+		if (pRD->pR[r].E > highB) highB = pRD->pR[r].E;
+		pHead[r] = 1;
+		pMark[r] = 1;
+	}
+	for (b = 0; b <= (INQUIRY_LENGTH + 1); b++) {
+		for (r = pRD->IXhead[b]; r > 0; r = pRD->pIXnext[r]) {
+			if (pMark[r] == 0) continue;
+			x = pRD->pR[r].E + 1;
+			if (x > (INQUIRY_LENGTH + 1)) continue;
+			for (n = 0; n < SUCCcount[x]; n++) pMark[pSucc[x][n]] = 1;
+		}
+	}
+
+	for (r = 1; r <= pRD->Rcount; r++) {
+		if (pMark[r] != 0) continue;
+		if (pRD->pR[r].PER <= UNUSED_THRESHOLD) continue;
+		if (pRD->pR[r].B > highB) continue;
+		pHead[r] = 2;
+	}
+
+	//The lengths CompeteBranches() will pick: LongLen, and LongLenC - one of the lengths
+	//with the best cumulative Composite Score (it takes the first such branch it finds)
+	LongLen = 0;
+	maxC = 0;
+	for (r = 1; r <= pRD->Rcount; r++) {
+		if (pHead[r] == 0) continue;
+		for (len = 127; len > LongLen; len--) {
+			if (pLens[2*r + len/64] & (1ULL << (len % 64))) {
+				LongLen = len;
+				break;
+			}
+		}
+		if (pBest[r] > maxC) maxC = pBest[r];
+	}
+	Target[0] = 0;
+	Target[1] = 0;
+	ShiftLengths(NULL, LongLen, Target);
+	if (maxC > 0) {
+		for (r = 1; r <= pRD->Rcount; r++) {
+			if ((pHead[r] == 0) || (pBest[r] != maxC)) continue;
+			Target[0] |= pBestLens[2*r];
+			Target[1] |= pBestLens[2*r+1];
+		}
+	}
+
+	paths = 0;
+	for (r = 1; r <= pRD->Rcount; r++) if (pHead[r] != 0) paths = paths + pPaths[r];
+
+	if (paths > BRANCH_CULL_COUNT) { //Culling could start: the branches have to be built
+		for (x = 0; x < (INQUIRY_LENGTH + 2); x++) free(pSucc[x]);
+		free(pPaths);
+		if (pRD->Beam > 0) { //Keep the lengths to judge the branches the beam drops
+			pRD->pBeamLens = pLens;
+			pRD->BeamTarget[0] = Target[0];
+			pRD->BeamTarget[1] = Target[1];
+		} else {
+			free(pLens);
+		}
+		free(pBest);
+		free(pBestLens);
+		free(pMark);
+		free(pHead);
+		return 1;
+	}
+
+	//Trace the branches in the same order BuildBranches() makes them: each pass extends every
+	//branch by its first successor, and puts copies with the others at the end of the list.
+	//Branches that can't reach a Target length are dropped, with everything they would become.
+	TNcount = 0;
+	TNblocks = 1;
+	pTR = (int *)malloc(BR_RECORDS * sizeof(int));
+	pTprev = (int *)malloc(BR_RECORDS * sizeof(int));
+	pTlen = (int *)malloc(BR_RECORDS * sizeof(int));
+	pH = (int *)malloc((paths + 1) * sizeof(int));
+	Hcount = 0;
+
+	for (pass = 1; pass <= 2; pass++) {
+		for (r = 1; r <= pRD->Rcount; r++) {
+			if (pHead[r] != pass) continue;
+			Hcount++;
+			pH[Hcount] = 0;
+			if (((pLens[2*r] & Target[0]) | (pLens[2*r+1] & Target[1])) == 0) continue;
+
+			TNcount++;
+			if ((TNcount % BR_RECORDS) == 0) { // The list is full
+				TNblocks++;
+				pTR = realloc(pTR, (TNblocks * BR_RECORDS * sizeof(int)));
+				pTprev = realloc(pTprev, (TNblocks * BR_RECORDS * sizeof(int)));
+				pTlen = realloc(pTlen, (TNblocks * BR_RECORDS * sizeof(int)));
+			}
+			pTR[TNcount] = r;
+			pTprev[TNcount] = 0;
+			pTlen[TNcount] = pRD->pR[r].E - pRD->pR[r].B + 1;
+			pH[Hcount] = TNcount;
+		}
+
+		add = 1;
+		while (add > 0) {
+			add = 0;
+			Hcnt = Hcount;
+			for (h = 1; h <= Hcnt; h++) {
+				t = pH[h];
+				if (t == 0) continue;
+				x = pRD->pR[pTR[t]].E + 1;
+				if (x > (INQUIRY_LENGTH + 1)) continue;
+
+				for (n = 0; n < SUCCcount[x]; n++) {
+					s = pSucc[x][n];
+					ShiftLengths(&pLens[2*s], pTlen[t], Lens);
+					keep = (((Lens[0] & Target[0]) | (Lens[1] & Target[1])) != 0);
+
+					if (n == 0) pH[h] = 0; //The first successor is added to this branch, the others to copies
+					if (keep == 0) continue;
+
+					TNcount++;
+					if ((TNcount % BR_RECORDS) == 0) { // The list is full
+						TNblocks++;
+						pTR = realloc(pTR, (TNblocks * BR_RECORDS * sizeof(int)));
+						pTprev = realloc(pTprev, (TNblocks * BR_RECORDS * sizeof(int)));
+						pTlen = realloc(pTlen, (TNblocks * BR_RECORDS * sizeof(int)));
+					}
+					pTR[TNcount] = s;
+					pTprev[TNcount] = t;
+					pTlen[TNcount] = pTlen[t] + (pRD->pR[s].E - pRD->pR[s].B + 1);
+					if (n == 0) {
+						pH[h] = TNcount;
+					} else {
+						Hcount++;
+						pH[Hcount] = TNcount;
+					}
+					add++;
+				}
+			}
+		}
+	}
+
+	//Only now do the surviving branches get their pBRH[] & pBR[] memory
+	for (h = 1; h <= Hcount; h++) {
+		if (pH[h] == 0) continue;
+
+		n = 0;
+		for (t = pH[h]; t > 0; t = pTprev[t]) {
+			Chain[n] = pTR[t];
+			n++;
+		}
+
+		addBRHcount(pRD);
+		addBRcount(pRD);
+		pRD->pBRH[pRD->BRHcount].First = pRD->BRcount;
+		pRD->pBRH[pRD->BRHcount].Last = pRD->BRcount;
+		pRD->pBRH[pRD->BRHcount].Tlength = 0;
+		pRD->pBRH[pRD->BRHcount].TCscore = 0;
+		pRD->pBRH[pRD->BRHcount].Deleted = 0;
+
+		pRD->pBR[pRD->BRcount].R = Chain[n-1];
+		pRD->pBR[pRD->BRcount].Next = 0;
+		pRD->pBR[pRD->BRcount].Prev = 0;
+
+		for (i = (n - 2); i >= 0; i--) {
+			addBRcount(pRD);
+			pRD->pBR[pRD->BRcount-1].Next = pRD->BRcount;
+			pRD->pBR[pRD->BRcount].R = Chain[i];
+			pRD->pBR[pRD->BRcount].Prev = pRD->BRcount-1;
+			pRD->pBR[pRD->BRcount].Next = 0;
+			pRD->pBRH[pRD->BRHcount].Last = pRD->BRcount;
+		}
+	}
+
+	//Every ON a branch would have reached is InBranch, as if they'd all been built
+	for (b = 0; b <= (INQUIRY_LENGTH + 1); b++) {
+		for (r = pRD->IXhead[b]; r > 0; r = pRD->pIXnext[r]) {
+			if (pHead[r] != 0) pMark[r] = 1;
+			if (pMark[r] == 0) continue;
+			x = pRD->pR[r].E + 1;
+			if (x > (INQUIRY_LENGTH + 1)) continue;
+			for (n = 0; n < SUCCcount[x]; n++) pMark[pSucc[x][n]] = 1;
+		}
+	}
+	for (r = 1; r <= pRD->Rcount; r++) pRD->pR[r].InBranch = pMark[r];
+
+	for (x = 0; x < (INQUIRY_LENGTH + 2); x++) free(pSucc[x]);
+	free(pPaths);
+	free(pLens);
+	free(pBest);
+	free(pBestLens);
+	free(pMark);
+	free(pHead);
+	free(pTR);
+	free(pTprev);
+	free(pTlen);
+	free(pH);
+
+	return 0;
+}
+
+void ShiftLengths(unsigned long long *in, int n, unsigned long long *out) {
+	//
+	//	A set of branch lengths 0...127 is kept as bits in 2 words.
+	//	out = in shifted up by n lengths, or just length n if in is NULL.
+	//
+	//----------
+
+	if (in == NULL) {
+		if ((n < 0) || (n > 127)) return;
+		out[n / 64] |= (1ULL << (n % 64));
+		return;
+	}
+
+	if (n >= 128) {
+		out[0] = 0;
+		out[1] = 0;
+	} else if (n >= 64) {
+		out[1] = in[0] << (n - 64);
+		out[0] = 0;
+	} else if (n > 0) {
+		out[1] = (in[1] << n) | (in[0] >> (64 - n));
+		out[0] = in[0] << n;
+	} else {
+		out[0] = in[0];
+		out[1] = in[1];
+	}
+}
+
+void GrowBranches(NdbData *Ndb, RECdata *pRD, int lowB) {
+	//
+	//	Build every branch, one ON at a time (BuildBranches), starting from the ONs at lowB
+	//	and then from any ONs they overlooked.
+	//
+	//----------
+
+	int r;
+	int highB;
+	int fnd;
+
+	highB = 0;
+
 	//Store all the Branch Heads: they all begin with the lowest Begin Boundary: lowB
 	//Use these few ONs to set highB as a cutoff for branches that may be created with
 	//any Unused ONs. These would be ONs with Begin Boundaries that are after lowB AND
@@ -2281,7 +3590,7 @@ int MakeBranches(NdbData *Ndb, RECdata *pRD) { //Ndb included for any diagnostic
 		pRD->pBRH[pRD->BRHcount].First = pRD->BRcount;
 		pRD->pBRH[pRD->BRHcount].Last = pRD->BRcount;
 		pRD->pBRH[pRD->BRHcount].Tlength = 0;
-		pRD->pBRH[pRD->BRHcount].TCscore = 0.0;
+		pRD->pBRH[pRD->BRHcount].TCscore = 0;
 		pRD->pBRH[pRD->BRHcount].Deleted = 0;
 
 		//First branch member
@@ -2311,7 +3620,7 @@ int MakeBranches(NdbData *Ndb, RECdata *pRD) { //Ndb included for any diagnostic
 		pRD->pBRH[pRD->BRHcount].First = pRD->BRcount;
 		pRD->pBRH[pRD->BRHcount].Last = pRD->BRcount;
 		pRD->pBRH[pRD->BRHcount].Tlength = 0;
-		pRD->pBRH[pRD->BRHcount].TCscore = 0.0;
+		pRD->pBRH[pRD->BRHcount].TCscore = 0;
 		pRD->pBRH[pRD->BRHcount].Deleted = 0;
 
 		//First branch member
@@ -2325,32 +3634,6 @@ int MakeBranches(NdbData *Ndb, RECdata *pRD) { //Ndb included for any diagnostic
 	}
 	
 	if (fnd > 0) BuildBranches(Ndb, pRD);
-
-	//For each viable branch, get its total length and its cumulative Composite Score
-	for (i = 1; i <= pRD->BRHcount; i++) {
-		if (pRD->pBRH[i].Deleted == 1) continue;
-		j = pRD->pBRH[i].First;
-		r = pRD->pBR[j].R;
-		Tlen = pRD->pR[r].E - pRD->pR[r].B + 1;
-		TC = pRD->pR[r].C;
-
-		while (pRD->pBR[j].Next > 0) {
-			j = pRD->pBR[j].Next;
-			r = pRD->pBR[j].R;
-			Tlen = Tlen + (pRD->pR[r].E - pRD->pR[r].B + 1);
-			TC = TC + pRD->pR[r].C;
-		}
-		pRD->pBRH[i].Tlength = Tlen;
-		pRD->pBRH[i].TCscore = TC;
-	}
-
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf("BoundSections=%d  runtime: %fsec", pRD->Rcount, runtime);
-	}
-
-	return 0;
 }
 
 void BuildBranches(NdbData *Ndb, RECdata *pRD) {
@@ -2359,8 +3642,9 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 	//
 	//----------
 
-	int i, j, k, r;
+	int i, j, k, r, n;
 	int BRHcnt;
+	int BRstart;
 	int BRend;
 	int add;
 	int B, E;
@@ -2368,6 +3652,13 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 	int ok;
 	int PER;
 
+	//The ONs that can follow an End Boundary depend only on the boundary, not on the branch.
+	//Gather them once for each Begin Boundary B (B >= E+1), in pR[] order, when first needed.
+	int *pFollow[INQUIRY_LENGTH+2];
+	int FOLLOWcount[INQUIRY_LENGTH+2];
+
+	for (B = 0; B < (INQUIRY_LENGTH + 2); B++) pFollow[B] = NULL;
+
 	//Can an ON be added to some End Boundary?
 	//If there are multiple such ONs (all with the same Begin Boundary), create new
 	//branches from copies of the current branch, and add the ONs to the new branches.
@@ -2376,6 +3667,7 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 	while (add > 0) {
 		add = 0;
 		BRHcnt = pRD->BRHcount; //Get this value now because BRHcount may change in this loop
+		BRstart = pRD->BRcount; //Branches that grow this round end beyond this member
 
 		for (i = 1; i <= BRHcnt; i++) {
 			if (pRD->pBRH[i].Deleted == 1) continue; //Ignore branches that are likely losers
@@ -2387,17 +3679,26 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 			r = pRD->pBR[j].R;
 			E = pRD->pR[r].E; //Find an ON with a Begin Boundary that fits onto this End Boundary (last in the chain)
 			B = E + 1;
+			if (B > (INQUIRY_LENGTH + 1)) continue; //Nothing begins beyond the Input Stream
+
+			if (pFollow[B] == NULL) {
+				pFollow[B] = (int *)malloc((pRD->Rcount + 1) * sizeof(int));
+				FOLLOWcount[B] = 0;
+				for (r = 1; r <= pRD->Rcount; r++) {
+					if (pRD->pR[r].B < B) continue;
+					pFollow[B][FOLLOWcount[B]] = r;
+					FOLLOWcount[B]++;
+				}
+			}
+
 			fnd = 0;
-			for (r = 1; r <= pRD->Rcount; r++) {
+			for (n = 0; n < FOLLOWcount[B]; n++) {
+				r = pFollow[B][n];
 				ok = 1;
-				if (pRD->pR[r].B < B) {
-					continue;
-				} else {
-					if (pRD->pR[r].B > B) {
-						k = pRD->pBRH[i].Last; //current end of the branch
-						k = pRD->pBR[k].R;
-						if (pRD->pR[k].E > B) ok = 0;
-					}
+				if (pRD->pR[r].B > B) {
+					k = pRD->pBRH[i].Last; //current end of the branch
+					k = pRD->pBR[k].R;
+					if (pRD->pR[k].E > B) ok = 0;
 				}
 				if (ok == 0) continue;
 
@@ -2423,7 +3724,7 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 					pRD->pBRH[pRD->BRHcount].First = pRD->BRcount;
 					pRD->pBRH[pRD->BRHcount].Last = pRD->BRcount;
 					pRD->pBRH[pRD->BRHcount].Tlength = 0;
-					pRD->pBRH[pRD->BRHcount].TCscore = 0.0;
+					pRD->pBRH[pRD->BRHcount].TCscore = 0;
 					pRD->pBRH[pRD->BRHcount].Deleted = 0;
 					
 					k = pRD->pBRH[i].First; //1st ON in the original branch
@@ -2455,6 +3756,9 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 			}
 		}
 
+		//Beam mode: only the best of the branches that just grew are kept
+		if ((pRD->Beam > 0) && (add > 0)) BeamBranches(pRD, BRstart);
+
 		//Cull branches that contain weak ONs
 		//'Weakness' is determined by a 'dynamic' threshold that depends on the number of
 		//competitors. As the number increase, the threshold becomes more stringent.
@@ -2464,7 +3768,7 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 			fnd++;
 		}
 
-		if (fnd > 500) {
+		if (fnd > BRANCH_CULL_COUNT) {
 			for (i = 1; i <= pRD->BRHcount; i++) {
 				if (pRD->pBRH[i].Deleted == 1) continue; //This branch can be ignored because it's a likely loser
 
@@ -2499,6 +3803,86 @@ void BuildBranches(NdbData *Ndb, RECdata *pRD) {
 			}
 		}
 	}
+
+	for (B = 0; B < (INQUIRY_LENGTH + 2); B++) free(pFollow[B]);
+}
+
+void BeamBranches(RECdata *pRD, int BRstart) {
+	//
+	//	Beam mode: of the branches that just grew (their Last member is beyond BRstart),
+	//	keep the pRD->Beam with the best cumulative Composite Score and delete the rest.
+	//	Ties go to the branch made first. Branches that have stopped growing are left alone.
+	//
+	//	If TraceBranches() left its branch lengths in pRD->pBeamLens[], a deleted branch is
+	//	also counted in BeamLost when it could still have grown to one of the lengths
+	//	CompeteBranches() picks, i.e. when the beam may have cost the inquiry a competitor.
+	//
+	//----------
+
+	int i, j, n, r;
+	int best;
+	int Fcount;
+	int len;
+	int *pF;			//The branches that grew
+	int *pLen;			//Their length, without their last ON
+	long long *pTC;		//Their cumulative Composite Score
+	unsigned long long Lens[2];
+
+	Fcount = 0;
+	for (i = 1; i <= pRD->BRHcount; i++) {
+		if (pRD->pBRH[i].Deleted == 1) continue;
+		if (pRD->pBRH[i].Last > BRstart) Fcount++;
+	}
+	if (Fcount <= pRD->Beam) return;
+
+	pF = (int *)malloc(Fcount * sizeof(int));
+	pLen = (int *)malloc(Fcount * sizeof(int));
+	pTC = (long long *)malloc(Fcount * sizeof(long long));
+
+	n = 0;
+	for (i = 1; i <= pRD->BRHcount; i++) {
+		if (pRD->pBRH[i].Deleted == 1) continue;
+		if (pRD->pBRH[i].Last <= BRstart) continue;
+		pF[n] = i;
+		pLen[n] = 0;
+		pTC[n] = 0;
+		j = pRD->pBRH[i].First;
+		while (j > 0) {
+			r = pRD->pBR[j].R;
+			if (j != pRD->pBRH[i].Last) pLen[n] = pLen[n] + (pRD->pR[r].E - pRD->pR[r].B + 1);
+			pTC[n] = pTC[n] + pRD->pR[r].C;
+			j = pRD->pBR[j].Next;
+		}
+		n++;
+	}
+
+	//Pick the best pRD->Beam of them, one at a time: a kept branch is marked with pF[] < 0
+	for (j = 0; j < pRD->Beam; j++) {
+		best = -1;
+		for (n = 0; n < Fcount; n++) {
+			if (pF[n] < 0) continue;
+			if ((best < 0) || (pTC[n] > pTC[best])) best = n;
+		}
+		pF[best] = -pF[best];
+	}
+
+	for (n = 0; n < Fcount; n++) {
+		if (pF[n] < 0) continue;
+		i = pF[n];
+		pRD->pBRH[i].Deleted = 1;
+		pRD->BeamPruned++;
+
+		if (pRD->pBeamLens == NULL) continue;
+		j = pRD->pBRH[i].Last;
+		r = pRD->pBR[j].R;
+		len = pLen[n];
+		ShiftLengths(&pRD->pBeamLens[2*r], len, Lens);
+		if (((Lens[0] & pRD->BeamTarget[0]) != 0) || ((Lens[1] & pRD->BeamTarget[1]) != 0)) pRD->BeamLost++;
+	}
+
+	free(pF);
+	free(pLen);
+	free(pTC);
 }
 
 void addBRHcount(RECdata *pRD) {
@@ -2509,7 +3893,7 @@ void addBRHcount(RECdata *pRD) {
 
 	pRD->BRHcount++;
 
-	if ((pRD->BRHcount % BR_RECORDS) == 0) { // The list is full
+	if (pRD->BRHcount >= (pRD->BRHblocks * BR_RECORDS)) { // The list is full
 		pRD->BRHblocks++;
 		pRD->pBRH = realloc(pRD->pBRH, (pRD->BRHblocks * BR_RECORDS * sizeof(BRHdata))); //pBRH[] branch head
 	}
@@ -2523,7 +3907,7 @@ void addBRcount(RECdata *pRD) {
 
 	pRD->BRcount++;
 
-	if ((pRD->BRcount % BR_RECORDS) == 0) { // The list is full
+	if (pRD->BRcount >= (pRD->BRblocks * BR_RECORDS)) { // The list is full
 		pRD->BRblocks++;
 		pRD->pBR = realloc(pRD->pBR, (pRD->BRblocks * BR_RECORDS * sizeof(BRdata))); //pBR[] branch member
 	}
@@ -2540,22 +3924,17 @@ int CompeteBranches(NdbData *Ndb, RECdata *pRD) {
 	int ONcode;
 	int i, j, b, r;
 	int LongLen, LongLenC;
-	float maxC;
+	long long maxC;
 	int cnt;
 	int res;
 	int Rcount;
+	COMP *pA;
 
-	clock_t T;
-	double runtime;
-
-	if (ShowProgress == 1) {
-		printf("\nCompeteBranches()  #Branches=%d... ", pRD->BRHcount);
-		T = clock();
-	}
+	StageBegin(pRD, STAGE_COMPETE);
 
 	//What is the length of the branch with the highest cumulative Composit Score?
 	//Also, what is the longest length among all the branches?
-	maxC = 0.0;
+	maxC = 0;
 	LongLenC = 0;
 	LongLen = 0;
 	for (i = 1; i <= pRD->BRHcount; i++) {
@@ -2585,10 +3964,20 @@ int CompeteBranches(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
-	if (ShowProgress == 1) {
+	if (pRD->ShowProgress == 1) {
 		printf("\n Tournament: Branchs=%d -> Viable Competitors=%d... ", pRD->BRHcount, pRD->Tcount);
 	}
 
+	//Get everyone's Stand-Alone data so hopeless competitors can be eliminated without a match
+	if (pRD->Tcount > 1) {
+		pA = (COMP *)malloc(sizeof(COMP));
+		for (i = 1; i <= pRD->Tcount; i++) {
+			LoadCompetitor(pRD, i, pA);
+			StandAlone(Ndb, pRD, pA, &pRD->pT[i]);
+		}
+		free(pA);
+	}
+
 	if (pRD->Tcount > 0) {
 
 		res = RunCompetitions(Ndb, pRD); // Run the SCU tournament
@@ -2623,11 +4012,10 @@ int CompeteBranches(NdbData *Ndb, RECdata *pRD) {
 		pRD->RESULTcount = Rcount;
 	}
 
-	if (ShowProgress == 1) {
-		T = clock() - T;
-		runtime = ((double)T) / CLOCKS_PER_SEC;
-		printf(" runtime: %fsec\n", runtime);
-	}
+	if (pRD->ShowProgress == 1) printf("Pruned=%d ", pRD->Pruned);
+	StageEnd(pRD, STAGE_COMPETE, pRD->Matches);
+	ExplainStage(pRD, STAGE_COMPETE);
+	if (pRD->ShowProgress == 1) printf("\n");
 
 	return 0;
 }
@@ -2640,7 +4028,7 @@ void addTcount(RECdata *pRD) {
 
 	pRD->Tcount++;
 
-	if ((pRD->Tcount % T_RECORDS) == 0) { // The list is full
+	if (pRD->Tcount >= (pRD->Tblocks * T_RECORDS)) { // The list is full
 		pRD->Tblocks++;
 		pRD->pT = realloc(pRD->pT, (pRD->Tblocks * T_RECORDS * sizeof(Tdata))); //pT[BR]
 	}
@@ -2665,6 +4053,13 @@ int RunCompetitions(NdbData *Ndb, RECdata *pRD) {
 	int res;
 
 	int Loops, MaxLoops;
+	COMP *pA;
+	COMP *pZ;
+	double t = 0;
+
+	//Scratch memory for BoundMatch()
+	pA = (COMP *)malloc(sizeof(COMP));
+	pZ = (COMP *)malloc(sizeof(COMP));
 
 	Loops = 0;
 	MaxLoops = pRD->Tcount;
@@ -2703,7 +4098,23 @@ int RunCompetitions(NdbData *Ndb, RECdata *pRD) {
 
 		if (CompetitorCount < 2) break; //It's over
 
+		//If one of them can't possibly win, there's no need to run the SCU
+		res = BoundMatch(pRD, &pRD->pT[i], &pRD->pT[j], pA, pZ);
+		if (res == 1) {
+			pRD->pT[i].Eliminated = 1;
+			pRD->Pruned++;
+			continue;
+		}
+		if (res == 2) {
+			pRD->pT[j].Eliminated = 1;
+			pRD->Pruned++;
+			continue;
+		}
+
+		if (pRD->pX != NULL) t = omp_get_wtime(); //Explain mode
 		res = GetWinners(Ndb, pRD, i, j); //Compete i vs j
+		pRD->Matches++;
+		if (pRD->pX != NULL) ExplainMatch(pRD, i, j, omp_get_wtime() - t);
 
 		//If neither is eliminated (identical scores), don't allow them to compete against each other again
 		if ((pRD->pT[i].Eliminated == 0) && (pRD->pT[j].Eliminated == 0)) {
@@ -2729,6 +4140,9 @@ int RunCompetitions(NdbData *Ndb, RECdata *pRD) {
 		}
 	}
 
+	free(pA);
+	free(pZ);
+
 	return 0;
 }
 
@@ -2743,108 +4157,14 @@ int GetWinners(NdbData *Ndb, RECdata *pRD, int a, int z) {
 	//
 	//----------
 
-	int i, j, k, b, r;
 	int res;
 
 	//Memory for the 2 competitors
 	COMP A;
 	COMP Z;
 
-	//Fill in the data for player A...
-	b = pRD->pT[a].BR; //b = index to the branch
-	j = pRD->pBRH[b].First; //index to the lead ON in the branch
-	r = pRD->pBR[j].R; //r = index to the ON data
-	i = 0;
-	A.m[i].B = pRD->pR[r].B;
-	A.m[i].E = pRD->pR[r].E;
-	A.m[i].ONcode = pRD->pR[r].ONcode;
-	A.m[i].nrec = 0; // number of hits in .order[]
-	for (k = 0; k < INQUIRY_LENGTH; k++) {
-		A.m[i].RLhit[k] = 0;
-		A.m[i].order[k].dpos = 0;
-		A.m[i].order[k].qpos = 0;
-		A.m[i].order[k].rn = 0;
-	}
-	A.m[i].PER = pRD->pR[r].PER;
-	A.m[i].QUAL = pRD->pR[r].QUAL;
-	A.m[i].cntA = pRD->pR[r].cntA;
-
-	while (pRD->pBR[j].Next > 0) {
-		j = pRD->pBR[j].Next;
-		r = pRD->pBR[j].R;
-		i++;
-		A.m[i].B = pRD->pR[r].B;
-		A.m[i].E = pRD->pR[r].E;
-		A.m[i].ONcode = pRD->pR[r].ONcode;
-		A.m[i].nrec = 0; // number of hits in .order[]
-		for (k = 0; k < INQUIRY_LENGTH; k++) {
-			A.m[i].RLhit[k] = 0;
-			A.m[i].order[k].dpos = 0;
-			A.m[i].order[k].qpos = 0;
-			A.m[i].order[k].rn = 0;
-		}
-		A.m[i].PER = pRD->pR[r].PER;
-		A.m[i].QUAL = pRD->pR[r].QUAL;
-		A.m[i].cntA = pRD->pR[r].cntA;
-	}
-	A.Mcount = (i + 1); //number of ONs in this player
-	A.Score = 0;
-	A.spaceB = 0;
-	A.anomaly = 0;
-	A.rec = 0;
-	A.minpr = 0;
-	A.bound = 0;
-	A.uncount = 0;
-	A.mislead = 0;
-	for (k = 0; k < INQUIRY_LENGTH; k++) A.SpaceClaim[k] = 0;
-
-
-	//Fill in the data for player Z...
-	b = pRD->pT[z].BR; //b = index to the branch
-	j = pRD->pBRH[b].First; //index to the lead ON in the branch
-	r = pRD->pBR[j].R; //r = index to the ON data
-	i = 0;
-	Z.m[i].B = pRD->pR[r].B;
-	Z.m[i].E = pRD->pR[r].E;
-	Z.m[i].ONcode = pRD->pR[r].ONcode;
-	Z.m[i].nrec = 0; // number of hits in .order[]
-	for (k = 0; k < INQUIRY_LENGTH; k++) {
-		Z.m[i].RLhit[k] = 0;
-		Z.m[i].order[k].dpos = 0;
-		Z.m[i].order[k].qpos = 0;
-		Z.m[i].order[k].rn = 0;
-	}
-	Z.m[i].PER = pRD->pR[r].PER;
-	Z.m[i].QUAL = pRD->pR[r].QUAL;
-	Z.m[i].cntA = pRD->pR[r].cntA;
-	while (pRD->pBR[j].Next > 0) {
-		j = pRD->pBR[j].Next;
-		r = pRD->pBR[j].R;
-		i++;
-		Z.m[i].B = pRD->pR[r].B;
-		Z.m[i].E = pRD->pR[r].E;
-		Z.m[i].ONcode = pRD->pR[r].ONcode;
-		Z.m[i].nrec = 0; // number of hits in .order[]
-		for (k = 0; k < INQUIRY_LENGTH; k++) {
-			Z.m[i].RLhit[k] = 0;
-			Z.m[i].order[k].dpos = 0;
-			Z.m[i].order[k].qpos = 0;
-			Z.m[i].order[k].rn = 0;
-		}
-		Z.m[i].PER = pRD->pR[r].PER;
-		Z.m[i].QUAL = pRD->pR[r].QUAL;
-		Z.m[i].cntA = pRD->pR[r].cntA;
-	}
-	Z.Mcount = (i + 1); //number of ONs in this player
-	Z.Score = 0;
-	Z.spaceB = 0;
-	Z.anomaly = 0;
-	Z.rec = 0;
-	Z.minpr = 0;
-	Z.bound = 0;
-	Z.uncount = 0;
-	Z.mislead = 0;
-	for (k = 0; k < INQUIRY_LENGTH; k++) Z.SpaceClaim[k] = 0;
+	LoadCompetitor(pRD, a, &A); //Fill in the data for player A...
+	LoadCompetitor(pRD, z, &Z); //Fill in the data for player Z...
 
 	res = RunSCU(Ndb, pRD, &A, &Z); //Run the competition between A & Z
 
@@ -2860,4 +4180,45 @@ int GetWinners(NdbData *Ndb, RECdata *pRD, int a, int z) {
 	return 0;
 }
 
+void LoadCompetitor(RECdata *pRD, int t, COMP *player) {
+	//
+	//	Fill in a player's data from tournament competitor pT[t]
+	//
+	//----------
+
+	int i, j, k, b, r;
+
+	b = pRD->pT[t].BR; //b = index to the branch
+	j = pRD->pBRH[b].First; //index to the lead ON in the branch
+	i = -1;
+	while (j > 0) {
+		r = pRD->pBR[j].R; //r = index to the ON data
+		i++;
+		player->m[i].B = pRD->pR[r].B;
+		player->m[i].E = pRD->pR[r].E;
+		player->m[i].ONcode = pRD->pR[r].ONcode;
+		player->m[i].nrec = 0; // number of hits in .order[]
+		for (k = 0; k < INQUIRY_LENGTH; k++) {
+			player->m[i].RLhit[k] = 0;
+			player->m[i].order[k].dpos = 0;
+			player->m[i].order[k].qpos = 0;
+			player->m[i].order[k].rn = 0;
+		}
+		player->m[i].PER = pRD->pR[r].PER;
+		player->m[i].QUAL = pRD->pR[r].QUAL;
+		player->m[i].cntA = pRD->pR[r].cntA;
+		j = pRD->pBR[j].Next;
+	}
+	player->Mcount = (i + 1); //number of ONs in this player
+	player->Score = 0;
+	player->spaceB = 0;
+	player->anomaly = 0;
+	player->rec = 0;
+	player->minpr = 0;
+	player->bound = 0;
+	player->uncount = 0;
+	player->mislead = 0;
+	for (k = 0; k < INQUIRY_LENGTH; k++) player->SpaceClaim[k] = 0;
+}
+
 
@@ -18,6 +18,60 @@ void MisLead(COMP *, COMP *);
 int SetScore(NdbData *, RECdata *, COMP *, int);
 int ExcitatorySpike(int);
 int InhibitorySpike(int);
+void StandAlone(NdbData *, RECdata *, COMP *, Tdata *);
+int BoundMatch(RECdata *, Tdata *, Tdata *, COMP *, COMP *);
+void SelectSCUkernel(void);
+
+
+//Compete() kernels, one for each combination of SCU switches, n = pRD->SCUmask.
+//With n a constant, the compiler drops the tests for the agents that are OFF,
+//so Kernel127 (everything ON) is a straight run through all 7 agents.
+#define SCU_KERNEL(n) \
+void Kernel##n(COMP *pA, COMP *pZ) { \
+	if ((n) & SCU_SPACEB) SpaceB(pA, pZ); \
+	if ((n) & SCU_ANOMALY) Anomaly(pA, pZ); \
+	if ((n) & SCU_REC) Rec(pA, pZ); \
+	if ((n) & SCU_MINPR) MinPR(pA, pZ); \
+	if ((n) & SCU_BOUND) Bound(pA, pZ); \
+	if ((n) & SCU_UNCOUNT) UnCount(pA, pZ); \
+	if ((n) & SCU_MISLEAD) MisLead(pA, pZ); \
+}
+
+SCU_KERNEL(0) SCU_KERNEL(1) SCU_KERNEL(2) SCU_KERNEL(3) SCU_KERNEL(4) SCU_KERNEL(5) SCU_KERNEL(6) SCU_KERNEL(7)
+SCU_KERNEL(8) SCU_KERNEL(9) SCU_KERNEL(10) SCU_KERNEL(11) SCU_KERNEL(12) SCU_KERNEL(13) SCU_KERNEL(14) SCU_KERNEL(15)
+SCU_KERNEL(16) SCU_KERNEL(17) SCU_KERNEL(18) SCU_KERNEL(19) SCU_KERNEL(20) SCU_KERNEL(21) SCU_KERNEL(22) SCU_KERNEL(23)
+SCU_KERNEL(24) SCU_KERNEL(25) SCU_KERNEL(26) SCU_KERNEL(27) SCU_KERNEL(28) SCU_KERNEL(29) SCU_KERNEL(30) SCU_KERNEL(31)
+SCU_KERNEL(32) SCU_KERNEL(33) SCU_KERNEL(34) SCU_KERNEL(35) SCU_KERNEL(36) SCU_KERNEL(37) SCU_KERNEL(38) SCU_KERNEL(39)
+SCU_KERNEL(40) SCU_KERNEL(41) SCU_KERNEL(42) SCU_KERNEL(43) SCU_KERNEL(44) SCU_KERNEL(45) SCU_KERNEL(46) SCU_KERNEL(47)
+SCU_KERNEL(48) SCU_KERNEL(49) SCU_KERNEL(50) SCU_KERNEL(51) SCU_KERNEL(52) SCU_KERNEL(53) SCU_KERNEL(54) SCU_KERNEL(55)
+SCU_KERNEL(56) SCU_KERNEL(57) SCU_KERNEL(58) SCU_KERNEL(59) SCU_KERNEL(60) SCU_KERNEL(61) SCU_KERNEL(62) SCU_KERNEL(63)
+SCU_KERNEL(64) SCU_KERNEL(65) SCU_KERNEL(66) SCU_KERNEL(67) SCU_KERNEL(68) SCU_KERNEL(69) SCU_KERNEL(70) SCU_KERNEL(71)
+SCU_KERNEL(72) SCU_KERNEL(73) SCU_KERNEL(74) SCU_KERNEL(75) SCU_KERNEL(76) SCU_KERNEL(77) SCU_KERNEL(78) SCU_KERNEL(79)
+SCU_KERNEL(80) SCU_KERNEL(81) SCU_KERNEL(82) SCU_KERNEL(83) SCU_KERNEL(84) SCU_KERNEL(85) SCU_KERNEL(86) SCU_KERNEL(87)
+SCU_KERNEL(88) SCU_KERNEL(89) SCU_KERNEL(90) SCU_KERNEL(91) SCU_KERNEL(92) SCU_KERNEL(93) SCU_KERNEL(94) SCU_KERNEL(95)
+SCU_KERNEL(96) SCU_KERNEL(97) SCU_KERNEL(98) SCU_KERNEL(99) SCU_KERNEL(100) SCU_KERNEL(101) SCU_KERNEL(102) SCU_KERNEL(103)
+SCU_KERNEL(104) SCU_KERNEL(105) SCU_KERNEL(106) SCU_KERNEL(107) SCU_KERNEL(108) SCU_KERNEL(109) SCU_KERNEL(110) SCU_KERNEL(111)
+SCU_KERNEL(112) SCU_KERNEL(113) SCU_KERNEL(114) SCU_KERNEL(115) SCU_KERNEL(116) SCU_KERNEL(117) SCU_KERNEL(118) SCU_KERNEL(119)
+SCU_KERNEL(120) SCU_KERNEL(121) SCU_KERNEL(122) SCU_KERNEL(123) SCU_KERNEL(124) SCU_KERNEL(125) SCU_KERNEL(126) SCU_KERNEL(127)
+
+void (*Kernel[SCU_KERNELS])(COMP *, COMP *) = { //Dispatch table, indexed by SCUmask
+	Kernel0, Kernel1, Kernel2, Kernel3, Kernel4, Kernel5, Kernel6, Kernel7,
+	Kernel8, Kernel9, Kernel10, Kernel11, Kernel12, Kernel13, Kernel14, Kernel15,
+	Kernel16, Kernel17, Kernel18, Kernel19, Kernel20, Kernel21, Kernel22, Kernel23,
+	Kernel24, Kernel25, Kernel26, Kernel27, Kernel28, Kernel29, Kernel30, Kernel31,
+	Kernel32, Kernel33, Kernel34, Kernel35, Kernel36, Kernel37, Kernel38, Kernel39,
+	Kernel40, Kernel41, Kernel42, Kernel43, Kernel44, Kernel45, Kernel46, Kernel47,
+	Kernel48, Kernel49, Kernel50, Kernel51, Kernel52, Kernel53, Kernel54, Kernel55,
+	Kernel56, Kernel57, Kernel58, Kernel59, Kernel60, Kernel61, Kernel62, Kernel63,
+	Kernel64, Kernel65, Kernel66, Kernel67, Kernel68, Kernel69, Kernel70, Kernel71,
+	Kernel72, Kernel73, Kernel74, Kernel75, Kernel76, Kernel77, Kernel78, Kernel79,
+	Kernel80, Kernel81, Kernel82, Kernel83, Kernel84, Kernel85, Kernel86, Kernel87,
+	Kernel88, Kernel89, Kernel90, Kernel91, Kernel92, Kernel93, Kernel94, Kernel95,
+	Kernel96, Kernel97, Kernel98, Kernel99, Kernel100, Kernel101, Kernel102, Kernel103,
+	Kernel104, Kernel105, Kernel106, Kernel107, Kernel108, Kernel109, Kernel110, Kernel111,
+	Kernel112, Kernel113, Kernel114, Kernel115, Kernel116, Kernel117, Kernel118, Kernel119,
+	Kernel120, Kernel121, Kernel122, Kernel123, Kernel124, Kernel125, Kernel126, Kernel127
+};
 
 
 int RunSCU(NdbData *Ndb, RECdata *pRD, COMP *pA, COMP *pZ) {
@@ -128,14 +182,26 @@ void Compete(NdbData *Ndb, RECdata *pRD, COMP *pA, COMP *pZ) {
 		}
 	}
 
-	// Modify the Stand-Alone scores by running the SCU agents
- 	if (SCUswitch.SpaceB == 1) SpaceB(pA, pZ);
-	if (SCUswitch.Anomaly == 1) Anomaly(pA, pZ);
-	if (SCUswitch.Rec == 1) Rec(pA, pZ);
-	if (SCUswitch.MinPR == 1) MinPR(pA, pZ);
-	if (SCUswitch.Bound == 1) Bound(pA, pZ);
-	if (SCUswitch.UnCount == 1) UnCount(pA, pZ);
-	if (SCUswitch.MisLead == 1) MisLead(pA, pZ);
+	// Modify the Stand-Alone scores by running the SCU agents that are switched ON
+	Kernel[pRD->SCUmask](pA, pZ);
+}
+
+void SelectSCUkernel(void) {
+	//
+	//	Convert the SCU switches into SCUmask, the index of the Compete() kernel to run.
+	//	Call this whenever SCUswitch changes. A session takes its copy of SCUmask when it's
+	//	opened, see OpenSession().
+	//
+	//----------
+
+	SCUmask = 0;
+	if (SCUswitch.SpaceB == 1) SCUmask = SCUmask | SCU_SPACEB;
+	if (SCUswitch.Anomaly == 1) SCUmask = SCUmask | SCU_ANOMALY;
+	if (SCUswitch.Rec == 1) SCUmask = SCUmask | SCU_REC;
+	if (SCUswitch.MinPR == 1) SCUmask = SCUmask | SCU_MINPR;
+	if (SCUswitch.Bound == 1) SCUmask = SCUmask | SCU_BOUND;
+	if (SCUswitch.UnCount == 1) SCUmask = SCUmask | SCU_UNCOUNT;
+	if (SCUswitch.MisLead == 1) SCUmask = SCUmask | SCU_MISLEAD;
 }
 
 void SpaceB(COMP *pA, COMP *pZ) {
@@ -543,6 +609,115 @@ int SetScore(NdbData *Ndb, RECdata *pRD, COMP *player, int qpos) {
 	return score;
 }
 
+void StandAlone(NdbData *Ndb, RECdata *pRD, COMP *pA, Tdata *pT) {
+	//
+	//	Run a single tournament competitor through the SCU by itself and keep the results
+	//	in its pT[] record: its Stand-Alone Score and the data each of the agents works from.
+	//
+	//	Everything here depends only on the competitor's own Bound Sections. An opponent
+	//	only widens the qpos scanning range, which adds to UnCount - see BoundMatch().
+	//
+	//----------
+
+	int i;
+	int qpos;
+
+	pT->B = (INQUIRY_LENGTH + 1);
+	pT->E = -1;
+	for (i = 0; i < pA->Mcount; i++) {
+		if (pA->m[i].B < pT->B) pT->B = pA->m[i].B;
+		if (pA->m[i].E > pT->E) pT->E = pA->m[i].E;
+	}
+
+	for (qpos = pT->B; qpos <= pT->E; qpos++) pA->Score = SetScore(Ndb, pRD, pA, qpos);
+
+	GetCompetitionData(Ndb, pRD, pA);
+
+	pT->Score = pA->Score;
+	pT->anomaly = pA->anomaly;
+	pT->rec = pA->rec;
+	pT->minpr = pA->minpr;
+	pT->bound = pA->bound;
+	pT->uncount = pA->uncount;
+	pT->mislead = pA->mislead;
+}
+
+int BoundMatch(RECdata *pRD, Tdata *pTa, Tdata *pTz, COMP *pA, COMP *pZ) {
+	//
+	//	Bound the SCU scores of competitor A vs. competitor Z from their Stand-Alone data,
+	//	without running SetScore() again.
+	//
+	//	Every agent except SpaceB() works from data that doesn't depend on the opponent, or,
+	//	in the case of UnCount, only on the opponent's range. SpaceB() needs the SpaceClaim[]
+	//	conflicts, so it's left out for the Upper bounds and charged to both players for the
+	//	Lower bounds. Both spikes are monotonic, so that brackets whatever SpaceB() would do.
+	//
+	//	pA and pZ are just scratch memory - only the agent data is filled in.
+	//
+	//	Returns:	1 if A can't win, 2 if Z can't win, 0 if the match has to be run
+	//
+	//----------
+
+	int i;
+	int low, high;
+	int qpos;
+	int spaces;
+	int upA, upZ, loA, loZ;
+
+	if ((pTa->B > pTz->E) || (pTz->B > pTa->E)) return 0; //Out of range, RunSCU() calls it a tie
+
+	low = pTa->B;
+	if (pTz->B < low) low = pTz->B;
+	high = pTa->E;
+	if (pTz->E > high) high = pTz->E;
+
+	spaces = 0;
+	for (qpos = low; qpos <= high; qpos++) {
+		if (pRD->ISRN[qpos - 1] < 1) return 0; //SetScore() drops the score to 0 here
+		if ((qpos > 1) && (pRD->Space[qpos] > 0)) spaces++;
+	}
+
+	for (i = 0; i < 2; i++) {
+
+		pA->Score = pTa->Score;
+		pA->anomaly = pTa->anomaly;
+		pA->rec = pTa->rec;
+		pA->minpr = pTa->minpr;
+		pA->bound = pTa->bound;
+		pA->uncount = pTa->uncount + (high - low) - (pTa->E - pTa->B); //plus the qpos outside its range
+		pA->mislead = pTa->mislead;
+
+		pZ->Score = pTz->Score;
+		pZ->anomaly = pTz->anomaly;
+		pZ->rec = pTz->rec;
+		pZ->minpr = pTz->minpr;
+		pZ->bound = pTz->bound;
+		pZ->uncount = pTz->uncount + (high - low) - (pTz->E - pTz->B);
+		pZ->mislead = pTz->mislead;
+
+		if ((i == 1) && (spaces > 0) && ((pRD->SCUmask & SCU_SPACEB) != 0)) {
+			//Lower bounds: both players lose the SpaceB() contest
+			pA->Score = InhibitorySpike(InhibitorySpike(InhibitorySpike(pA->Score)));
+			pZ->Score = InhibitorySpike(InhibitorySpike(InhibitorySpike(pZ->Score)));
+		}
+
+		Kernel[pRD->SCUmask & ~SCU_SPACEB](pA, pZ); //Everything but SpaceB()
+
+		if (i == 0) {
+			upA = pA->Score;
+			upZ = pZ->Score;
+		} else {
+			loA = pA->Score;
+			loZ = pZ->Score;
+		}
+	}
+
+	if (upA < loZ) return 1;
+	if (upZ < loA) return 2;
+
+	return 0;
+}
+
 int ExcitatorySpike(int score) {
 	//
 	//	Fast rise from low scores followed by asymptotic approach to 100
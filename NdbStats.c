@@ -0,0 +1,438 @@
+﻿//The Neural Database - Time and counts for the stages of a recognition, and the ONs in them
+//(c) Copyright 2024 Gary J. Lassiter. All Rights Reserved.
+
+#include <ndb.h>
+
+
+//Functions:
+void StageClear(RECdata *);
+void StageBegin(RECdata *, int);
+void StageEnd(RECdata *, int, long long);
+void StageReport(NdbData *, RECdata *, SESSIONdata *, char *);
+void StageTotalsClear(SESSIONdata *);
+void StageTotalsReport(SESSIONdata *, int);
+void ExplainStage(RECdata *, int);
+EXPLAINdata *ExplainON(RECdata *, long);
+void ExplainScan(RECdata *, long, int, double);
+void ExplainMatch(RECdata *, int, int, double);
+void ExplainReport(NdbData *, RECdata *, char *);
+void WriteStages(FILE *, STAGEdata *);
+void WriteText(FILE *, char *);
+
+
+//The names of the stages and of what they count, in STAGE_... order
+char *StageName[STAGE_COUNT] = {"GetBoundSections", "mpCombineBoundSections", "mpRunHitThreshold",
+								"RunAnomalyThreshold", "LoadONs", "RemoveEnvelopments",
+								"RetractAnomalousBoundaries", "RetractWeakBoundaries", "ExpandBoundaries",
+								"RemoveWeakONs", "GetAnomalyCounts", "MakeBranches", "CompeteBranches"};
+char *StageCount[STAGE_COUNT] = {"BLcount", "mpCcount", "Dcount", "Ecount", "Rcount", "Rcount", "Rcount",
+								 "Rcount", "Rcount", "Rcount", "Rcount", "BRHcount", "Matches"};
+
+
+void StageClear(RECdata *pRD) {
+	//
+	//	Start a new recognition. The stages are only timed if someone wants to see them.
+	//
+	//----------
+
+	int s;
+
+	pRD->Timing = 0;
+	if ((pRD->ShowProgress == 1) || (pRD->StageStats > 0)) pRD->Timing = 1;
+	if (pRD->Timing == 0) return;
+
+	for (s = 0; s < STAGE_COUNT; s++) {
+		pRD->Stage[s].Calls = 0;
+		pRD->Stage[s].Count = 0;
+		pRD->Stage[s].Wall = 0.0;
+		pRD->Stage[s].CPU = 0.0;
+	}
+}
+
+void StageBegin(RECdata *pRD, int s) {
+	//
+	//	Stage s is starting
+	//
+	//----------
+
+	if (pRD->Timing == 0) return;
+
+	if (pRD->ShowProgress == 1) printf("\n%s()... ", StageName[s]);
+
+	pRD->Stage[s].Wstart = omp_get_wtime();
+	pRD->Stage[s].Cstart = clock();
+}
+
+void StageEnd(RECdata *pRD, int s, long long count) {
+	//
+	//	Stage s has finished with count records (see STAGE_... in ndb.h)
+	//
+	//	clock() adds up the time of all the threads, so a parallel stage can show
+	//	more processor time than elapsed time.
+	//
+	//----------
+
+	double wall, cpu;
+
+	if (pRD->Timing == 0) return;
+
+	wall = omp_get_wtime() - pRD->Stage[s].Wstart;
+	cpu = ((double)(clock() - pRD->Stage[s].Cstart)) / CLOCKS_PER_SEC;
+
+	pRD->Stage[s].Calls++;
+	pRD->Stage[s].Count = count;
+	pRD->Stage[s].Wall = pRD->Stage[s].Wall + wall;
+	pRD->Stage[s].CPU = pRD->Stage[s].CPU + cpu;
+
+	if (pRD->ShowProgress == 1) printf("%s=%lld  runtime: %fsec  cpu: %fsec", StageCount[s], count, wall, cpu);
+}
+
+void StageReport(NdbData *Ndb, RECdata *pRD, SESSIONdata *pS, char *INPUT) {
+	//
+	//	Add an inquiry's stages to its session's totals, and write them to StageStatsFile
+	//	if every inquiry is wanted (StageStats = 2):
+	//	{"ndb":N,"input":"...","matches":M,"pruned":P,"stages":[{"stage":"GetBoundSections",...},...]}
+	//
+	//	Sessions on other threads can write to the file at the same time, so they take turns.
+	//
+	//----------
+
+	int s;
+	FILE *fh;
+
+	if ((pRD->StageStats == 0) || (pRD->Timing == 0)) return;
+
+	for (s = 0; s < STAGE_COUNT; s++) {
+		pS->StageTotal[s].Calls = pS->StageTotal[s].Calls + pRD->Stage[s].Calls;
+		pS->StageTotal[s].Count = pS->StageTotal[s].Count + pRD->Stage[s].Count;
+		pS->StageTotal[s].Wall = pS->StageTotal[s].Wall + pRD->Stage[s].Wall;
+		pS->StageTotal[s].CPU = pS->StageTotal[s].CPU + pRD->Stage[s].CPU;
+	}
+	pS->StageInquiries++;
+	pS->StageMatches = pS->StageMatches + pRD->Matches;
+	pS->StagePruned = pS->StagePruned + pRD->Pruned;
+
+	if (pRD->StageStats != 2) return;
+
+	#pragma omp critical (StageStatsFile)
+	{
+		fh = fopen(StageStatsFile, "a");
+		if (fh == NULL) {
+			printf("\nERROR: Unable to open %s", StageStatsFile);
+		} else {
+			fprintf(fh, "{\"ndb\":%d,\"input\":", Ndb->ID);
+			WriteText(fh, INPUT);
+			fprintf(fh, ",\"matches\":%d,\"pruned\":%d,\"stages\":", pRD->Matches, pRD->Pruned);
+			WriteStages(fh, pRD->Stage);
+			fprintf(fh, "}\n");
+			fclose(fh);
+		}
+	}
+}
+
+void StageTotalsClear(SESSIONdata *pS) {
+	//
+	//	Start a new set of totals for session pS, e.g. for a run of the Test Library
+	//
+	//----------
+
+	int s;
+
+	for (s = 0; s < STAGE_COUNT; s++) {
+		pS->StageTotal[s].Calls = 0;
+		pS->StageTotal[s].Count = 0;
+		pS->StageTotal[s].Wall = 0.0;
+		pS->StageTotal[s].CPU = 0.0;
+	}
+	pS->StageInquiries = 0;
+	pS->StageMatches = 0;
+	pS->StagePruned = 0;
+}
+
+void StageTotalsReport(SESSIONdata *pS, int N) {
+	//
+	//	Write session pS's totals since StageTotalsClear() for Ndb #N to StageStatsFile:
+	//	{"ndb":N,"inquiries":I,"matches":M,"pruned":P,"stages":[...]}
+	//	Each Count is the total over all the inquiries.
+	//
+	//----------
+
+	FILE *fh;
+
+	if (pS->StageStats == 0) return;
+
+	#pragma omp critical (StageStatsFile)
+	{
+		fh = fopen(StageStatsFile, "a");
+		if (fh == NULL) {
+			printf("\nERROR: Unable to open %s", StageStatsFile);
+		} else {
+			fprintf(fh, "{\"ndb\":%d,\"inquiries\":%ld,\"matches\":%ld,\"pruned\":%ld,\"stages\":", N,
+									pS->StageInquiries, pS->StageMatches, pS->StagePruned);
+			WriteStages(fh, pS->StageTotal);
+			fprintf(fh, "}\n");
+			fclose(fh);
+			printf("  Stage data for %ld inquiries added to %s\n", pS->StageInquiries, StageStatsFile);
+		}
+	}
+}
+
+void ExplainStage(RECdata *pRD, int s) {
+	//
+	//	Explain mode: follow the ONs through the end of stage s. The first stage gets
+	//	memory for the ONs in the linked lists of pBH/pBL, in ONcode order for ExplainON().
+	//
+	//	The mpCombineBoundSections() and mpRunHitThreshold() counts and times are kept
+	//	as the ONs are worked on, along with ReloadR() and RunCompetitions().
+	//
+	//----------
+
+	int i, j, b, r;
+	long I;
+	long ONcode;
+	EXPLAINdata *pX;
+
+	if (s == STAGE_BOUNDSECTIONS) {
+		pRD->pX = NULL;
+		pRD->Xcount = 0;
+		if ((pRD->Explain == 0) || (pRD->BHcount == 0)) return;
+
+		pRD->pX = (EXPLAINdata *)calloc(pRD->BHcount, sizeof(EXPLAINdata));
+		if (pRD->pX == NULL) {
+			printf("\nERROR: No memory for Explain mode");
+			return;
+		}
+		for (i = 1; i <= pRD->BHcount; i++) {
+			//Insert pBH[i] in ONcode order
+			ONcode = pRD->pBH[i].ONcode;
+			j = pRD->Xcount;
+			while ((j > 0) && (pRD->pX[j-1].ONcode > ONcode)) {
+				pRD->pX[j] = pRD->pX[j-1];
+				j--;
+			}
+			pRD->pX[j].ONcode = ONcode;
+			pRD->pX[j].BL = 0;
+			I = pRD->pBH[i].First;
+			while (I > 0) {
+				pRD->pX[j].BL++;
+				I = pRD->pBL[I].Next;
+			}
+			pRD->Xcount++;
+		}
+		return;
+	}
+
+	if (pRD->pX == NULL) return;
+
+	if (s == STAGE_HIT) {
+		for (i = 0; i < pRD->Dcount; i++) {
+			pX = ExplainON(pRD, pRD->pD[i].ONcode);
+			if (pX != NULL) pX->Hit++;
+		}
+	}
+
+	if (s == STAGE_ANOMALY) {
+		for (i = 0; i < pRD->Ecount; i++) {
+			pX = ExplainON(pRD, pRD->pE[i].ONcode);
+			if (pX != NULL) pX->Anomaly++;
+		}
+	}
+
+	if ((s == STAGE_LOADONS) || (s == STAGE_ANOMALYCOUNTS)) {
+		for (r = 1; r <= pRD->Rcount; r++) {
+			pX = ExplainON(pRD, pRD->pR[r].ONcode);
+			if (pX == NULL) continue;
+			if (s == STAGE_LOADONS) pX->Loaded++;
+			if (s == STAGE_ANOMALYCOUNTS) pX->Left++;
+		}
+	}
+
+	if (s == STAGE_BRANCHES) {
+		//Every branch that was made, including the ones deleted along the way
+		for (b = 1; b <= pRD->BRHcount; b++) {
+			j = pRD->pBRH[b].First;
+			while (j > 0) {
+				pX = ExplainON(pRD, pRD->pR[pRD->pBR[j].R].ONcode);
+				if (pX != NULL) pX->Branches++;
+				j = pRD->pBR[j].Next;
+			}
+		}
+	}
+
+	if (s == STAGE_COMPETE) {
+		for (i = 1; i <= pRD->Tcount; i++) {
+			j = pRD->pBRH[pRD->pT[i].BR].First;
+			while (j > 0) {
+				pX = ExplainON(pRD, pRD->pR[pRD->pBR[j].R].ONcode);
+				if (pX != NULL) pX->Competed++;
+				j = pRD->pBR[j].Next;
+			}
+		}
+		for (i = 1; i <= pRD->RESULTcount; i++) {
+			for (j = 1; j <= pRD->pRES[i].NumberOfONs; j++) {
+				pX = ExplainON(pRD, pRD->pRES[i].Result[j].ONcode);
+				if (pX != NULL) pX->Won++;
+			}
+		}
+	}
+}
+
+EXPLAINdata *ExplainON(RECdata *pRD, long ONcode) {
+	//
+	//	Find ONcode in pRD->pX[]
+	//
+	//	Returns:	its record, or NULL if it's not there (e.g. deleted records, ONcode = 0)
+	//
+	//----------
+
+	int low, high, mid;
+
+	low = 0;
+	high = pRD->Xcount - 1;
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if (pRD->pX[mid].ONcode == ONcode) return &pRD->pX[mid];
+		if (pRD->pX[mid].ONcode < ONcode) {
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
+	return NULL;
+}
+
+void ExplainScan(RECdata *pRD, long ONcode, int Rescanned, double t) {
+	//
+	//	ReloadR() scanned a pR[] record of ONcode for t sec. Rescanned = 1 if it was given
+	//	new boundaries, 0 if it was just loaded. A rescan is counted whether the new
+	//	boundaries are kept or later put back. The boundaries of different records can be
+	//	moved at the same time (see RetractAnomalousBoundaries), so the totals are atomic.
+	//
+	//----------
+
+	EXPLAINdata *pX;
+
+	pX = ExplainON(pRD, ONcode);
+	if (pX == NULL) return;
+
+	#pragma omp atomic
+	pX->Rescanned += Rescanned;
+	#pragma omp atomic
+	pX->Scan += t;
+}
+
+void ExplainMatch(RECdata *pRD, int a, int z, double t) {
+	//
+	//	Tournament competitors a and z played an SCU match that took t sec
+	//
+	//----------
+
+	int i, j, c;
+	EXPLAINdata *pX;
+
+	for (i = 0; i < 2; i++) {
+		c = (i == 0) ? a : z;
+		j = pRD->pBRH[pRD->pT[c].BR].First;
+		while (j > 0) {
+			pX = ExplainON(pRD, pRD->pR[pRD->pBR[j].R].ONcode);
+			if (pX != NULL) {
+				pX->Matches++;
+				pX->SCU = pX->SCU + t;
+			}
+			j = pRD->pBR[j].Next;
+		}
+	}
+}
+
+void ExplainReport(NdbData *Ndb, RECdata *pRD, char *INPUT) {
+	//
+	//	Write the path of every ON to ExplainFile, then let go of pRD->pX[]:
+	//	{"ndb":N,"input":"...","results":R,"matches":M,"pruned":P,"ons":[{"on":"...","oncode":C,...},...]}
+	//
+	//	"bytes" is the memory taken by the ON's records in pBL[], mpC[], pD[], pE[], pR[]
+	//	and pBR[]. The times are in seconds. One session at a time writes to the file.
+	//
+	//----------
+
+	int i;
+	long long bytes;
+	FILE *fh;
+	EXPLAINdata *pX;
+
+	if (pRD->pX == NULL) return;
+
+	#pragma omp critical (ExplainFile)
+	{
+		fh = fopen(ExplainFile, "a");
+		if (fh == NULL) {
+			printf("\nERROR: Unable to open %s", ExplainFile);
+		} else {
+			fprintf(fh, "{\"ndb\":%d,\"input\":", Ndb->ID);
+			WriteText(fh, INPUT);
+			fprintf(fh, ",\"results\":%d,\"matches\":%d,\"pruned\":%d,\"ons\":[", pRD->RESULTcount, pRD->Matches, pRD->Pruned);
+			for (i = 0; i < pRD->Xcount; i++) {
+				pX = &pRD->pX[i];
+				bytes = (long long)pX->BL * sizeof(BL) + (long long)pX->Combined * sizeof(BC)
+						+ (long long)pX->Hit * sizeof(D) + (long long)pX->Anomaly * sizeof(E)
+						+ (long long)pX->Loaded * sizeof(Rdata) + (long long)pX->Branches * sizeof(BRdata);
+
+				if (i > 0) fprintf(fh, ",");
+				fprintf(fh, "{\"on\":");
+				WriteText(fh, Ndb->pON[pX->ONcode].ON);
+				fprintf(fh, ",\"oncode\":%ld,\"bl\":%d,\"combined\":%d,\"hit\":%d,\"anomaly\":%d,\"loaded\":%d,\"rescanned\":%d,\"left\":%d",
+						pX->ONcode, pX->BL, pX->Combined, pX->Hit, pX->Anomaly, pX->Loaded, pX->Rescanned, pX->Left);
+				fprintf(fh, ",\"branches\":%d,\"competed\":%d,\"matches\":%d,\"won\":%d,\"bytes\":%lld",
+						pX->Branches, pX->Competed, pX->Matches, pX->Won, bytes);
+				fprintf(fh, ",\"combine\":%.6f,\"threshold\":%.6f,\"scan\":%.6f,\"scu\":%.6f}",
+						pX->Combine, pX->Threshold, pX->Scan, pX->SCU);
+			}
+			fprintf(fh, "]}\n");
+			fclose(fh);
+		}
+	}
+
+	free(pRD->pX);
+	pRD->pX = NULL;
+	pRD->Xcount = 0;
+}
+
+void WriteStages(FILE *fh, STAGEdata *pS) {
+	//
+	//	Write the stages as a JSON array
+	//
+	//----------
+
+	int s;
+
+	fprintf(fh, "[");
+	for (s = 0; s < STAGE_COUNT; s++) {
+		if (s > 0) fprintf(fh, ",");
+		fprintf(fh, "{\"stage\":\"%s\",\"calls\":%ld,\"%s\":%lld,\"wall\":%.6f,\"cpu\":%.6f}",
+				StageName[s], pS[s].Calls, StageCount[s], pS[s].Count, pS[s].Wall, pS[s].CPU);
+	}
+	fprintf(fh, "]");
+}
+
+void WriteText(FILE *fh, char *txt) {
+	//
+	//	Write txt as a JSON string
+	//
+	//----------
+
+	int i;
+	unsigned char ch;
+
+	fprintf(fh, "\"");
+	for (i = 0; txt[i] != 0; i++) {
+		ch = (unsigned char)txt[i];
+		if (ch == '\n') continue; //fgets() leaves the linefeed
+		if ((ch == '"') || (ch == '\\')) {
+			fprintf(fh, "\\%c", ch);
+		} else if (ch < 32) {
+			fprintf(fh, "\\u%04x", ch);
+		} else {
+			fprintf(fh, "%c", ch);
+		}
+	}
+	fprintf(fh, "\"");
+}
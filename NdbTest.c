@@ -15,8 +15,20 @@ char SubDirectoryNdbs[] = "ndbdatabases/"; //Name of subdirectory to store neura
 char MNISTerrors[] = "mnist_errors.txt"; //Name of file listing the MNIST Test records that failed recognition
 int ShowProgress; //Used to display processing events
 SCUswitches SCUswitch; //Used to turn SCU agents On/Off
-OUTPUT pOUT[TOTAL_ALLOWED_RESULTS + 1]; //Results of an inquiry
-int OUTcount; //Number of results in pOUT
+int SCUmask; //SCUswitch as bits, selects the Compete() kernel
+int BeamWidth; //Branches kept by each round of BuildBranches(), 0: all of them
+int StageStats; //Stage data to StageStatsFile: 0 none, 1 totals per Ndb, 2 every inquiry too
+char StageStatsFile[] = "ndb_stats.json"; //Name of the file the stage data is added to
+int ExplainMode; //1: the path of every ON in each RecognizeTEXT() goes to ExplainFile
+char ExplainFile[] = "ndb_explain.json"; //Name of the file the ON paths are added to
+int FullVote; //1: every image Ndb votes on every image, even after the winner is decided (audit)
+int TierMargin; //Cascade: 0 OFF, or the lead in first tier votes that decides an image
+int Tier1Count; //Image Ndbs in ImageTier1[], 0: the first tier is the full 28x28 views
+int ImageTier1[IMAGE_VIEWS]; //N of each image Ndb in the first tier, from ImageTiersFile
+char ImageTiersFile[] = "ndb_tiers.txt"; //Name of the file listing the image Ndbs by tier
+int ImageLookup; //Image Ndbs: 0 RecognizeINPUT() only, 1 LookupImage() first, 2 both, to compare them
+ImageStore ViewStore; //The resident multi-view image store, Views = 0: none
+char ImageStoreFile[] = "images.nds"; //Name of the multi-view image store, in SubDirectoryNdbs
 
 
 // Functions:
@@ -27,6 +39,9 @@ int TestNdb1to12(void);
 int TestLinkedNdbs(void);
 int TestMNIST(void);
 int TestAllMNIST(void);
+int LearnImageTiers(void);
+int LoadImageTiers(void);
+int RefreshImageStore(int);
 void DisplayImage(MNISTimage *, long);
 void FreeMem(NdbData *);
 
@@ -63,6 +78,15 @@ int main(void) {
 	SCUswitch.Bound = 1;
 	SCUswitch.UnCount = 1;
 	SCUswitch.MisLead = 1;
+	SelectSCUkernel();
+
+	BeamWidth = 0; //Build every branch
+	StageStats = 0; //Don't time the stages
+	ExplainMode = 0; //Don't follow the ONs
+	FullVote = 0; //Stop each image's vote once the winner is decided
+	TierMargin = 0; //Every image Ndb is in one tier
+	Tier1Count = 0;
+	ImageLookup = 0; //Image Ndbs always run RecognizeINPUT()
 
 	quit = 0;
 	while (quit == 0) {
@@ -132,8 +156,56 @@ int main(void) {
 		} else {
 			printf("(OFF)");
 		}
+		printf("\n");
+		printf("\nBranches:");
+		printf("\n    22) Beam width for building branches ");
+		if (BeamWidth > 0) {
+			printf("(%d)", BeamWidth);
+		} else {
+			printf("(OFF)");
+		}
+		printf("\n    23) Stage times and counts to %s ", StageStatsFile);
+		if (StageStats == 0) printf("(OFF)");
+		if (StageStats == 1) printf("(totals for Options 7 & 8)");
+		if (StageStats == 2) printf("(totals and every inquiry)");
+		printf("\n    24) Explain every inquiry: the path of each ON to %s ", ExplainFile);
+		if (ExplainMode == 1) {
+			printf("(ON) ");
+		} else {
+			printf("(OFF)");
+		}
+		printf("\n");
+		printf("\nImages:");
+		printf("\n    25) Every image Ndb votes on every image (audit) ");
+		if (FullVote == 1) {
+			printf("(ON) ");
+		} else {
+			printf("(OFF)");
+		}
+		printf("\n    26) Learn the first tier of image Ndb's from the MNIST Training Set to %s", ImageTiersFile);
+		printf("\n    27) Cascade: the rest of the image Ndb's vote only if the first tier is close ");
+		if (TierMargin > 0) {
+			printf("(margin %d, ", TierMargin);
+			if (Tier1Count > 0) {
+				printf("%d Ndb's from %s)", Tier1Count, ImageTiersFile);
+			} else {
+				printf("the full images)");
+			}
+		} else {
+			printf("(OFF)");
+		}
+		printf("\n    28) Image Ndb's look up the nearest ONs directly ");
+		if (ImageLookup == 0) printf("(OFF)");
+		if (ImageLookup == 1) printf("(ON) ");
+		if (ImageLookup == 2) printf("(COMPARE with the full recognition)");
+		printf("\n    29) Keep all the image Ndb's in memory, in the multi-view image store %s ", ImageStoreFile);
+		if (ViewStore.Views > 0) {
+			printf("(ON) ");
+		} else {
+			printf("(OFF)");
+		}
 
-		printf("\n\nEnter 1, 2, ... 21, or Enter/Return to Exit: ");
+		printf("\n\nEnter 1, 2, ... 29, or Enter/Return to Exit: ");
 		fgets(Read_Char, 10, stdin);
 		menu = atoi(Read_Char); // convert %s to %d
 
@@ -196,7 +268,10 @@ int main(void) {
 			if (res == 1) printf("\nFAILED to create Neural Database 50.ndb\n\n");
 		}
 		if (menu == 4) {
+			N = ViewStore.Views;
+			FreeImageStore(&ViewStore); //LoadNdb() mustn't find the old image Ndbs there
 			res = mpCreateImageNdbs();
+			res = RefreshImageStore(N);
 		}
 		if (menu == 5) {
 			res = InquireNdbN();
@@ -221,6 +296,7 @@ int main(void) {
 		}
 		if (menu == 12) {
 			res = AddImages(); //Add mnist_er.txt to Ndb #2000+
+			res = RefreshImageStore(ViewStore.Views);
 		}
 		if (menu == 13) {
 			if (SCUswitch.SpaceB == 0) {
@@ -291,6 +367,48 @@ int main(void) {
 			SCUswitch.UnCount = 0;
 			SCUswitch.MisLead = 0;
 		}
+		if (menu == 22) {
+			printf("\nKeep how many branches each time they grow (0 = all of them): ");
+			fgets(Read_Char, 10, stdin);
+			BeamWidth = atoi(Read_Char);
+			if (BeamWidth < 0) BeamWidth = 0;
+		}
+		if (menu == 23) {
+			StageStats++; //OFF -> totals -> every inquiry -> OFF
+			if (StageStats > 2) StageStats = 0;
+		}
+		if (menu == 24) {
+			ExplainMode = 1 - ExplainMode;
+		}
+		if (menu == 25) {
+			FullVote = 1 - FullVote;
+		}
+		if (menu == 26) {
+			res = LearnImageTiers();
+		}
+		if (menu == 27) {
+			printf("\nThe first tier's winner needs to lead by how many votes (0 = OFF): ");
+			fgets(Read_Char, 10, stdin);
+			TierMargin = atoi(Read_Char);
+			if (TierMargin < 0) TierMargin = 0;
+			if (TierMargin > 0) Tier1Count = LoadImageTiers();
+		}
+		if (menu == 28) {
+			ImageLookup++; //OFF -> ON -> COMPARE -> OFF
+			if (ImageLookup > 2) ImageLookup = 0;
+		}
+		if (menu == 29) {
+			if (ViewStore.Views > 0) {
+				FreeImageStore(&ViewStore);
+			} else {
+				//Use the store if there is one, otherwise make it from the .ndb files
+				res = LoadImageStore();
+				if (res != 0) res = BuildImageStore();
+			}
+		}
+
+		//The switches only change between runs, so this is the one place to pick the SCU kernel
+		SelectSCUkernel();
 	}
 	return 0;
 }
@@ -306,6 +424,7 @@ int InquireNdbN(void) {  // Query Ndb #N
 	int REScount;
 	char result[INQUIRY_LENGTH];
 	NdbData Ndb;
+	SESSIONdata S;
 	int N;
 
 	clock_t T;
@@ -331,6 +450,11 @@ int InquireNdbN(void) {  // Query Ndb #N
 	fgets(txt, 10, stdin);
 	if ((txt[0] == 'y') || (txt[0] == 'Y')) ShowProgress = 1;
 
+	if (OpenSession(&S) != 0) {
+		FreeMem(&Ndb);
+		return 1;
+	}
+
 	// Inquiries into Ndb #N...
 	while (1) {
 		printf("\nEnter any text, or Enter/Return to go back to the Menu\n");
@@ -350,25 +474,25 @@ int InquireNdbN(void) {  // Query Ndb #N
 
 		T = clock();
 
-		res = RecognizeTEXT(&Ndb, txt); //Call the Ndb, Results in pOUT[]
+		res = RecognizeTEXT(&Ndb, &S, txt); //Call the Ndb, Results in S.pOUT[]
 
 		T = clock() - T;
 		runtime = ((double)T) / CLOCKS_PER_SEC;
 
-		if (OUTcount == 0) {
+		if (S.OUTcount == 0) {
 			printf("\nResult: ERROR - NO RESULT!");
  			printf("\n");
 		} else {
-			if (OUTcount > 1) { //There are multiple results
+			if (S.OUTcount > 1) { //There are multiple results
 				printf("\nMultiple results:  (%fsec)", runtime);
-				for (i = 1; i <= OUTcount; i++) {
-					REScount = pOUT[i].REScount;
+				for (i = 1; i <= S.OUTcount; i++) {
+					REScount = S.pOUT[i].REScount;
 					for (k = 0; k < INQUIRY_LENGTH; k++) result[k] = 0; //clear the buffer
 					for (j = 1; j <= REScount; j++) {
 						if (j == 1) {
-							strcpy(result, pOUT[i].Result[j].ON);
+							strcpy(result, S.pOUT[i].Result[j].ON);
 						} else {
-							sprintf(result, "%s %s", result, pOUT[i].Result[j].ON);
+							sprintf(result, "%s %s", result, S.pOUT[i].Result[j].ON);
 						}
 					}
 					printf("\n  Result %d: %s", i, result);
@@ -377,10 +501,10 @@ int InquireNdbN(void) {  // Query Ndb #N
 			} else {
 				//There is only one result
 				i = 1;
-				REScount = pOUT[i].REScount;
+				REScount = S.pOUT[i].REScount;
 				printf("\nResult:");
 				for (j = 1; j <= REScount; j++) {
-					printf(" %s", pOUT[i].Result[j].ON);
+					printf(" %s", S.pOUT[i].Result[j].ON);
 				}
 				printf(" (%fsec)", runtime);
  				printf("\n");
@@ -389,6 +513,7 @@ int InquireNdbN(void) {  // Query Ndb #N
  		printf("\n");
 	}
 
+	CloseSession(&S);
 	FreeMem(&Ndb);
 	return 0;
 }
@@ -404,6 +529,7 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 	int REScount;
 	char result[INQUIRY_LENGTH];
 	NdbData Ndb;
+	SESSIONdata S;
 	int N;
 
 	ShowProgress = 0; //Set to 1 to show the time spent in each function
@@ -428,6 +554,8 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 		}
 	}
 
+	if (OpenSession(&S) != 0) return 1;
+
 	printf("\nIdentifying: %s...", txt);
 	for (N = 1; N <= 12; N++) {
 
@@ -436,6 +564,7 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 		if (res != 0) {
 			sprintf(txt, "%s%d.ndb", SubDirectoryNdbs, Ndb.ID);
 			printf("\n\nERROR: Failed to load Ndb #%d from the database sub-directory: %s", N, txt);
+			CloseSession(&S);
 			return 1;
 		} else {
 
@@ -443,26 +572,26 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 
 			T = clock();
 
-			res = RecognizeTEXT(&Ndb, txt); //Call the Ndb, Results in pOUT[]
+			res = RecognizeTEXT(&Ndb, &S, txt); //Call the Ndb, Results in S.pOUT[]
 
 			FreeMem(&Ndb);
 			T = clock() - T;
 			runtime = ((double)T) / CLOCKS_PER_SEC;
 		
-			if (OUTcount == 0) {
+			if (S.OUTcount == 0) {
 				printf("\nResult: ERROR - NO RESULT!");
  				printf("\n");
 			} else {
-				if (OUTcount > 1) { //There are multiple results
+				if (S.OUTcount > 1) { //There are multiple results
 					printf("\nMultiple results:  (%fsec)", runtime);
-					for (i = 1; i <= OUTcount; i++) {
-						REScount = pOUT[i].REScount;
+					for (i = 1; i <= S.OUTcount; i++) {
+						REScount = S.pOUT[i].REScount;
 						for (k = 0; k < INQUIRY_LENGTH; k++) result[k] = 0; //clear the buffer
 						for (j = 1; j <= REScount; j++) {
 							if (j == 1) {
-								strcpy(result, pOUT[i].Result[j].ON);
+								strcpy(result, S.pOUT[i].Result[j].ON);
 							} else {
-								sprintf(result, "%s %s", result, pOUT[i].Result[j].ON);
+								sprintf(result, "%s %s", result, S.pOUT[i].Result[j].ON);
 							}
 						}
 						printf("\n  Result %d: %s", i, result);
@@ -471,10 +600,10 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 				} else {
 					//There is only one result
 					i = 1;
-					REScount = pOUT[i].REScount;
+					REScount = S.pOUT[i].REScount;
 					printf("\nResult:");
 					for (j = 1; j <= REScount; j++) {
-						printf(" %s", pOUT[i].Result[j].ON);
+						printf(" %s", S.pOUT[i].Result[j].ON);
 					}
 					printf(" (%fsec)", runtime);
  					printf("\n");
@@ -484,6 +613,7 @@ int InquireNdb1to12(void) { //Run the same query on Ndb's #1 through #12
 	}
 	printf("\n");
 
+	CloseSession(&S);
 	return 0;
 }
 
@@ -502,6 +632,7 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 	int fnd;
 	int display;
 	NdbData Ndb;
+	SESSIONdata S;
 	int N;
 	char TestNumber[4]; //1 to 999
 
@@ -546,9 +677,15 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 		return 0;
 	}
 
+	if (OpenSession(&S) != 0) {
+		FreeMem(&Ndb);
+		return 1;
+	}
+
 	fh_read = fopen(testfile, "r");
 	if (fh_read == NULL) {
 		printf("ERROR: Failed to OPEN file %s for reading.\n", testfile);
+		CloseSession(&S);
 		FreeMem(&Ndb);
 		return 1;
 	} else {
@@ -571,6 +708,7 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 		OK = 0;
 		notOK = 0;
 		Multiples = 0;
+		StageTotalsClear(&S);
 
 		while (fgets(line, FILE_LINE_LENGTH, fh_read) != NULL) {
 
@@ -604,9 +742,9 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 
 			if (display == 1) printf("\nTest #%s: %s", TestNumber, txt);
 
-			res = RecognizeTEXT(&Ndb, txt); ///Call the Ndb, Results in pOUT[]
+			res = RecognizeTEXT(&Ndb, &S, txt); ///Call the Ndb, Results in S.pOUT[]
 
-			if (OUTcount == 0) {
+			if (S.OUTcount == 0) {
 				notOK++;
 				if (display == 1) {
 					printf("\n+++NO RESULT!\n");
@@ -624,14 +762,14 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 						if (line[p] == 0) break;
 						answer[p-2] = line[p];
 					}
-					for (i = 1; i <= OUTcount; i++) {
-						REScount = pOUT[i].REScount;
+					for (i = 1; i <= S.OUTcount; i++) {
+						REScount = S.pOUT[i].REScount;
 						for (k = 0; k < INQUIRY_LENGTH; k++) result[k] = 0; //clear the buffer
 						for (j = 1; j <= REScount; j++) {
 							if (j == 1) {
-								strcpy(result, pOUT[i].Result[j].ON);
+								strcpy(result, S.pOUT[i].Result[j].ON);
 							} else {
-								sprintf(result, "%s %s", result, pOUT[i].Result[j].ON);
+								sprintf(result, "%s %s", result, S.pOUT[i].Result[j].ON);
 							}
 						}
 						if (strcmp(result, answer) == 0) {
@@ -677,7 +815,11 @@ int TestNdbN(void) {  // Run the Test Library (TestLib.txt) on Ndb #N
 	if (Multiples > 0) printf("of which %d had multiple answers. ", Multiples);
 	if (notOK > 0) printf("Correct=%d  ", OK);
 	printf("Finished Ndb #%d: %s  (%fsec)\n", N, timenow, runtime);
+	printf("  SCU matches played=%ld  decided by score bounds=%ld\n", S.Matches, S.Pruned);
+	if (S.Beam > 0) printf("  Beam=%d: branches dropped=%ld  that could have competed=%ld\n", S.Beam, S.BeamPruned, S.BeamLost);
+	StageTotalsReport(&S, N);
 
+	CloseSession(&S);
 	return 0;
 }
 
@@ -696,6 +838,7 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 	int fnd;
 	int display;
 	NdbData Ndb;
+	SESSIONdata S;
 	int N;
 	char TestNumber[4]; //1 to 999
 
@@ -719,9 +862,12 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 	display = atoi(txt); // convert %s to %d
 	if ((display != 1)&&(display != 2)&&(display != 3)) return 0;
 
+	if (OpenSession(&S) != 0) return 1;
+
 	fh_read = fopen(testfile, "r");
 	if (fh_read == NULL) {
 		printf("ERROR: Failed to OPEN file %s for reading.\n", testfile);
+		CloseSession(&S);
 		return 1;
 	}
 
@@ -755,6 +901,11 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 		OK = 0;
 		notOK = 0;
 		Multiples = 0;
+		S.Matches = 0;
+		S.Pruned = 0;
+		S.BeamPruned = 0;
+		S.BeamLost = 0;
+		StageTotalsClear(&S);
 
 		T = clock();
 
@@ -793,9 +944,9 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 
 			if (display == 1) printf("\nTest #%s: %s", TestNumber, txt);
 
-			res = RecognizeTEXT(&Ndb, txt); //Call the Ndb, Results in pOUT[]
+			res = RecognizeTEXT(&Ndb, &S, txt); //Call the Ndb, Results in S.pOUT[]
 
-			if (OUTcount == 0) {
+			if (S.OUTcount == 0) {
 				notOK++;
 				if (display == 1) {
 					printf("\n+++NO RESULT!\n");
@@ -813,14 +964,14 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 						if (line[p] == 0) break;
 						answer[p-2] = line[p];
 					}
-					for (i = 1; i <= OUTcount; i++) {
-						REScount = pOUT[i].REScount;
+					for (i = 1; i <= S.OUTcount; i++) {
+						REScount = S.pOUT[i].REScount;
 						for (k = 0; k < INQUIRY_LENGTH; k++) result[k] = 0; //clear the buffer
 						for (j = 1; j <= REScount; j++) {
 							if (j == 1) {
-								strcpy(result, pOUT[i].Result[j].ON);
+								strcpy(result, S.pOUT[i].Result[j].ON);
 							} else {
-								sprintf(result, "%s %s", result, pOUT[i].Result[j].ON);
+								sprintf(result, "%s %s", result, S.pOUT[i].Result[j].ON);
 							}
 						}
 						if (strcmp(result, answer) == 0) {
@@ -865,8 +1016,12 @@ int TestNdb1to12(void) {  // Run the Test Library on Ndb's #1, #2, ... #12
 		if (Multiples > 0) printf("of which %d had multiple answers. ", Multiples);
 		if (notOK > 0) printf("Correct=%d  ", OK);
 		printf("Finished Ndb #%d: %s  (%fsec)\n", N, timenow, runtime);
+		printf("  SCU matches played=%ld  decided by score bounds=%ld\n", S.Matches, S.Pruned);
+		if (S.Beam > 0) printf("  Beam=%d: branches dropped=%ld  that could have competed=%ld\n", S.Beam, S.BeamPruned, S.BeamLost);
+		StageTotalsReport(&S, N);
 	}
 	fclose(fh_read);
+	CloseSession(&S);
 
 	return 0;
 }
@@ -890,6 +1045,7 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 	int i, j, k, c, fnd;
 	int REScount;
 	NdbData Ndb;
+	SESSIONdata S;
 	int N;
 	char ndbfile[INQUIRY_LENGTH];
 
@@ -908,6 +1064,11 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 		return 1;
 	}
 
+	if (OpenSession(&S) != 0) {
+		FreeMem(&Ndb);
+		return 1;
+	}
+
 	// Begin with an inquiry into Ndb #1...
 	while (1) {
 		printf("\nEnter any text...\n");
@@ -926,28 +1087,28 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 		}
 
 		T = clock();
-		res = RecognizeTEXT(&Ndb, txt); //Call the Ndb, Results in pOUT[]
+		res = RecognizeTEXT(&Ndb, &S, txt); //Call the Ndb, Results in S.pOUT[]
 
 		printf("\n%d.ndb Result:", N);
 		
-		if (OUTcount == 0) {
+		if (S.OUTcount == 0) {
 			printf(" ERROR - NO RESULT!");
 		} else {
 			for (i = 0; i < INQUIRY_LENGTH; i++) txt[i] = 0; //clear the buffer
-			for (i = 1; i <= OUTcount; i++) {
-				REScount = pOUT[i].REScount;
+			for (i = 1; i <= S.OUTcount; i++) {
+				REScount = S.pOUT[i].REScount;
 				for (j = 1; j <= REScount; j++) {
 					//The recognized ON's output may have come from a Surrogate containing a space
 					//Strip it of any possible spaces...
 					for (k = 0; k < INQUIRY_LENGTH; k++) x[k] = 0;
 					c = 0;
 					for (k = 0; k < INQUIRY_LENGTH; k++) {
-						ch = pOUT[i].Result[j].ON[k];
+						ch = S.pOUT[i].Result[j].ON[k];
 						if (ch == ' ') continue;
 						x[c] = ch;
 						c++;
 					}
-					printf(" %s", pOUT[i].Result[j].ON);
+					printf(" %s", S.pOUT[i].Result[j].ON);
 					if (j == 1) {
 						sprintf(txt, "%s", x);
 					} else {
@@ -969,17 +1130,18 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 			if (res != 0) {
 				sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, Ndb.ID);
 				printf("\nERROR: Failed to load Ndb #%d from the database sub-directory: %s", N, ndbfile);
+				CloseSession(&S);
 				return 1;
 			}
 
-			ShowProgress = 0;
-			//ShowProgress = 1;
+			S.ShowProgress = 0;
+			//S.ShowProgress = 1;
 
-			res = RecognizeTEXT(&Ndb, txt); //Call the Ndb, Results in pOUT[]
+			res = RecognizeTEXT(&Ndb, &S, txt); //Call the Ndb, Results in S.pOUT[]
 
 			printf("\n%d.ndb Result:", N);
 		
-			if (OUTcount == 0) {
+			if (S.OUTcount == 0) {
 				printf(" ERROR - NO RESULT!");
 			} else {
 				//Clear the list of Actions...
@@ -991,15 +1153,15 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 						pACT[i].ON[j] = 0;
 					}
 				}
-				for (i = 1; i <= OUTcount; i++) {
-					REScount = pOUT[i].REScount;
+				for (i = 1; i <= S.OUTcount; i++) {
+					REScount = S.pOUT[i].REScount;
 					for (j = 1; j <= REScount; j++) {
 
 						//Check for any Actions to execute...
-						if (pOUT[i].Result[j].ACT[0] != 0) { //accumulate the Actions from this result
+						if (S.pOUT[i].Result[j].ACT[0] != 0) { //accumulate the Actions from this result
 							fnd = 0;
 							for (k = 0; k < ACTcnt; k++) {
-								if (strcmp(pOUT[i].Result[j].ACT, pACT[k].action) == 0) {
+								if (strcmp(S.pOUT[i].Result[j].ACT, pACT[k].action) == 0) {
 									pACT[k].cnt++;
 									fnd = 1;
 									break;
@@ -1007,8 +1169,8 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 							}
 							if (fnd == 0) {
 								pACT[ACTcnt].cnt = 1;
-								strcpy(pACT[ACTcnt].action, pOUT[i].Result[j].ACT);
-								strcpy(pACT[ACTcnt].ON, pOUT[i].Result[j].ON);
+								strcpy(pACT[ACTcnt].action, S.pOUT[i].Result[j].ACT);
+								strcpy(pACT[ACTcnt].ON, S.pOUT[i].Result[j].ON);
 								ACTcnt++;
 							}
 						}
@@ -1027,7 +1189,7 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 						res = ExecuteActions(pACT[j].action);
 					} else {
 						//Otherwise just list the results
-						for (j = 1; j <= REScount; j++) printf(" %s", pOUT[i].Result[j].ON);
+						for (j = 1; j <= REScount; j++) printf(" %s", S.pOUT[i].Result[j].ON);
 					}
 
 					//**********
@@ -1044,6 +1206,7 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
 			if (res != 0) {
 				sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, Ndb.ID);
 				printf("\nERROR: Failed to re-load Ndb #%d from the database sub-directory: %s !!", N, ndbfile);
+				CloseSession(&S);
 				return 1;
 			}
 		}
@@ -1053,6 +1216,7 @@ int TestLinkedNdbs(void) { // Test 'linked' Ndb's: Ndb #1 --> Ndb #50 --> execut
  		printf("\n");
 	}
 
+	CloseSession(&S);
 	FreeMem(&Ndb);
 	return 0;
 }
@@ -1061,14 +1225,13 @@ int TestMNIST(void) {  // Run a MNIST Test Image on Ndb's #2000+
 
 	char num[20];
 	long RecNum;
-	FILE *fh_read;
-	char line[IMAGE_LENGTH];
 	int res;
 	int i, j;
 	int REScount;
 
-	MNISTimage *pIMG;	//MNIST images are loaded from the file into this memory
-	int IMGcount;
+	MNISTimage *pIMG;	//MNIST images are loaded from the image store into this memory
+	long IMGcount;
+	SESSIONdata S;
 
 	char ndbfile[INQUIRY_LENGTH];
 
@@ -1076,48 +1239,19 @@ int TestMNIST(void) {  // Run a MNIST Test Image on Ndb's #2000+
 	double runtime;
 
 	long NumberOfImages = 10000;
-	char DataFile[20] = "mnist_test.txt";
+	char ImageSet[10] = "test"; //the MNIST Test Set
 
 	ShowProgress = 0;
 
-	printf("\nLoading images from %s...", DataFile);
-	fh_read = fopen(DataFile, "r");
-	if (fh_read == NULL) {
-		printf("ERROR: Failed to OPEN file %s for reading.\n", DataFile);
-		return 1;
-	}
-
-	pIMG = (MNISTimage *)malloc((NumberOfImages+50) * IMAGE_LENGTH);
-	IMGcount = 1; //=RecNum: 1, 2, ...
-	while (fgets(line, IMAGE_LENGTH, fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < (IMAGE_LENGTH-1); i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-
-			//In order to reduce the size of these MNIST image files, all pixels of
-			//value 0 have been removed except for any 0 at the end of a line.
-			//This code puts the 0's back in...
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= NumberOfImages) continue;
-		break;
-	}
-	fclose(fh_read);
+	pIMG = LoadMNIST(ImageSet, NumberOfImages, &IMGcount);
+	if (pIMG == NULL) return 1;
+	NumberOfImages = IMGcount;
+	printf("\n");
 
-	if (IMGcount == 0) {
-		printf("\nERROR: Failed to find any images in %s", DataFile);
-		printf("\nThe line format should be 'digit,pixel,pixel,...'\n");
+	if (OpenSession(&S) != 0) {
 		free(pIMG);
 		return 1;
 	}
-	printf("\n");
 
 
 	//Specify MNIST Test image(s)...
@@ -1132,16 +1266,7 @@ int TestMNIST(void) {  // Run a MNIST Test Image on Ndb's #2000+
 
 		DisplayImage(pIMG, RecNum);
 
-		i = 2; //start reading the image string from here
-		j = 0;
-		while (pIMG[RecNum].image[i] != 0) {
-			line[j] = pIMG[RecNum].image[i];
-			i++;
-			j++;
-		}
-		line[j] = 0;
-
-		res = mpRecognizeIMAGE(RecNum, line); //Call the Image Ndbs, Results in pOUT[]
+		res = mpRecognizeIMAGE(&S, RecNum, pIMG[RecNum].pixel); //Call the Image Ndbs, Results in S.pOUT[]
 
 		if (res > 1999) {
 			sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, res);
@@ -1154,21 +1279,22 @@ int TestMNIST(void) {  // Run a MNIST Test Image on Ndb's #2000+
 
 		printf("\nResult: ");
 		
-		if (OUTcount == 0) {
+		if (S.OUTcount == 0) {
 			printf(" ERROR - NO RESULT!");
 		} else {
-			for (i = 1; i <= OUTcount; i++) {
-				REScount = pOUT[i].REScount;
+			for (i = 1; i <= S.OUTcount; i++) {
+				REScount = S.pOUT[i].REScount;
 				for (j = 1; j <= REScount; j++) {
-					printf(" %s", pOUT[i].Result[j].ON);
+					printf(" %s", S.pOUT[i].Result[j].ON);
 				}
 				break; //If there are multiple results, ignore all but the 1st one
 			} 
 		}
-		printf(" (%fsec)", runtime);
+		printf(" (%fsec, %ld of %d Ndb's voted)", runtime, S.ImageViewsRun, IMAGE_VIEWS);
  		printf("\n");
 	}
 
+	CloseSession(&S);
 	free(pIMG);
 	return 0;
 }
@@ -1176,15 +1302,19 @@ int TestMNIST(void) {  // Run a MNIST Test Image on Ndb's #2000+
 int TestAllMNIST(void) {  // Run the full MNIST Image Test Set of 10,000 images on Ndb's #2000+
 
 	long RecNum;
-	FILE *fh_read;
+	long Batch;		//The first image of this batch...
+	long Count;		//...and the number of images in it
+	char *pResult;	//The digit recognized for each image of the batch, or 0 for No Result
+	char digit;
 	FILE *fh_write;
-	char line[IMAGE_LENGTH];
 	int res;
-	int i, j;
+	int j;
 	int errors;
+	double ViewsRun;	//Image Ndbs run, all images
 
-	MNISTimage *pIMG;	//MNIST images are loaded from the file into this memory
-	int IMGcount;
+	MNISTimage *pIMG;	//MNIST images are loaded from the image store into this memory
+	long IMGcount;
+	SESSIONdata S;
 
 	char ndbfile[INQUIRY_LENGTH];
 
@@ -1193,47 +1323,13 @@ int TestAllMNIST(void) {  // Run the full MNIST Image Test Set of 10,000 images
 	double runtime;
 
 	long NumberOfImages = 10000;
-	char DataFile[20] = "mnist_test.txt";
+	char ImageSet[10] = "test"; //the MNIST Test Set
 
 	ShowProgress = 0;
 
-	printf("\nLoading %d images from %s...", NumberOfImages, DataFile);
-	fh_read = fopen(DataFile, "r");
-	if (fh_read == NULL) {
-		printf("ERROR: Failed to OPEN file %s for reading.\n", DataFile);
-		return 1;
-	}
-
-	pIMG = (MNISTimage *)malloc((NumberOfImages+50) * IMAGE_LENGTH);
-	IMGcount = 1; //=RecNum: 1, 2, ...
-	while (fgets(line, IMAGE_LENGTH, fh_read) != NULL) {
-		j = 0;
-		for (i = 0; i < (IMAGE_LENGTH-1); i++) {
-			if (line[i] == 10) break; //linefeed
-			pIMG[IMGcount].image[j] = line[i];
-			j++;
-
-			//In order to reduce the size of these MNIST image files, all pixels of
-			//value 0 have been removed except for any 0 at the end of a line.
-			//This code puts the 0's back in...
-			if ((line[i] == ',') && (line[i+1] == ',')) {
-				pIMG[IMGcount].image[j] = '0';
-				j++;
-			}
-		}
-		pIMG[IMGcount].image[j] = 0;
-		IMGcount++;
-		if (IMGcount <= NumberOfImages) continue;
-		break;
-	}
-	fclose(fh_read);
-
-	if (IMGcount == 0) {
-		printf("\nERROR: Failed to find any images in %s", DataFile);
-		printf("\nThe line format should be 'digit,pixel,pixel,...'\n");
-		free(pIMG);
-		return 1;
-	}
+	pIMG = LoadMNIST(ImageSet, NumberOfImages, &IMGcount);
+	if (pIMG == NULL) return 1;
+	NumberOfImages = IMGcount;
 	printf("\n");
 
 	//Open an empty file to store a list of image Record Numbers that failed to be correctly recognized...
@@ -1246,97 +1342,300 @@ int TestAllMNIST(void) {  // Run the full MNIST Image Test Set of 10,000 images
 	fprintf(fh_write, ";Neural Database data - Record Numbers of MNIST Test images that failed\n");
 	fflush(fh_write);
 
+	pResult = (char *)malloc(IMAGE_BATCH * sizeof(char));
+	if (pResult == NULL) {
+		printf("ERROR: not enough memory for the recognition results\n");
+		fclose(fh_write);
+		free(pIMG);
+		return 1;
+	}
+
+	if (OpenSession(&S) != 0) {
+		fclose(fh_write);
+		free(pResult);
+		free(pIMG);
+		return 1;
+	}
+
 	TotalT = clock();
 	errors = 0;
+	ViewsRun = 0;
 
-	//Run through all the images...
-	for (RecNum = 1; RecNum <= NumberOfImages; RecNum++) {
+	//Run through all the images, a batch at a time. Every image of a batch is run on the
+	//image Ndbs together, then the results are reported in Record Number order.
+	for (Batch = 1; Batch <= NumberOfImages; Batch += Count) {
+		Count = NumberOfImages - Batch + 1;
+		if (Count > IMAGE_BATCH) Count = IMAGE_BATCH;
 
-		i = 2; //start reading the image-string from here
-		j = 0;
-		while (pIMG[RecNum].image[i] != 0) {
-			line[j] = pIMG[RecNum].image[i];
-			i++;
-			j++;
-		}
-		line[j] = 0;
-
-		printf("\nRecord %d, image of %c: ", RecNum, pIMG[RecNum].image[0]);
 		T = clock();
-		res = mpRecognizeIMAGE(RecNum, line); //Call the Image Ndbs, Results in pOUT[]
+		res = mpRecognizeIMAGES(&S, pIMG, Batch, Count, pResult); //Call the Image Ndbs, Results in pResult[]
 		T = clock() - T;
 		
 		if (res > 1999) {
 			sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, res);
 			printf("\n\nERROR: Failed to load Ndb #%d from the database sub-directory: %s", res, ndbfile);
+			CloseSession(&S);
 			fclose(fh_write);
+			free(pResult);
 			free(pIMG);
 			return 1;
 		}
 
-		runtime = ((double)T) / CLOCKS_PER_SEC;
+		runtime = (((double)T) / CLOCKS_PER_SEC) / Count; //the average time per image
+		ViewsRun += S.ImageViewsRun;
 		
-		j = 0;
-		if (OUTcount == 0) {
-			printf("ERROR: NO RESULT!");
-			fprintf(fh_write, "\n;;%d, ERROR: NO RESULT!", RecNum);
-			fflush(fh_write);
-			errors++;
-			j = 1;
-		} else {
-			printf("recognized %c ", pOUT[1].Result[1].ON[0]);
-
-			if (pIMG[RecNum].image[0] != pOUT[1].Result[1].ON[0]) {
-				fprintf(fh_write, "\n;;%d, ERROR: recognized a %c instead of a %c",
-													RecNum,
-													pOUT[1].Result[1].ON[0],	//recognition result
-													pIMG[RecNum].image[0]);		//image 'label', i.e. the digit
-				fflush(fh_write);
+		for (RecNum = Batch; RecNum < (Batch + Count); RecNum++) {
+			printf("\nRecord %ld, image of %c: ", RecNum, pIMG[RecNum].digit);
+
+			digit = pResult[RecNum - Batch];
+			j = 0;
+			if (digit == 0) {
+				printf("ERROR: NO RESULT!");
+				fprintf(fh_write, "\n;;%ld, ERROR: NO RESULT!", RecNum);
 				errors++;
 				j = 1;
+			} else {
+				printf("recognized %c ", digit);
+
+				if (pIMG[RecNum].digit != digit) {
+					fprintf(fh_write, "\n;;%ld, ERROR: recognized a %c instead of a %c",
+														RecNum,
+														digit,					//recognition result
+														pIMG[RecNum].digit);	//image 'label', i.e. the digit
+					errors++;
+					j = 1;
+				}
 			}
+			printf(" (%fsec)", runtime);
+			if (j > 0) printf(" Errors = %d", errors);
 		}
-		printf(" (%fsec)", runtime);
-		if (j > 0) printf(" Errors = %d", errors);
+		fflush(fh_write); //the errors so far are saved after every batch
 	}
 	
 	TotalT = clock() - TotalT;
 	runtime = ((double)TotalT) / CLOCKS_PER_SEC;
 	printf("\nTotal runtime: %fsec", runtime);
 	printf("\nTotal Errors: %d", errors);
+	printf("\nImage Ndb's run per image: %.1f of %d (%.1f%%)", ViewsRun / NumberOfImages, IMAGE_VIEWS,
+								(100.0 * ViewsRun) / ((double)NumberOfImages * IMAGE_VIEWS));
+	if ((S.TierMargin > 0) && (S.FullVote == 0)) {
+		printf("\nCascade: margin %d, first tier ", S.TierMargin);
+		if (Tier1Count > 0) {
+			printf("%d Ndb's from %s", Tier1Count, ImageTiersFile);
+		} else {
+			printf("the full images");
+		}
+	}
+	if (S.ImageLookup > 0) {
+		printf("\nLookup: %ld exact, %ld near, %ld left to the full recognition",
+								S.Lookup.Exact, S.Lookup.Near, S.Lookup.Fallback);
+		if ((S.ImageLookup == 2) && (S.Lookup.Exact > 0)) {
+			printf("\n        exact matches gave the same digits %.2f%% of the time",
+								(100.0 * S.Lookup.ExactAgree) / S.Lookup.Exact);
+		}
+		if ((S.ImageLookup == 2) && (S.Lookup.Near > 0)) {
+			printf("\n        near matches gave the same digits %.2f%% of the time",
+								(100.0 * S.Lookup.NearAgree) / S.Lookup.Near);
+		}
+	}
  	printf("\n");
 
 	fprintf(fh_write, "\n\n$$$ End Of File - Total Errors: %d\n", errors);
+	CloseSession(&S);
 	fclose(fh_write);
+	free(pResult);
 	free(pIMG);
 	return 0;
 }
 
+int LearnImageTiers(void) {  // Rank the image Ndb's #2000+ on a sample of the MNIST Training Set
+	//
+	//	Run IMAGE_TIER_SAMPLE Training Set images, spread evenly over the set, on every one of
+	//	the 399 image Ndb's, and list the Ndb's in ImageTiersFile from the most images right
+	//	to the least. The first IMAGE_TIER1_VIEWS of them are the first tier of the cascade.
+	//
+	//	The Training Set is what the Ndb's were created from, so an image is only 'wrong'
+	//	when a view was too ambiguous to vote (IMAGE_AMBIGUITY_THRESHOLD) or voted for other
+	//	digits as well. That is exactly what makes a view a poor first tier.
+	//
+	//----------
+
+	FILE *fh_write;
+	MNISTimage *pIMG;	//MNIST images are loaded from the image store into this memory
+	MNISTimage *pSample;//...and the sample is copied to here: pSample[1] ... pSample[Count]
+	long IMGcount;
+	SESSIONdata S;
+	long Count;
+	long step;
+	long i;
+	int pN[IMAGE_VIEWS];	//Ndb #pN[i]...
+	long pRight[IMAGE_VIEWS];	//...got pRight[i] of the images right
+	int order[IMAGE_VIEWS];	//The Ndb's, most right first
+	int j, k, t;
+	int res;
+	double right1, right2;
+	char ndbfile[INQUIRY_LENGTH];
+
+	clock_t T;
+	double runtime;
+
+	long NumberOfImages = 60000;
+	char ImageSet[10] = "train"; //the MNIST Training Set
+
+	ShowProgress = 0;
+
+	pIMG = LoadMNIST(ImageSet, NumberOfImages, &IMGcount);
+	if (pIMG == NULL) return 1;
+
+	Count = IMAGE_TIER_SAMPLE;
+	if (Count > IMGcount) Count = IMGcount;
+	step = IMGcount / Count;
+
+	pSample = (MNISTimage *)malloc((Count + 1) * sizeof(MNISTimage));
+	if (pSample == NULL) {
+		printf("\nERROR: not enough memory for %ld images", Count);
+		free(pIMG);
+		return 1;
+	}
+	for (i = 1; i <= Count; i++) pSample[i] = pIMG[1 + ((i - 1) * step)];
+	free(pIMG);
+
+	printf("\nRunning %ld Training Set images (1 of every %ld) on all %d image Ndb's...", Count, step, IMAGE_VIEWS);
+	if (OpenSession(&S) != 0) {
+		free(pSample);
+		return 1;
+	}
+	T = clock();
+	res = mpRateImageViews(&S, pSample, Count, pN, pRight);
+	T = clock() - T;
+	CloseSession(&S);
+	free(pSample);
+
+	if (res > 1999) {
+		sprintf(ndbfile, "%s%d.ndb", SubDirectoryNdbs, res);
+		printf("\n\nERROR: Failed to load Ndb #%d from the database sub-directory: %s", res, ndbfile);
+		return 1;
+	}
+	runtime = ((double)T) / CLOCKS_PER_SEC;
+
+	//Order the Ndb's by the images they got right (insertion sort, ties stay in Ndb order)
+	for (j = 0; j < IMAGE_VIEWS; j++) {
+		t = j;
+		for (k = j; k > 0; k--) {
+			if (pRight[order[k - 1]] >= pRight[t]) break;
+			order[k] = order[k - 1];
+		}
+		order[k] = t;
+	}
+
+	fh_write = fopen(ImageTiersFile, "w");
+	if (fh_write == NULL) {
+		printf("\nERROR: Failed to OPEN file %s for writing.", ImageTiersFile);
+		return 1;
+	}
+	fprintf(fh_write, ";Neural Database data - image Ndb's by the MNIST Training Set images they got right\n");
+	fprintf(fh_write, ";%ld images, 1 of every %ld. The first tier of the cascade is the first %d Ndb's.\n",
+											Count, step, IMAGE_TIER1_VIEWS);
+	fprintf(fh_write, ";;Ndb, Tier, Images Right\n");
+
+	right1 = 0;
+	right2 = 0;
+	for (j = 0; j < IMAGE_VIEWS; j++) {
+		t = 2;
+		if (j < IMAGE_TIER1_VIEWS) t = 1;
+		fprintf(fh_write, "\n;;%d, %d, %ld", pN[order[j]], t, pRight[order[j]]);
+		if (t == 1) {
+			right1 += pRight[order[j]];
+		} else {
+			right2 += pRight[order[j]];
+		}
+	}
+	fprintf(fh_write, "\n\n$$$ End Of File\n");
+	fclose(fh_write);
+
+	printf("\nFirst tier: %d Ndb's, %.1f%% right", IMAGE_TIER1_VIEWS,
+								(100.0 * right1) / ((double)Count * IMAGE_TIER1_VIEWS));
+	printf("\nThe rest: %d Ndb's, %.1f%% right", IMAGE_VIEWS - IMAGE_TIER1_VIEWS,
+								(100.0 * right2) / ((double)Count * (IMAGE_VIEWS - IMAGE_TIER1_VIEWS)));
+	printf("\nSaved to %s (%fsec)", ImageTiersFile, runtime);
+	printf("\n");
+
+	Tier1Count = LoadImageTiers();
+	return 0;
+}
+
+int LoadImageTiers(void) {  // Load the first tier of the cascade from ImageTiersFile
+	//
+	//	Reads the ';;N, Tier, Right' lines written by LearnImageTiers() and puts each N of
+	//	tier 1 in ImageTier1[].
+	//
+	//	Returns the number of Ndb's in the first tier, 0 if there's no ImageTiersFile. The
+	//	cascade then uses the full 28x28 views as its first tier, see OrderImageTiers().
+	//
+	//----------
+
+	FILE *fh_read;
+	char line[FILE_LINE_LENGTH];
+	char *p;
+	int count;
+	long N;
+	long tier;
+
+	fh_read = fopen(ImageTiersFile, "r");
+	if (fh_read == NULL) {
+		printf("\nNo %s (Option 26), the first tier is the full 28x28 images", ImageTiersFile);
+		return 0;
+	}
+
+	count = 0;
+	while (fgets(line, FILE_LINE_LENGTH, fh_read) != NULL) {
+		//Ignore all lines except those that begin with ';;' followed by a number
+		if ((line[0] != ';') || (line[1] != ';')) continue;
+		N = strtol(&line[2], &p, 10);
+		if ((N < 2000) || (*p != ',')) continue;
+		tier = strtol(p + 1, &p, 10);
+		if ((tier == 1) && (count < IMAGE_VIEWS)) {
+			ImageTier1[count] = N;
+			count++;
+		}
+	}
+	fclose(fh_read);
+
+	if (count == 0) printf("\nNo first tier in %s, the first tier is the full 28x28 images", ImageTiersFile);
+
+	return count;
+}
+
+int RefreshImageStore(int Resident) {  // The image Ndb's have changed: bring the multi-view image store up to date
+	//
+	//	If the store was Resident, make it again from the new .ndb files. Otherwise just
+	//	delete the file, so Option 29 can't pick up the old image Ndb's from it.
+	//
+	//----------
+
+	char StoreFile[INQUIRY_LENGTH];
+
+	if (Resident > 0) return BuildImageStore();
+
+	sprintf(StoreFile, "%s%s", SubDirectoryNdbs, ImageStoreFile);
+	remove(StoreFile);
+	return 0;
+}
+
 void DisplayImage(MNISTimage *pIMG, long RecNum) {
 
 	char digit;
-	char ch;
-	char px[4]; //the pixel in characters: 0 to 255 with room for a terminating 0
-	int p, i;
+	int p;
 	int r, c;
 	int image[MAX_IMAGE_SIZE+1][MAX_IMAGE_SIZE+1];
 
 	int ImageSize = MAX_IMAGE_SIZE;
 
-	digit = pIMG[RecNum].image[0]; //The "label" assigned to this image: 0, 1, ..., 9
-	p = 2; //start reading the image string from here
+	digit = pIMG[RecNum].digit; //The "label" assigned to this image: 0, 1, ..., 9
+	p = 0;
 	for (r = 1; r <= ImageSize; r++) {
 		for (c = 1; c <= ImageSize; c++) {
-			ch = pIMG[RecNum].image[p];
-			for (i = 0; i <4; i++) px[i] = 0; //clear the pixel buffer
-			i = 0;
-			while ((ch != ',') && (ch != 0)) {
-				px[i] = ch;
-				i++;
-				p++;
-				ch = pIMG[RecNum].image[p];
-			}
-			image[r][c] = atoi(px);
+			image[r][c] = pIMG[RecNum].pixel[p];
 			p++;
 		}
 	}
@@ -1361,6 +1660,7 @@ void FreeMem(NdbData *Ndb) {
 	} else {
 		free(Ndb->pIRN);
 	}
+	FreeImageIndex(Ndb);
 }
 
 
@@ -5,12 +5,13 @@
 #include <time.h>
 #include <stdlib.h>	// memory allocation
 #include <string.h>	// string manipulation functionms
+#include <limits.h>	// INT_MAX
 #include <ctype.h>	// change character case lower/upper
 #include <direct.h>	// MakeDirectory function (_mkdir)
 #include <omp.h>	// Open MultiProcessing
 
 //If your system has more than this many threads available, change this value and recompile
-//OpenMP is used in mpCombineBound(), mpCreateImageNdbs(), and mpRecognizeIMAGE()
+//OpenMP is used in mpCombineBound(), mpCreateImageNdbs(), mpRecognizeIMAGE() and mpRecognizeIMAGES()
 #define MAX_THREADS 128
 
 
@@ -24,7 +25,20 @@
 //The longest image in mnist_test.txt is 2139 bytes
 #define IMAGE_LENGTH 2304 //2048 + 256
 #define MAX_IMAGE_SIZE 28	//square image 28x28
+#define MNIST_PIXELS 784	//28x28 pixels in an MNIST image
 #define NUMBER_OF_IMAGE_RNS 10 //image recognition using 10 RNs
+#define IMAGE_CONTRASTS 7 //the contrasts used by the 399 image databases: 2, 33, ... 200
+#define IMAGE_VIEWS 399 //views of an image, one Ndb each: #2000 - #2569
+#define IMAGE_BATCH 500 //images recognized together by mpRecognizeIMAGES(), each Ndb loaded a few times per batch
+#define IMAGE_BATCH_BLOCK 25 //images per task: one Ndb runs this many images of the batch in a row
+#define IMAGE_TIER_SAMPLE 1000 //Training Set images LearnImageTiers() runs on every image Ndb
+#define IMAGE_TIER1_VIEWS 21 //image Ndbs in the first tier of the cascade, as many as there are full 28x28 views
+#define IMAGE_LOOKUP_PARTS 2 //RL parts hashed by IndexImageONs(): finds the ONs within 1 position of an inquiry
+#define IMAGE_LOOKUP_CANDIDATES 256 //near matches checked by LookupImage() before it gives up
+#define IMAGE_NAME_LENGTH 24 //longest image ON name in the multi-view image store, e.g. Image^train^60000
+#define IMAGE_NAME_BLOCK 16384 //image names the store's name table grows by
+#define IMAGE_NAME_HASH 131072 //hash chains for the image names while the store is built, a power of 2
+#define IMAGE_LOOKUP_NEAR 0 //1: near matches answer inquiries too, 0: only exact matches (near ones often disagree with RecognizeINPUT())
 
 
 //Recognition Thresholds - these are used to reduce the number of SCU competitors
@@ -40,6 +54,13 @@
 #define PER_2_THRESHOLD 85 //If more than 1000 competitors
 #define PER_3_THRESHOLD 90 //If more than 3000 competitors
 
+//Culling starts (PER_1_THRESHOLD) when there are more than this many branches.
+//Below it, the branches are traced through a DAG of the ONs instead of all being built.
+#define BRANCH_CULL_COUNT 500
+
+//ExpandBoundaries() checks the ONs in parallel when there are at least this many
+#define EXPAND_MP_COUNT 64
+
 //If an enveloping ON has a %recognition exceeding this value, it can remove the enveloped ON
 #define ENVELOPMENT_THRESHOLD 75
 
@@ -54,6 +75,10 @@
 //In starting a branch, an Unused ON must have a %recognition exceeding this value
 #define UNUSED_THRESHOLD 75
 
+//Composite Scores are fixed-point integers: C = (pr*pr*ln*ln/qu)/10^(Ais+Arn) in units of 1/C_UNIT.
+//The exact parts are kept as well so CompareC() can order any two scores without rounding.
+#define C_UNIT 1000000000000LL
+
 //It's possible for part of the image of a digit (a 'panel') to recognize multiple digits, especially
 //a 'blank' corner panel. Many different images have blank corner panels. These multiple possibilities
 //are stored in the database as the ON's Surrogate. To contribute to the final interpretation of the
@@ -87,6 +112,7 @@
 #define NC_RECORDS 1024
 #define	R_RECORDS 500
 #define	IMAGE_RN_RECORDS 100
+#define	IMAGE_RN_HASH 256 //Initial slots in an image Ndb's RN hash table, doubled when it's half full
 
 //These initial 'high' values for records-per-memory-block were selected to
 //avoid calls to realloc() while running long text queries from the Test
@@ -98,6 +124,61 @@
 #define	E_RECORDS 4000
 
 
+//SCU spike train switches as bits in SCUmask. Compete() runs the kernel compiled for the
+//bits that are ON, picked from a dispatch table by SelectSCUkernel() whenever they change.
+#define SCU_SPACEB 1
+#define SCU_ANOMALY 2
+#define SCU_REC 4
+#define SCU_MINPR 8
+#define SCU_BOUND 16
+#define SCU_UNCOUNT 32
+#define SCU_MISLEAD 64
+#define SCU_KERNELS 128 //every combination of the 7 switches
+
+//Stages of a recognition that are timed and counted (NdbStats.c)
+#define STAGE_BOUNDSECTIONS 0	//GetBoundSections(): BLcount
+#define STAGE_COMBINE 1			//mpCombineBoundSections(): total of mpCcount[]
+#define STAGE_HIT 2				//mpRunHitThreshold(): Dcount
+#define STAGE_ANOMALY 3			//RunAnomalyThreshold(): Ecount
+#define STAGE_LOADONS 4			//LoadONs(): Rcount
+#define STAGE_ENVELOP 5			//RemoveEnvelopments(): Rcount
+#define STAGE_RETRACTANOMALOUS 6	//RetractAnomalousBoundaries(): Rcount
+#define STAGE_RETRACTWEAK 7		//RetractWeakBoundaries(): Rcount
+#define STAGE_EXPAND 8			//ExpandBoundaries(): Rcount
+#define STAGE_WEAKONS 9			//RemoveWeakONs(): Rcount
+#define STAGE_ANOMALYCOUNTS 10	//GetAnomalyCounts(): Rcount
+#define STAGE_BRANCHES 11		//MakeBranches(): BRHcount
+#define STAGE_COMPETE 12		//CompeteBranches(): SCU matches played
+#define STAGE_COUNT 13
+
+typedef struct { //Time and counts for one stage of a recognition
+	long Calls;
+	long long Count;	//Records the stage finished with, see STAGE_...
+	double Wall;		//Elapsed time (sec)
+	double CPU;			//Processor time (sec) - all the threads added together
+	double Wstart;		//When the stage started
+	clock_t Cstart;
+} STAGEdata;
+
+typedef struct { //The path of one ON through a recognition, kept in Explain mode (NdbStats.c)
+	long ONcode;
+	int BL;			//Initial Bound Sections in pBL[]
+	int Combined;	//Combined Bound Sections made for it by mpCombineBound1/2 in mpC[]
+	int Hit;		//Bound Sections that survived the HIT_THRESHOLD in pD[]
+	int Anomaly;	//...and the ANOMALY_THRESHOLD in pE[]
+	int Loaded;		//Records loaded into pR[] by LoadONs()
+	int Rescanned;	//Rescans of its pR[] records with new boundaries, kept or not
+	int Left;		//pR[] records left for the branches after RemoveWeakONs()
+	int Branches;	//Branches it joined
+	int Competed;	//Tournament competitors it was part of
+	int Matches;	//SCU matches played by those competitors
+	int Won;		//Results it is part of
+	double Combine;	//Time (sec) spent combining its Bound Sections
+	double Threshold;	//...running its Bound Sections through the HIT_THRESHOLD
+	double Scan;	//...scanning its pR[] records in LoadR()/ReloadR()
+	double SCU;		//...in the SCU matches it played
+} EXPLAINdata;
+
 typedef struct { //SCU spike train On/Off switches
 	int SpaceB;
 	int Anomaly;
@@ -134,6 +215,55 @@ typedef struct { //The connection from an RN to its position in the ON's Recogni
 	long ONcode;
 } NdbRNtoON;
 
+typedef struct { //Direct lookup of the ONs of an IMAGE_28X28 Ndb by their RLs (NdbImageLookup.c)
+	long Size;		//Slots in each hash table, a power of 2
+	long *pHead[IMAGE_LOOKUP_PARTS+1];	//[0]: the whole RL, [1]...: each part. First ONcode in each slot, 0 = empty...
+	long *pNext[IMAGE_LOOKUP_PARTS+1];	//...and the next ONcode in the same slot
+} ImageIndex;
+
+typedef struct { //Image inquiries answered by LookupImage() since the session began
+	long Exact;		//Exact matches...
+	long ExactAgree;//...that gave the same digits as RecognizeINPUT() (ImageLookup = 2)
+	long Near;		//Near matches...
+	long NearAgree;
+	long Fallback;	//Left to RecognizeINPUT()
+} LOOKUPstats;
+
+typedef struct { //An image name shared by all the views in the multi-view image store (NdbImageViews.c)
+	char Name[IMAGE_NAME_LENGTH];	//The ON, e.g. Image^train^1
+	char Label;		//The image's digit
+} ImageName;
+
+typedef struct { //An ON of one view in the multi-view image store
+	int Name;		//Its name: ImageName[Name]
+	unsigned short RL[NUMBER_OF_IMAGE_RNS];	//Its Recognition List of RNcodes
+	char SUR[11];	//Its Surrogate: the digits of all the images with this RL
+} ImageViewON;
+
+typedef struct { //One image Ndb in the multi-view image store
+	int ID;			//N
+	int RNcount;
+	long ONcount;
+	int *pRN;		//RN values: pRN[1] ... pRN[RNcount]
+	ImageViewON *pON;	//pON[1] ... pON[ONcount]
+} ImageView;
+
+typedef struct { //The multi-view image store: the image Ndbs sharing one table of image names
+	int Views;
+	long Names;
+	ImageName *pName;	//pName[0] ... pName[Names-1]
+	ImageView *pView;	//pView[0] ... pView[Views-1]
+} ImageStore;
+
+typedef struct { //The header of the multi-view image store file, followed by the names, then the views
+	char Magic[8];	//"NDBVIEWS"
+	int Version;
+	int Views;
+	long Names;
+	int NameRecord;	//sizeof(ImageName)
+	int ONrecord;	//sizeof(ImageViewON)
+} ImageStoreHead;
+
 typedef struct {		//The memory-resident Neural Database (Ndb)
 	int ID;				//The number N assigned to this database
 	int RNcount;
@@ -145,6 +275,7 @@ typedef struct {		//The memory-resident Neural Database (Ndb)
 	long ConnectCount;
 	NdbRNtoON *pRNtoON;	//Memory assigned to RN-->ON connections
 	char Type[20];		//"TEXT" or "CENTRAL" or "IMAGE_28X28"
+	ImageIndex *pIndex;	//IMAGE_28X28: the ONs by their RLs, NULL until IndexImageONs()
 } NdbData;
 
 
@@ -238,7 +369,12 @@ typedef struct { //Initial Results array constructed from E[]
 	int qpos[INQUIRY_LENGTH+1]; //positions 'hit' in the Input Stream
 	int rn[INQUIRY_LENGTH+1]; //the RNs in order of being 'hit'
 	int dpos[INQUIRY_LENGTH+1]; //positions 'hit' in the ON's Recognition List
-	float C; //Composite Score
+	int Perfect; //Stand-Alone Score of a perfect copy of the ON, for PER
+	int Scan[INQUIRY_LENGTH+1]; //Stand-Alone Score after scanning B...qpos, to rescore from (ReloadR)
+	long long C; //Composite Score in units of 1/C_UNIT
+	int Cn; //Composite Score = Cn / (10000 * Cq * 10^Cexp), Cn = PER*PER*ln*ln
+	int Cq; //QUAL + 1
+	int Cexp; //Ais + Arn
 	int InBranch; //0: not in a branch, 1: in some branch (can be in more than one)
 }Rdata;
 
@@ -252,21 +388,27 @@ typedef struct { //Thread data for multiprocessing image databases
 	int cb;
 	int ce;
 	char Type; //R, C, or D (Row, Column, or Diagonal view)
+	int View; //The inquiry image at this Contrast: ImageViews[View]
 	char Results[TOTAL_ALLOWED_RESULTS+1][11]; //A blank 'view' can potentially recognize all 10 digits!
 } ImageMP;
 
 typedef struct { //Row,Column locations tracing a boundary around an image
-	int point[196][196]; //196 is probably more than enough for a 28x28 MNIST image
+	unsigned int point[MAX_IMAGE_SIZE+2]; //bit c of point[r] is set once r,c is on the trace, like NDBimage.Nbits
 } ImageBoundary;
 
-typedef struct { //In-memory copy of the images from mnist_train.txt
-	//Each MNIST image is a long string of text:
-	//		The 1st character identifies the digit (a.k.a. "the label"): 0, 1, ..., 9
-	//		The 2nd chatacter is a comma
-	//		The rest of the string is 784 pixel values: 0 - 255, separated by commas
-	char image[IMAGE_LENGTH+1];
+typedef struct { //An MNIST image, in memory and in the binary image store (NdbImageStore.c)
+	char digit;		//The "label": '0', '1', ..., '9'
+	unsigned char pixel[MNIST_PIXELS];	//Pixel values 0 - 255, row by row
 } MNISTimage;
 
+typedef struct { //The header of a binary image store, followed by Count MNISTimage records
+	char Magic[8];	//"NDBMNIST"
+	int Version;
+	int Count;		//Number of images
+	int Size;		//MAX_IMAGE_SIZE: the images are Size x Size pixels
+	int Record;		//sizeof(MNISTimage)
+} MNISTstore;
+
 typedef struct { //A transformed MNIST image: 784 pixel string --> square array
 	// The numeric pixels have been replaced by:
 	//		" " = zero
@@ -274,8 +416,27 @@ typedef struct { //A transformed MNIST image: 784 pixel string --> square array
 	//		"+" = zero in a space fully enclosed by "n"s.
 	char image[MAX_IMAGE_SIZE+1][MAX_IMAGE_SIZE+1];
 	int ImageSize; //28x28, or 18x18, or 16x16
+	//The same image as bitboards, one row mask per row: bit c of Nbits[r] is set if
+	//image[r][c] is an "n", and of Pbits[r] if it's a "+". Rows 0 and ImageSize+1 are zero.
+	unsigned int Nbits[MAX_IMAGE_SIZE+2];
+	unsigned int Pbits[MAX_IMAGE_SIZE+2];
 } NDBimage;
 
+typedef struct { //The inquiry image at one contrast, in all 3 perspectives
+	int Contrast;
+	int Bad;		//1: GetImage() would return 1 (bad image) at this contrast
+	NDBimage ROW;
+	NDBimage COL;
+	NDBimage DIAG;
+} ImageViews;
+
+typedef struct { //Feature matrix: the Recognition List of every view of every training image
+	long Images;		//Number of images, RecNum 1 - Images
+	int Views;			//Number of views: all the Ndbs being built at one contrast
+	int N[IMAGE_VIEWS];	//NdbID of each view
+	short *pRN;			//Images x Views x NUMBER_OF_IMAGE_RNS: see ExtractImageFeatures()
+} ImageFeatures;
+
 typedef struct { //Each image processing thread has this memory for its own Ndb and image RN values
 	long RecNum;
 	char digit;
@@ -286,6 +447,13 @@ typedef struct { //Each image processing thread has this memory for its own Ndb
 	long ConnectCount;	//Total number of RN-ON connections
 	NdbON *pON;			//Memory assigned to ONs
 	NdbRNtoON *pRNtoON;	//Memory assigned to RN-ON connections
+	int RNhashSize;		//Hash table of RNcodes by RN value, open addressing: see ImageRNcode()
+	int *pRNhash;		//0 = empty slot
+	long ONhashSize;	//Hash chains of ONs by image name and by Recognition List: see HashImageONs()
+	long *pNameHash;	//ON index + 1 of the first ON in each chain, 0 = empty chain
+	long *pNameNext;	//ON index + 1 of the next ON in the same chain
+	long *pListHash;
+	long *pListNext;
 	int RWTB;			//Image Weight: Top heavy or Bottom heavy
 	int RWRL;			//Image Weight: Right or Left heavy
 	int LL;				//Where are the Longest Line: row, column, diagonal?
@@ -308,7 +476,7 @@ typedef struct {	//Head of a linked list of a branch generated from the ON recor
 	int First;		//Index in BRdata[] of the beginning ON in the branch
 	int Last;		//Index of the ON at the current end of the branch
 	int Tlength;	//Total branch length
-	float TCscore;	//Total of all the Composite Scores of all the ONs in the branch
+	long long TCscore;	//Total of all the Composite Scores of all the ONs in the branch
 	int Deleted;	//Weak branches can be deleted at any time during the assembly of the branches
 } BRHdata; 
 
@@ -319,6 +487,17 @@ typedef struct {	//List of the competing Branches and their competition data fro
 	int NCcount;	//NoCompete count
 	int NCblocks;	//NoCompete blocks
 	int *pNC;		//NoCompete List: Branches this branch has already competed with
+
+	//Stand-Alone competition data, used to bound a match's SCU scores before running it
+	int B;			//Lowest Begin Boundary in the branch
+	int E;			//Highest End Boundary in the branch
+	int Score;		//Stand-Alone Score
+	int anomaly;
+	int rec;
+	int minpr;
+	int bound;
+	int uncount;	//RNs unaccounted for inside B...E
+	int mislead;
 } Tdata;
 
 typedef struct {	//The ON(s) making up a tournament-winning branch
@@ -370,11 +549,40 @@ typedef struct {	//Recognition data for this inquiry
 	int Tcount;
 	int Tblocks;
 	Tdata *pT;		//Memory for the Tournament of Branches
+	int Matches;	//SCU matches played in the tournament
+	int Pruned;		//Matches decided by the score bounds, without running the SCU
 
 	int Rcount;
 	int Rblocks;
 	Rdata *pR;		//Memory for Competition results
 
+	//Index of pR[] by Begin Boundary, kept current as the boundaries change
+	int IXhead[INQUIRY_LENGTH+2];	//First record with Begin Boundary b, or 0
+	int *pIXnext;	//Next record with the same Begin Boundary, in pR[] order
+	int IXsize;		//Number of entries allotted to pIXnext[]
+	int IXspan;		//Longest E - B in pR[] (an upper limit)
+
+	//The switches of the session this inquiry belongs to (SESSIONdata)
+	int ShowProgress;
+	int SCUmask;	//Selects the Compete() kernel
+	int StageStats;
+
+	//Beam mode: only the best Beam branches of each round are built further (0: all of them)
+	int Beam;
+	int BeamPruned;	//Branches the beam dropped
+	int BeamLost;	//...of which some could still have become a branch CompeteBranches() picks
+	unsigned long long *pBeamLens;		//Branch lengths possible from each ON, from TraceBranches()
+	unsigned long long BeamTarget[2];	//The branch lengths CompeteBranches() would pick
+
+	//Time and counts for each stage of the recognition, kept when Timing = 1 (NdbStats.c)
+	int Timing;
+	STAGEdata Stage[STAGE_COUNT];
+
+	//Explain mode: the path of each ON through the recognition, in ONcode order (NdbStats.c)
+	int Explain;
+	int Xcount;
+	EXPLAINdata *pX;
+
 	int RESULTcount; //Total number of results to the inquiry, e.g. "NS" -> "TONS", "LENS", ...
 	RESULT pRES[TOTAL_ALLOWED_RESULTS+1]; //Room for the branches of winners
 
@@ -388,15 +596,72 @@ typedef struct {	//Array of output results
 	ONresult Result[INQUIRY_LENGTH+1];
 } OUTPUT;
 
+typedef struct {	//A recognition session: everything one caller's inquiries change (NdbRecognize.c)
+	//Each caller opens its own session with OpenSession(), so any number of them can make
+	//inquiries at the same time, sharing the same NdbData. The Ndb's are only read, except
+	//for the image index LookupImage() builds the first time it's needed.
+
+	//The switches, copied from the Menu's global settings when the session is opened
+	int ShowProgress;
+	int SCUmask;
+	int Beam;		//BeamWidth
+	int Explain;	//ExplainMode
+	int StageStats;
+	int FullVote;
+	int TierMargin;
+	int ImageLookup;
+
+	//The results of the last inquiry
+	int OUTcount;	//Number of results in pOUT[]
+	OUTPUT *pOUT;	//pOUT[1] ... pOUT[OUTcount]
+
+	//Counts, added up since the session was opened (the caller may reset them)
+	long Matches;		//SCU matches played by RecognizeTEXT()
+	long Pruned;		//SCU matches skipped because the score bounds already decided them
+	long BeamPruned;	//Branches dropped by the beam...
+	long BeamLost;		//...of which some could still have been picked to compete
+	long ImageViewsRun;	//Image Ndbs run by the last mpRecognizeIMAGE() or mpRecognizeIMAGES()
+	LOOKUPstats Lookup;	//Image inquiries answered by LookupImage()
+
+	//The stages of every inquiry RecognizeTEXT() has reported since StageTotalsClear()
+	STAGEdata StageTotal[STAGE_COUNT];
+	long StageInquiries;
+	long StageMatches;
+	long StagePruned;
+
+	//RecognizeTEXT()'s memory for pR[], pBRH[], pBR[], pT[] and pIXnext[], kept from one
+	//inquiry to the next, at whatever size the largest inquiry so far needed
+	int Rblocks;
+	Rdata *pR;
+	int BRHblocks;
+	BRHdata *pBRH;
+	int BRblocks;
+	BRdata *pBR;
+	int Tblocks;
+	Tdata *pT;
+	int IXsize;
+	int *pIXnext;
+} SESSIONdata;
+
 
 
 // Global Functions:
-extern int RecognizeTEXT(NdbData *, char *);
-extern int mpRecognizeIMAGE(long, char *);
+extern int OpenSession(SESSIONdata *);
+extern void CloseSession(SESSIONdata *);
+extern int RecognizeTEXT(NdbData *, SESSIONdata *, char *);
+extern int mpRecognizeIMAGE(SESSIONdata *, long, unsigned char *);
+extern int mpRecognizeIMAGES(SESSIONdata *, MNISTimage *, long, long, char *);
+extern int mpRateImageViews(SESSIONdata *, MNISTimage *, long, int *, long *);
 extern int RunSCU(NdbData *, RECdata *, COMP *, COMP *);
+extern int SetScore(NdbData *, RECdata *, COMP *, int);
+extern void StandAlone(NdbData *, RECdata *, COMP *, Tdata *);
+extern int BoundMatch(RECdata *, Tdata *, Tdata *, COMP *, COMP *);
+extern void SelectSCUkernel(void);
 
 extern int GetONs(NdbData *, RECdata *);
 extern void LoadR(NdbData *, RECdata *, int, int, int, int);
+extern void ReloadR(NdbData *, RECdata *, int, int, int);
+extern int CompareC(Rdata *, Rdata *);
 extern int ExecuteActions(char *);
 
 extern int CreateNdb(int, char *);
@@ -405,8 +670,33 @@ extern int CreateQuestionNdb(int, char *);
 extern int mpCreateImageNdbs();
 extern int AddImages();
 
-extern int GetImage(char *, int, NDBimage *, NDBimage *, NDBimage *);
+extern int GetImage(unsigned char *, int, NDBimage *, NDBimage *, NDBimage *);
+extern void GetImageViews(unsigned char *, int, ImageViews *);
+extern unsigned int HashImageName(char *);
+extern MNISTimage *LoadMNIST(char *, long, long *);
 extern void ImageFormatter(ImageData *, NDBimage *, int *);
+extern int IndexImageONs(NdbData *);
+extern void FreeImageIndex(NdbData *);
+extern int LookupImage(NdbData *, int *, long *, int *);
+extern int BuildImageStore(void);
+extern int LoadImageStore(void);
+extern int FindImageView(int);
+extern int LoadImageView(NdbData *, int);
+extern void FreeImageStore(ImageStore *);
+extern void mpLoadImageTasks(int *, ImageMP *);
+extern void GetPanelBits(NDBimage *, int, int, NDBimage *);
+
+extern void StageClear(RECdata *);
+extern void StageBegin(RECdata *, int);
+extern void StageEnd(RECdata *, int, long long);
+extern void StageReport(NdbData *, RECdata *, SESSIONdata *, char *);
+extern void StageTotalsClear(SESSIONdata *);
+extern void StageTotalsReport(SESSIONdata *, int);
+extern void ExplainStage(RECdata *, int);
+extern EXPLAINdata *ExplainON(RECdata *, long);
+extern void ExplainScan(RECdata *, long, int, double);
+extern void ExplainMatch(RECdata *, int, int, double);
+extern void ExplainReport(NdbData *, RECdata *, char *);
 
 extern int LoadNdb(NdbData *);
 extern void FreeMem(NdbData *); //release memory allocated for the Ndb
@@ -418,6 +708,18 @@ extern char SubDirectoryNdbs[];	//Subdirectory where neural databases are stored
 extern char MNISTerrors[];		//File listing the MNIST Test records that failed recognition
 extern int ShowProgress;		//Used to display processing events
 extern SCUswitches SCUswitch;	//Used to turn SCU agents On/Off
-
-extern OUTPUT pOUT[];			//Results of an inquiry
-extern int OUTcount;			//Number of results in pOUT
+extern int SCUmask;				//SCUswitch as bits, selects the Compete() kernel
+
+extern int BeamWidth;			//Branches kept by each round of BuildBranches(), 0: all of them
+extern int StageStats;			//Stage data to StageStatsFile: 0 none, 1 totals per Ndb, 2 every inquiry too
+extern char StageStatsFile[];	//JSON, one object per line
+extern int ExplainMode;			//1: write the path of every ON in each RecognizeTEXT() to ExplainFile
+extern char ExplainFile[];		//JSON, one object per inquiry
+extern int FullVote;			//1: every image Ndb votes on every image, even after the winner is decided
+extern int TierMargin;			//Cascade: 0 OFF, or the lead in first tier votes that decides an image
+extern int Tier1Count;			//Image Ndbs in ImageTier1[], 0: the first tier is the full 28x28 views
+extern int ImageTier1[];		//N of each image Ndb in the first tier
+extern char ImageTiersFile[];	//The image Ndbs by tier, from LearnImageTiers()
+extern int ImageLookup;			//Image Ndbs: 0 RecognizeINPUT() only, 1 LookupImage() first, 2 both, to compare
+extern ImageStore ViewStore;	//The resident multi-view image store, Views = 0: none
+extern char ImageStoreFile[];	//The multi-view image store, in SubDirectoryNdbs